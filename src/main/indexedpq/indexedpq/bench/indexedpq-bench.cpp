@@ -0,0 +1,553 @@
+/*********************************************************************************
+  *FileName:       indexedpq-bench.cpp
+  *Description:    standalone microbenchmark of IndexedPriorityQueue against std::priority_queue and std::set baselines,
+  *                of HierarchicalTimerWheel against the plain IndexedPriorityQueue of deadlines, of HeavyHitters on
+  *                Zipf streams, and of StaticIndexedPriorityQueue for tiny TopN queries.
+  *                Every case runs warmup rounds and timed repetitions, and reports ns/op as JSON, e.g.
+  *                    indexedpq_bench --sizes=1000,1000000 --dists=uniform,dups --reps=5 --warmup=1 --out=bench.json
+**********************************************************************************/
+#include "indexedpq/indexed-priority-queue.h"
+#include "indexedpq/dedup-topn.h"
+#include "indexedpq/heavy-hitters.h"
+#include "indexedpq/hierarchical-timer-wheel.h"
+#include "indexedpq/static-indexed-priority-queue.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <queue>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+/// options from command line
+struct BenchOptions {
+    vector<size_t>      m_sizes{1000, 100000, 1000000};
+    vector<string>      m_dists{"uniform", "ascending", "descending", "dups"};
+    size_t              m_reps = 5;
+    size_t              m_warmup = 1;
+    size_t              m_topN = 1000;
+    string              m_filter;           /// only run cases whose "impl/op" contains it
+    string              m_outPath;          /// stdout if empty
+};
+
+/// one measured case
+struct BenchResult {
+    string              m_impl;
+    string              m_op;
+    string              m_dist;
+    size_t              m_size;
+    size_t              m_opCount;
+    vector<double>      m_nsPerOps;         /// one per repetition
+};
+
+/// element of TopN dedup case, the higher score ranks first
+struct DedupItem {
+    uint64_t    m_key;
+    uint64_t    m_score;
+};
+struct DedupItemComparator {
+    bool operator()(const DedupItem& a, const DedupItem& b) const {
+        return a.m_score > b.m_score || (a.m_score == b.m_score && a.m_key < b.m_key);
+    }
+};
+struct DedupItemKey {
+    uint64_t operator()(const DedupItem& item) const { return item.m_key; }
+};
+
+/// defeats dead code elimination of benchmarked results
+volatile uint64_t sSink = 0;
+
+typedef chrono::steady_clock CLOCK;
+
+inline int64_t ElapsedNs(CLOCK::time_point begin) {
+    return chrono::duration_cast<chrono::nanoseconds>(CLOCK::now() - begin).count();
+}
+
+void GenKeys(const string& dist, size_t size, uint64_t seed, vector<uint64_t>& keys) {
+    mt19937_64 rng(seed);
+    keys.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+        if (dist == "ascending") { keys[i] = i; }
+        else if (dist == "descending") { keys[i] = size - i; }
+        else if (dist == "dups") { keys[i] = rng() % 64; }
+        else { keys[i] = rng(); }
+    }
+}
+
+/// a case fills keys in untimed setup, then returns nanoseconds of its timed part and the number of timed ops
+typedef function<int64_t(const vector<uint64_t>& keys, const vector<uint64_t>& newKeys, size_t& opCount)> CASE_FUNC;
+
+int64_t IpqPush(const vector<uint64_t>& keys, const vector<uint64_t>&, size_t& opCount) {
+    IndexedPriorityQueue<uint64_t> pq(keys.size());
+    CLOCK::time_point begin = CLOCK::now();
+    for (size_t i = 0; i < keys.size(); ++i) { pq.Push(keys[i]); }
+    int64_t ns = ElapsedNs(begin);
+    sSink += pq.TopElem();
+    opCount = keys.size();
+    return ns;
+}
+int64_t IpqPop(const vector<uint64_t>& keys, const vector<uint64_t>&, size_t& opCount) {
+    IndexedPriorityQueue<uint64_t> pq(keys.begin(), keys.end());
+    CLOCK::time_point begin = CLOCK::now();
+    uint64_t sum = 0;
+    while (!pq.IsEmpty()) { sum += pq.Pop(); }
+    int64_t ns = ElapsedNs(begin);
+    sSink += sum;
+    opCount = keys.size();
+    return ns;
+}
+int64_t IpqUpdate(const vector<uint64_t>& keys, const vector<uint64_t>& newKeys, size_t& opCount) {
+    IndexedPriorityQueue<uint64_t> pq(keys.size());
+    vector<size_t> hts(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) { hts[i] = pq.Push(keys[i]); }
+    CLOCK::time_point begin = CLOCK::now();
+    for (size_t i = 0; i < newKeys.size(); ++i) { pq.Update(hts[newKeys[i] % hts.size()], newKeys[i]); }
+    int64_t ns = ElapsedNs(begin);
+    sSink += pq.TopElem();
+    opCount = newKeys.size();
+    return ns;
+}
+int64_t IpqReplaceTop(const vector<uint64_t>& keys, const vector<uint64_t>& newKeys, size_t& opCount) {
+    IndexedPriorityQueue<uint64_t> pq(keys.begin(), keys.end());
+    CLOCK::time_point begin = CLOCK::now();
+    for (size_t i = 0; i < newKeys.size(); ++i) { pq.ReplaceTopElem(newKeys[i]); }
+    int64_t ns = ElapsedNs(begin);
+    sSink += pq.TopElem();
+    opCount = newKeys.size();
+    return ns;
+}
+
+int64_t StdPqPush(const vector<uint64_t>& keys, const vector<uint64_t>&, size_t& opCount) {
+    vector<uint64_t> storage;
+    storage.reserve(keys.size());
+    priority_queue<uint64_t> pq(less<uint64_t>(), std::move(storage));
+    CLOCK::time_point begin = CLOCK::now();
+    for (size_t i = 0; i < keys.size(); ++i) { pq.push(keys[i]); }
+    int64_t ns = ElapsedNs(begin);
+    sSink += pq.top();
+    opCount = keys.size();
+    return ns;
+}
+int64_t StdPqPop(const vector<uint64_t>& keys, const vector<uint64_t>&, size_t& opCount) {
+    priority_queue<uint64_t> pq(keys.begin(), keys.end());
+    CLOCK::time_point begin = CLOCK::now();
+    uint64_t sum = 0;
+    while (!pq.empty()) { sum += pq.top(); pq.pop(); }
+    int64_t ns = ElapsedNs(begin);
+    sSink += sum;
+    opCount = keys.size();
+    return ns;
+}
+/// std::priority_queue has no replace-top, pop and push is the usual substitute
+int64_t StdPqReplaceTop(const vector<uint64_t>& keys, const vector<uint64_t>& newKeys, size_t& opCount) {
+    priority_queue<uint64_t> pq(keys.begin(), keys.end());
+    CLOCK::time_point begin = CLOCK::now();
+    for (size_t i = 0; i < newKeys.size(); ++i) { pq.pop(); pq.push(newKeys[i]); }
+    int64_t ns = ElapsedNs(begin);
+    sSink += pq.top();
+    opCount = newKeys.size();
+    return ns;
+}
+
+int64_t SetPush(const vector<uint64_t>& keys, const vector<uint64_t>&, size_t& opCount) {
+    multiset<uint64_t> s;
+    CLOCK::time_point begin = CLOCK::now();
+    for (size_t i = 0; i < keys.size(); ++i) { s.insert(keys[i]); }
+    int64_t ns = ElapsedNs(begin);
+    sSink += *s.rbegin();
+    opCount = keys.size();
+    return ns;
+}
+int64_t SetPop(const vector<uint64_t>& keys, const vector<uint64_t>&, size_t& opCount) {
+    multiset<uint64_t> s(keys.begin(), keys.end());
+    CLOCK::time_point begin = CLOCK::now();
+    uint64_t sum = 0;
+    while (!s.empty()) {
+        auto it = std::prev(s.end());
+        sum += *it;
+        s.erase(it);
+    }
+    int64_t ns = ElapsedNs(begin);
+    sSink += sum;
+    opCount = keys.size();
+    return ns;
+}
+/// iterators play the role of handles, update is erase and insert
+int64_t SetUpdate(const vector<uint64_t>& keys, const vector<uint64_t>& newKeys, size_t& opCount) {
+    multiset<uint64_t> s;
+    vector<multiset<uint64_t>::iterator> its(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) { its[i] = s.insert(keys[i]); }
+    CLOCK::time_point begin = CLOCK::now();
+    for (size_t i = 0; i < newKeys.size(); ++i) {
+        size_t idx = newKeys[i] % its.size();
+        s.erase(its[idx]);
+        its[idx] = s.insert(newKeys[i]);
+    }
+    int64_t ns = ElapsedNs(begin);
+    sSink += *s.rbegin();
+    opCount = newKeys.size();
+    return ns;
+}
+int64_t SetReplaceTop(const vector<uint64_t>& keys, const vector<uint64_t>& newKeys, size_t& opCount) {
+    multiset<uint64_t> s(keys.begin(), keys.end());
+    CLOCK::time_point begin = CLOCK::now();
+    for (size_t i = 0; i < newKeys.size(); ++i) {
+        s.erase(std::prev(s.end()));
+        s.insert(newKeys[i]);
+    }
+    int64_t ns = ElapsedNs(begin);
+    sSink += *s.rbegin();
+    opCount = newKeys.size();
+    return ns;
+}
+
+/// items of dedup case, one key per 5 items on average
+void GenDedupItems(const vector<uint64_t>& keys, const vector<uint64_t>& newKeys, vector<DedupItem>& items) {
+    items.resize(keys.size());
+    size_t keyCount = std::max<size_t>(keys.size() / 5, 1);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        items[i].m_key = newKeys[i] % keyCount;
+        items[i].m_score = keys[i];
+    }
+}
+
+int64_t IpqDedupTopN(size_t topN, const vector<uint64_t>& keys, const vector<uint64_t>& newKeys, size_t& opCount) {
+    vector<DedupItem> items;
+    GenDedupItems(keys, newKeys, items);
+    DedupTopN<DedupItem, DedupItemKey, DedupItemComparator> topNItems(topN);
+    CLOCK::time_point begin = CLOCK::now();
+    for (size_t i = 0; i < items.size(); ++i) { topNItems.Push(items[i]); }
+    int64_t ns = ElapsedNs(begin);
+    sSink += topNItems.GetCount();
+    opCount = items.size();
+    return ns;
+}
+/// the usual baseline: ordered set of kept items, and hash map from key to its item in set
+int64_t SetDedupTopN(size_t topN, const vector<uint64_t>& keys, const vector<uint64_t>& newKeys, size_t& opCount) {
+    vector<DedupItem> items;
+    GenDedupItems(keys, newKeys, items);
+    DedupItemComparator itemCmp;
+    set<DedupItem, DedupItemComparator> kept;
+    unordered_map<uint64_t, set<DedupItem, DedupItemComparator>::iterator> key2It;
+    CLOCK::time_point begin = CLOCK::now();
+    for (size_t i = 0; i < items.size(); ++i) {
+        const DedupItem& item = items[i];
+        auto mapIt = key2It.find(item.m_key);
+        if (mapIt != key2It.end()) {
+            if (itemCmp(item, *mapIt->second)) {
+                kept.erase(mapIt->second);
+                mapIt->second = kept.insert(item).first;
+            }
+            continue;
+        }
+        if (kept.size() >= topN) {
+            auto worstIt = std::prev(kept.end());
+            if (!itemCmp(item, *worstIt)) {
+                continue;
+            }
+            key2It.erase(worstIt->m_key);
+            kept.erase(worstIt);
+        }
+        key2It[item.m_key] = kept.insert(item).first;
+    }
+    int64_t ns = ElapsedNs(begin);
+    sSink += kept.size();
+    opCount = items.size();
+    return ns;
+}
+
+/// timer service: every op reschedules a live timer to now + timeout, time advances one tick every 16 ops and
+/// expired timers are scheduled again, so the count of live timers stays at *keys.size()*
+const uint64_t TIMER_TIMEOUT = 30000;
+const size_t TIMER_OPS_PER_TICK = 16;
+int64_t TimerWheelTimers(const vector<uint64_t>& keys, const vector<uint64_t>& newKeys, size_t& opCount) {
+    typedef HierarchicalTimerWheel<size_t> WHEEL_TYPE;
+    WHEEL_TYPE wheel(0, keys.size());
+    vector<WHEEL_TYPE::HANDLE_TYPE> hts(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) { hts[i] = wheel.Schedule(keys[i] % TIMER_TIMEOUT + 1, i); }
+    CLOCK::time_point begin = CLOCK::now();
+    uint64_t sum = 0;
+    for (size_t i = 0; i < newKeys.size(); ++i) {
+        uint64_t now = i / TIMER_OPS_PER_TICK;
+        wheel.Reschedule(hts[newKeys[i] % hts.size()], now + TIMER_TIMEOUT);
+        if (i % TIMER_OPS_PER_TICK == TIMER_OPS_PER_TICK - 1) {
+            wheel.PopExpired(now, [&](WHEEL_TYPE::HANDLE_TYPE, size_t& index) {
+                sum += index;
+                hts[index] = wheel.Schedule(now + TIMER_TIMEOUT, index);
+            });
+        }
+    }
+    int64_t ns = ElapsedNs(begin);
+    sSink += sum;
+    opCount = newKeys.size();
+    return ns;
+}
+/// the plain heap of deadlines, rescheduled by *Update*
+int64_t IpqTimers(const vector<uint64_t>& keys, const vector<uint64_t>& newKeys, size_t& opCount) {
+    typedef IndexedPriorityQueue<uint64_t, std::greater<uint64_t> > QUEUE_TYPE;
+    QUEUE_TYPE pq(keys.size());
+    vector<size_t> hts(keys.size()), slot2Index(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        hts[i] = pq.Push(keys[i] % TIMER_TIMEOUT + 1);
+        slot2Index[hts[i] & QUEUE_TYPE::SLOT_MASK] = i;
+    }
+    CLOCK::time_point begin = CLOCK::now();
+    uint64_t sum = 0;
+    for (size_t i = 0; i < newKeys.size(); ++i) {
+        uint64_t now = i / TIMER_OPS_PER_TICK;
+        pq.Update(hts[newKeys[i] % hts.size()], now + TIMER_TIMEOUT);
+        if (i % TIMER_OPS_PER_TICK == TIMER_OPS_PER_TICK - 1) {
+            while (pq.TopElem() <= now) {
+                size_t index = slot2Index[pq.Top() & QUEUE_TYPE::SLOT_MASK];
+                pq.Pop();
+                sum += index;
+                hts[index] = pq.Push(now + TIMER_TIMEOUT);
+                slot2Index[hts[index] & QUEUE_TYPE::SLOT_MASK] = index;
+            }
+        }
+    }
+    int64_t ns = ElapsedNs(begin);
+    sSink += sum;
+    opCount = newKeys.size();
+    return ns;
+}
+
+/// heavy hitters of a stream: keys are drawn by *newKeys* from a Zipf distribution of exponent 1 over *keys.size()*
+/// keys, the order of *keys* does not matter
+const size_t HEAVY_HITTERS_K = 1000;
+void GenZipfStream(const vector<uint64_t>& keys, const vector<uint64_t>& newKeys, vector<uint64_t>& stream) {
+    vector<double> cdf(keys.size());
+    double sum = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        sum += 1.0 / (i + 1);
+        cdf[i] = sum;
+    }
+    stream.resize(newKeys.size());
+    for (size_t i = 0; i < newKeys.size(); ++i) {
+        double u = (newKeys[i] >> 11) * (1.0 / (uint64_t(1) << 53)) * sum;
+        stream[i] = std::upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+    }
+}
+int64_t IpqHeavyHitters(const vector<uint64_t>& keys, const vector<uint64_t>& newKeys, size_t& opCount) {
+    vector<uint64_t> stream;
+    GenZipfStream(keys, newKeys, stream);
+    HeavyHitters<uint64_t> sketch(HEAVY_HITTERS_K);
+    CLOCK::time_point begin = CLOCK::now();
+    for (size_t i = 0; i < stream.size(); ++i) { sketch.Add(stream[i]); }
+    int64_t ns = ElapsedNs(begin);
+    sSink += sketch.GetMinCount();
+    opCount = stream.size();
+    return ns;
+}
+/// the usual SpaceSaving: ordered set of (count, key) counters, and hash map from key to its count
+int64_t SetHeavyHitters(const vector<uint64_t>& keys, const vector<uint64_t>& newKeys, size_t& opCount) {
+    vector<uint64_t> stream;
+    GenZipfStream(keys, newKeys, stream);
+    set<pair<uint64_t, uint64_t> > counters;
+    unordered_map<uint64_t, uint64_t> key2Count;
+    CLOCK::time_point begin = CLOCK::now();
+    for (size_t i = 0; i < stream.size(); ++i) {
+        uint64_t key = stream[i];
+        auto mapIt = key2Count.find(key);
+        if (mapIt != key2Count.end()) {
+            counters.erase(make_pair(mapIt->second, key));
+            counters.insert(make_pair(++mapIt->second, key));
+            continue;
+        }
+        uint64_t count = 1;
+        if (counters.size() >= HEAVY_HITTERS_K) {
+            count += counters.begin()->first;
+            key2Count.erase(counters.begin()->second);
+            counters.erase(counters.begin());
+        }
+        counters.insert(make_pair(count, key));
+        key2Count[key] = count;
+    }
+    int64_t ns = ElapsedNs(begin);
+    sSink += counters.begin()->first;
+    opCount = stream.size();
+    return ns;
+}
+
+/// many tiny TopN queries, e.g. one per request: every chunk of *keys* is a query with a new queue
+const size_t TINY_TOPN = 10;
+const size_t TINY_TOPN_CHUNK = 100;
+int64_t StaticIpqTinyTopN(const vector<uint64_t>& keys, const vector<uint64_t>&, size_t& opCount) {
+    CLOCK::time_point begin = CLOCK::now();
+    uint64_t sum = 0;
+    for (size_t first = 0; first < keys.size(); first += TINY_TOPN_CHUNK) {
+        StaticIndexedPriorityQueue<uint64_t, TINY_TOPN> pq;
+        size_t last = std::min(first + TINY_TOPN_CHUNK, keys.size());
+        for (size_t i = first; i < last; ++i) {
+            if (!pq.IsNotNeedPushWhenSeekFixedTopN(keys[i])) { pq.Push(keys[i]); }
+        }
+        sum += pq.TopElem();
+    }
+    int64_t ns = ElapsedNs(begin);
+    sSink += sum;
+    opCount = keys.size();
+    return ns;
+}
+int64_t IpqTinyTopN(const vector<uint64_t>& keys, const vector<uint64_t>&, size_t& opCount) {
+    CLOCK::time_point begin = CLOCK::now();
+    uint64_t sum = 0;
+    for (size_t first = 0; first < keys.size(); first += TINY_TOPN_CHUNK) {
+        IndexedPriorityQueue<uint64_t> pq(TINY_TOPN, 1, true);
+        size_t last = std::min(first + TINY_TOPN_CHUNK, keys.size());
+        for (size_t i = first; i < last; ++i) {
+            if (!pq.IsNotNeedPushWhenSeekFixedTopN(keys[i])) { pq.Push(keys[i]); }
+        }
+        sum += pq.TopElem();
+    }
+    int64_t ns = ElapsedNs(begin);
+    sSink += sum;
+    opCount = keys.size();
+    return ns;
+}
+
+void RunCase(const BenchOptions& options, const string& impl, const string& op, const string& dist,
+             const vector<uint64_t>& keys, const vector<uint64_t>& newKeys, const CASE_FUNC& func,
+             vector<BenchResult>& results) {
+    if (!options.m_filter.empty() && (impl + "/" + op).find(options.m_filter) == string::npos) {
+        return;
+    }
+    BenchResult result;
+    result.m_impl = impl;
+    result.m_op = op;
+    result.m_dist = dist;
+    result.m_size = keys.size();
+    for (size_t r = 0; r < options.m_warmup + options.m_reps; ++r) {
+        size_t opCount = 0;
+        int64_t ns = func(keys, newKeys, opCount);
+        if (r >= options.m_warmup) {
+            result.m_opCount = opCount;
+            result.m_nsPerOps.push_back(opCount > 0 ? (double)ns / opCount : 0.0);
+        }
+    }
+    cerr << impl << "/" << op << " dist:[" << dist << "] size:[" << keys.size() << "] median:["
+         << [&]() { vector<double> v(result.m_nsPerOps); sort(v.begin(), v.end()); return v.empty() ? 0.0 : v[v.size() / 2]; }()
+         << "]ns/op" << endl;
+    results.push_back(result);
+}
+
+void WriteJson(const BenchOptions& options, const vector<BenchResult>& results, ostream& os) {
+    os << "{\n  \"benchmark\": \"indexedpq_bench\",\n  \"reps\": " << options.m_reps << ",\n  \"warmup\": "
+       << options.m_warmup << ",\n  \"topN\": " << options.m_topN << ",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& result = results[i];
+        vector<double> sorted(result.m_nsPerOps);
+        sort(sorted.begin(), sorted.end());
+        double mean = 0;
+        for (size_t j = 0; j < sorted.size(); ++j) { mean += sorted[j]; }
+        mean = sorted.empty() ? 0 : mean / sorted.size();
+        os << (i == 0 ? "\n" : ",\n") << "    {\"impl\": \"" << result.m_impl << "\", \"op\": \"" << result.m_op
+           << "\", \"dist\": \"" << result.m_dist << "\", \"size\": " << result.m_size << ", \"ops\": "
+           << result.m_opCount << ", \"ns_per_op\": {\"min\": " << (sorted.empty() ? 0 : sorted.front())
+           << ", \"median\": " << (sorted.empty() ? 0 : sorted[sorted.size() / 2]) << ", \"mean\": " << mean
+           << ", \"max\": " << (sorted.empty() ? 0 : sorted.back()) << "}}";
+    }
+    os << "\n  ]\n}\n";
+}
+
+template<class Type>
+vector<Type> SplitList(const string& value, const function<Type(const string&)>& parse) {
+    vector<Type> values;
+    stringstream ss(value);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (!item.empty()) { values.push_back(parse(item)); }
+    }
+    return values;
+}
+
+bool ParseOptions(int argc, char** argv, BenchOptions& options) {
+    auto parseSize = [](const string& s) { return (size_t)strtod(s.c_str(), nullptr); };   /// accepts 1e8
+    for (int i = 1; i < argc; ++i) {
+        string arg(argv[i]);
+        size_t eq = arg.find('=');
+        string name = arg.substr(0, eq);
+        string value = eq == string::npos ? "" : arg.substr(eq + 1);
+        if (name == "--sizes") {
+            options.m_sizes = SplitList<size_t>(value, parseSize);
+            /// every case reads the top or indexes keys by size, so empty inputs are not measurable
+            if (std::find(options.m_sizes.begin(), options.m_sizes.end(), 0) != options.m_sizes.end()) {
+                cerr << "sizes must be positive: " << value << endl;
+                return false;
+            }
+        }
+        else if (name == "--dists") { options.m_dists = SplitList<string>(value, [](const string& s) { return s; }); }
+        else if (name == "--reps") { options.m_reps = std::max<size_t>(parseSize(value), 1); }
+        else if (name == "--warmup") { options.m_warmup = parseSize(value); }
+        else if (name == "--topn") { options.m_topN = std::max<size_t>(parseSize(value), 1); }
+        else if (name == "--filter") { options.m_filter = value; }
+        else if (name == "--out") { options.m_outPath = value; }
+        else {
+            cerr << "usage: " << argv[0] << " [--sizes=1000,1e6] [--dists=uniform,ascending,descending,dups]"
+                 << " [--reps=5] [--warmup=1] [--topn=1000] [--filter=ipq/push] [--out=result.json]" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        return 1;
+    }
+    size_t topN = options.m_topN;
+    CASE_FUNC ipqDedup = [topN](const vector<uint64_t>& k, const vector<uint64_t>& n, size_t& c) { return IpqDedupTopN(topN, k, n, c); };
+    CASE_FUNC setDedup = [topN](const vector<uint64_t>& k, const vector<uint64_t>& n, size_t& c) { return SetDedupTopN(topN, k, n, c); };
+
+    vector<BenchResult> results;
+    vector<uint64_t> keys, newKeys;
+    for (size_t size : options.m_sizes) {
+        for (const string& dist : options.m_dists) {
+            GenKeys(dist, size, 20211220, keys);
+            GenKeys("uniform", size, 20211221, newKeys);
+            RunCase(options, "ipq", "push", dist, keys, newKeys, IpqPush, results);
+            RunCase(options, "std_pq", "push", dist, keys, newKeys, StdPqPush, results);
+            RunCase(options, "std_set", "push", dist, keys, newKeys, SetPush, results);
+            RunCase(options, "ipq", "pop", dist, keys, newKeys, IpqPop, results);
+            RunCase(options, "std_pq", "pop", dist, keys, newKeys, StdPqPop, results);
+            RunCase(options, "std_set", "pop", dist, keys, newKeys, SetPop, results);
+            RunCase(options, "ipq", "update", dist, keys, newKeys, IpqUpdate, results);
+            RunCase(options, "std_set", "update", dist, keys, newKeys, SetUpdate, results);
+            RunCase(options, "ipq", "replace_top", dist, keys, newKeys, IpqReplaceTop, results);
+            RunCase(options, "std_pq", "replace_top", dist, keys, newKeys, StdPqReplaceTop, results);
+            RunCase(options, "std_set", "replace_top", dist, keys, newKeys, SetReplaceTop, results);
+            RunCase(options, "ipq", "topn_dedup", dist, keys, newKeys, ipqDedup, results);
+            RunCase(options, "std_set", "topn_dedup", dist, keys, newKeys, setDedup, results);
+            RunCase(options, "timer_wheel", "timers", dist, keys, newKeys, TimerWheelTimers, results);
+            RunCase(options, "ipq", "timers", dist, keys, newKeys, IpqTimers, results);
+            RunCase(options, "ipq", "heavy_hitters", dist, keys, newKeys, IpqHeavyHitters, results);
+            RunCase(options, "std_set", "heavy_hitters", dist, keys, newKeys, SetHeavyHitters, results);
+            RunCase(options, "static_ipq", "tiny_topn", dist, keys, newKeys, StaticIpqTinyTopN, results);
+            RunCase(options, "ipq", "tiny_topn", dist, keys, newKeys, IpqTinyTopN, results);
+        }
+    }
+
+    if (options.m_outPath.empty()) {
+        WriteJson(options, results, cout);
+    }
+    else {
+        ofstream ofs(options.m_outPath);
+        WriteJson(options, results, ofs);
+    }
+    return 0;
+}
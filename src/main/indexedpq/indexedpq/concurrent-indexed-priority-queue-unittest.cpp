@@ -0,0 +1,256 @@
+#include "indexedpq/concurrent-indexed-priority-queue-unittest.h"
+#include "indexedpq/indexed-priority-queue-unittest.h"
+#include <cppunit/TestAssert.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+CPPUNIT_TEST_SUITE_REGISTRATION(ConcurrentIndexedPriorityQueueTest);
+
+void ConcurrentIndexedPriorityQueueTest::StrictTest() {
+    size_t count = 10000;
+    vector<uint64_t> scoresVec, newScoresVec;
+    FakeItemMgr::sGenScores(count, scoresVec);
+    FakeItemMgr::sGenScores(count, newScoresVec);
+    ConcurrentIndexedPriorityQueue<uint64_t> queue;
+    CPPUNIT_ASSERT(queue.IsStrict());
+    vector<size_t> htsVec;
+    for (size_t i = 0; i < count; ++i) {
+        htsVec.push_back(queue.Push(scoresVec[i]));
+    }
+    CPPUNIT_ASSERT_EQUAL(count, queue.GetCount());
+    for (size_t i = 0; i < count; i += 2) {
+        uint64_t oldScore = 0, score = 0;
+        CPPUNIT_ASSERT_EQUAL(htsVec[i], queue.Update(htsVec[i], newScoresVec[i], &oldScore));
+        CPPUNIT_ASSERT_EQUAL(scoresVec[i], oldScore);
+        CPPUNIT_ASSERT(queue.GetElem(htsVec[i], score));
+        CPPUNIT_ASSERT_EQUAL(newScoresVec[i], score);
+        scoresVec[i] = newScoresVec[i];
+    }
+    std::sort(scoresVec.begin(), scoresVec.end(), std::greater<uint64_t>());
+    uint64_t score = 0;
+    for (size_t i = 0; i < count; ++i) {
+        CPPUNIT_ASSERT(queue.Pop(&score));
+        CPPUNIT_ASSERT_EQUAL(scoresVec[i], score);
+    }
+    CPPUNIT_ASSERT(!queue.Pop(&score));
+    CPPUNIT_ASSERT(queue.IsEmpty());
+}
+
+void ConcurrentIndexedPriorityQueueTest::InternalConcurrentTest(size_t shardCount, size_t threadCount, size_t countPerThread) {
+    ConcurrentIndexedPriorityQueue<uint64_t> queue(shardCount);
+    vector<vector<uint64_t> > scoresVecs(threadCount), poppedVecs(threadCount);
+    vector<thread> threads;
+    /// every thread pushes its scores, then updates them by handles, while other threads are pushing
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&queue, &scoresVecs, t, countPerThread]() {
+            vector<uint64_t>& scoresVec = scoresVecs[t];
+            vector<size_t> htsVec;
+            FakeItemMgr::sGenScores(countPerThread, scoresVec);
+            for (size_t i = 0; i < countPerThread; ++i) {
+                htsVec.push_back(queue.Push(scoresVec[i]));
+            }
+            for (size_t i = 0; i < countPerThread; i += 3) {
+                uint64_t oldScore = 0;
+                queue.Update(htsVec[i], scoresVec[i] / 2, &oldScore);
+                CPPUNIT_ASSERT_EQUAL(scoresVec[i], oldScore);
+                scoresVec[i] /= 2;
+            }
+        });
+    }
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads[t].join();
+    }
+    CPPUNIT_ASSERT_EQUAL(threadCount * countPerThread, queue.GetCount());
+    threads.clear();
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&queue, &poppedVecs, t]() {
+            uint64_t score = 0;
+            while (queue.Pop(&score)) {
+                poppedVecs[t].push_back(score);
+            }
+        });
+    }
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads[t].join();
+    }
+    vector<uint64_t> allScoresVec, allPoppedVec;
+    for (size_t t = 0; t < threadCount; ++t) {
+        allScoresVec.insert(allScoresVec.end(), scoresVecs[t].begin(), scoresVecs[t].end());
+        allPoppedVec.insert(allPoppedVec.end(), poppedVecs[t].begin(), poppedVecs[t].end());
+    }
+    std::sort(allScoresVec.begin(), allScoresVec.end());
+    std::sort(allPoppedVec.begin(), allPoppedVec.end());
+    CPPUNIT_ASSERT(allScoresVec == allPoppedVec);
+    CPPUNIT_ASSERT(queue.IsEmpty());
+}
+
+void ConcurrentIndexedPriorityQueueTest::RelaxedTest() {
+    CPPUNIT_ASSERT_EQUAL((size_t)16, ConcurrentIndexedPriorityQueue<uint64_t>::RelaxedShardCount(8));
+    ConcurrentIndexedPriorityQueue<uint64_t> queue(6);
+    CPPUNIT_ASSERT_EQUAL((size_t)8, queue.GetShardCount());
+    CPPUNIT_ASSERT(!queue.IsStrict());
+
+    InternalConcurrentTest(1, 4, 5000);
+    InternalConcurrentTest(8, 4, 5000);
+    InternalConcurrentTest(16, 3, 3000);
+
+    /// single thread relaxed pops are close to the top: every popped score is better than most of the remaining ones
+    size_t count = 20000;
+    vector<uint64_t> scoresVec;
+    FakeItemMgr::sGenScores(count, scoresVec);
+    ConcurrentIndexedPriorityQueue<uint64_t> relaxedQueue(8);
+    for (size_t i = 0; i < count; ++i) {
+        relaxedQueue.Push(scoresVec[i]);
+    }
+    std::sort(scoresVec.begin(), scoresVec.end(), std::greater<uint64_t>());
+    uint64_t score = 0;
+    size_t rankErrorSum = 0;
+    for (size_t i = 0; i < count / 2; ++i) {
+        CPPUNIT_ASSERT(relaxedQueue.Pop(&score));
+        size_t rank = std::lower_bound(scoresVec.begin(), scoresVec.end(), score, std::greater<uint64_t>()) - scoresVec.begin();
+        rankErrorSum += rank > i ? rank - i : i - rank;
+    }
+    CPPUNIT_ASSERT(rankErrorSum / (count / 2) < 8 * relaxedQueue.GetShardCount());
+}
+
+void ConcurrentIndexedPriorityQueueTest::StaleHandleTest() {
+    /// a popped handle is rejected, whether its slot is reused or not
+    ConcurrentIndexedPriorityQueue<uint64_t> queue;
+    size_t ht1 = queue.Push(1);
+    size_t ht2 = queue.Push(2);
+    size_t poppedHt = 0;
+    uint64_t elem = 0;
+    CPPUNIT_ASSERT(queue.Pop(&elem, &poppedHt));
+    CPPUNIT_ASSERT_EQUAL(ht2, poppedHt);
+    CPPUNIT_ASSERT(queue.Update(ht2, 100) == queue.INVALID_HANDLE);
+    CPPUNIT_ASSERT(!queue.GetElem(ht2, elem));
+    size_t ht3 = queue.Push(3);
+    CPPUNIT_ASSERT(ht3 != ht2);
+    CPPUNIT_ASSERT(queue.Update(ht2, 100) == queue.INVALID_HANDLE);
+    CPPUNIT_ASSERT(queue.GetElem(ht3, elem));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)3, elem);
+    CPPUNIT_ASSERT_EQUAL(ht1, queue.Update(ht1, 10));
+
+    /// updaters race against a thread popping the same handles and pushing new elements, which reuse their slots.
+    /// Elements are ids of their pushes, so touching an unrelated element through a stale handle is detected.
+    for (size_t shardCount : {1, 4}) {
+        const uint64_t UPDATED_BIT = uint64_t(1) << 63;
+        size_t count = 1000, popCount = 20000, updaterCount = 3;
+        ConcurrentIndexedPriorityQueue<uint64_t> raceQueue(shardCount);
+        std::mutex mutex;
+        vector<pair<size_t, uint64_t> > htIdVec;        /// every handle and id of its push
+        uint64_t nextId = 0;
+        for (; nextId < count; ++nextId) {
+            htIdVec.push_back(make_pair(raceQueue.Push(nextId), nextId));
+        }
+        std::atomic<bool> isDone(false);
+        std::atomic<size_t> badCnt(0), updatedCnt(0);
+        vector<thread> threads;
+        for (size_t t = 0; t < updaterCount; ++t) {
+            threads.emplace_back([&]() {
+                while (!isDone.load()) {
+                    pair<size_t, uint64_t> htId;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        htId = htIdVec[RandomUtil<int64_t>::RandomInt64(0, htIdVec.size() - 1)];
+                    }
+                    uint64_t removed = 0, elem = 0;
+                    if (raceQueue.Update(htId.first, htId.second | UPDATED_BIT, &removed) != raceQueue.INVALID_HANDLE) {
+                        badCnt += (removed & ~UPDATED_BIT) != htId.second;
+                        ++updatedCnt;
+                    }
+                    if (raceQueue.GetElem(htId.first, elem)) {
+                        badCnt += (elem & ~UPDATED_BIT) != htId.second;
+                    }
+                }
+            });
+        }
+        for (size_t i = 0; i < popCount; ++i) {
+            raceQueue.Pop();
+            size_t ht = raceQueue.Push(nextId);
+            std::lock_guard<std::mutex> lock(mutex);
+            htIdVec.push_back(make_pair(ht, nextId++));
+        }
+        isDone.store(true);
+        for (thread& t : threads) {
+            t.join();
+        }
+        CPPUNIT_ASSERT_EQUAL((size_t)0, badCnt.load());
+        CPPUNIT_ASSERT(updatedCnt.load() > 0);
+        CPPUNIT_ASSERT_EQUAL(count, raceQueue.GetCount());
+    }
+}
+
+namespace {
+/// the pattern of wrapping the whole IndexedPriorityQueue by one mutex
+class GlobalLockQueue {
+public:
+    size_t Push(uint64_t elem) { std::lock_guard<std::mutex> lock(m_mutex); return m_queue.Push(elem); }
+    void Update(size_t ht, uint64_t elem) { std::lock_guard<std::mutex> lock(m_mutex); m_queue.Update(ht, elem); }
+    bool Pop() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_queue.IsEmpty()) { return false; }
+        m_queue.Pop();
+        return true;
+    }
+private:
+    std::mutex m_mutex;
+    IndexedPriorityQueue<uint64_t> m_queue;
+};
+
+/// every thread pushes scores, updates half of them and pops as many as pushed, return consumed ms
+template<class Queue, class PopFunc>
+int64_t RunContention(Queue& queue, size_t threadCount, const vector<uint64_t>& scoresVec, PopFunc popFunc) {
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    vector<thread> threads;
+    size_t countPerThread = scoresVec.size() / threadCount;
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&queue, &scoresVec, &popFunc, t, countPerThread]() {
+            vector<size_t> htsVec;
+            for (size_t i = t * countPerThread; i < (t + 1) * countPerThread; ++i) {
+                htsVec.push_back(queue.Push(scoresVec[i]));
+            }
+            for (size_t i = 0; i < countPerThread; i += 2) {
+                queue.Update(htsVec[i], scoresVec[t * countPerThread + i] + 1);
+            }
+            for (size_t i = 0; i < countPerThread; ++i) {
+                popFunc(queue);
+            }
+        });
+    }
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads[t].join();
+    }
+    return (TimeUtil::CurrentTimeInMicroSeconds() - tBegin) / 1000;
+}
+}
+
+void ConcurrentIndexedPriorityQueueTest::ContentionPerformanceTest() {
+    size_t count = 1e6;
+    vector<uint64_t> scoresVec;
+    FakeItemMgr::sGenScores(count, scoresVec);
+    size_t maxThreadCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    for (size_t threadCount = 1; ; threadCount *= 2) {
+        threadCount = std::min(threadCount, maxThreadCount);
+        GlobalLockQueue globalLockQueue;
+        int64_t tGlobal = RunContention(globalLockQueue, threadCount, scoresVec, [](GlobalLockQueue& q) { q.Pop(); });
+        ConcurrentIndexedPriorityQueue<uint64_t> strictQueue(1);
+        int64_t tStrict = RunContention(strictQueue, threadCount, scoresVec,
+                                        [](ConcurrentIndexedPriorityQueue<uint64_t>& q) { q.Pop(); });
+        ConcurrentIndexedPriorityQueue<uint64_t> relaxedQueue(ConcurrentIndexedPriorityQueue<uint64_t>::RelaxedShardCount(threadCount));
+        int64_t tRelaxed = RunContention(relaxedQueue, threadCount, scoresVec,
+                                         [](ConcurrentIndexedPriorityQueue<uint64_t>& q) { q.Pop(); });
+        cout << "-------------count:[" << count << "],threadCount:[" << threadCount << "],global lock:[" << tGlobal
+             << "]ms,strict:[" << tStrict << "]ms,relaxed(" << relaxedQueue.GetShardCount() << " shards):["
+             << tRelaxed << "]ms." << endl;
+        CPPUNIT_ASSERT(strictQueue.IsEmpty());
+        CPPUNIT_ASSERT(relaxedQueue.IsEmpty());
+        if (threadCount == maxThreadCount) {
+            break;
+        }
+    }
+}
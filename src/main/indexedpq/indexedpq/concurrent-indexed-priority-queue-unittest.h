@@ -0,0 +1,31 @@
+#ifndef __INDEXEDPQ_TEST_CONCURRENT_INDEXED_PRIORITY_QUEUE_UNITTEST_H__
+#define __INDEXEDPQ_TEST_CONCURRENT_INDEXED_PRIORITY_QUEUE_UNITTEST_H__
+
+#include "indexedpq/concurrent-indexed-priority-queue.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+class ConcurrentIndexedPriorityQueueTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(ConcurrentIndexedPriorityQueueTest);
+    CPPUNIT_TEST(StrictTest);
+    CPPUNIT_TEST(RelaxedTest);
+    CPPUNIT_TEST(StaleHandleTest);
+    CPPUNIT_TEST(ContentionPerformanceTest);
+    CPPUNIT_TEST_SUITE_END();
+public:
+    ConcurrentIndexedPriorityQueueTest() {}
+    ~ConcurrentIndexedPriorityQueueTest() {}
+    void setUp() {}
+    void tearDown() {}
+public:
+
+    void StrictTest();
+    void RelaxedTest();
+    void StaleHandleTest();
+    void ContentionPerformanceTest();
+
+private:
+    void InternalConcurrentTest(size_t shardCount, size_t threadCount, size_t countPerThread);
+};
+
+
+#endif //__INDEXEDPQ_TEST_CONCURRENT_INDEXED_PRIORITY_QUEUE_UNITTEST_H__
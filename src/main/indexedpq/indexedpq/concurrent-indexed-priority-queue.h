@@ -0,0 +1,281 @@
+#ifndef __INDEXEDPQ_CONCURRENT_INDEXED_PRIORITY_QUEUE_H__
+#define __INDEXEDPQ_CONCURRENT_INDEXED_PRIORITY_QUEUE_H__
+
+#include "indexedpq/indexed-priority-queue.h"
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// default policy of ConcurrentIndexedPriorityQueue, handles carry generations so that a handle popped by another
+/// thread is detected as stale by *Update* and *GetElem* instead of touching the element reusing its slot.
+struct IndexedPQConcurrentPolicy : public IndexedPQDefaultPolicy {
+    static constexpr size_t GENERATION_BITS = 16;
+};
+
+/**
+ *@brief     thread-safe IndexedPriorityQueue which keeps the handle and *Update* semantics. Elements are spread over
+ *           shards, every shard is an IndexedPriorityQueue guarded by its own mutex, and a handle encodes its shard in
+ *           the low bits, so *Update* and *Elem* only lock the shard owning the element.
+ *           With one shard the queue is strict: *Pop* always returns the top element of all. With more shards it is
+ *           the relaxed MultiQueue: *Push* goes to a random uncontended shard, and *Pop* peeks two random shards and
+ *           pops the better top, so popped elements are close to the top with high probability but not exactly it.
+ *           c*P shards for P threads(see *RelaxedShardCount*) keep lock contention low.
+ *           A handle may be popped by one thread while another one updates it, so *Update* and *GetElem* check it under
+ *           the shard lock. With *GENERATION_BITS* of *Policy* not 0, as of the default policy, a stale handle is
+ *           always rejected, otherwise only if its slot is not reused by a later *Push*.
+ */
+template <class T, class CompareFunc = std::less<T>, class Policy = IndexedPQConcurrentPolicy >
+class ConcurrentIndexedPriorityQueue
+{
+public:
+    typedef T                                               VALUE_TYPE;
+    typedef CompareFunc                                     VALUE_COMPARE;
+    typedef IndexedPriorityQueue<T, CompareFunc, Policy>    QUEUE_TYPE;
+    typedef size_t                                          HANDLE_TYPE;    /// generation | shard slot | shard index
+
+    static constexpr HANDLE_TYPE INVALID_HANDLE = HANDLE_TYPE(-1);
+
+    static constexpr size_t SHARDS_PER_THREAD = 2;          /// the constant c of c*P shards for relaxed mode
+    static constexpr size_t PUSH_TRY_LOCK_TIMES = 4;        /// random shards tried by *Push* before blocking on lock
+
+    /// recommended shards count of relaxed mode for *threadCount* threads
+    static size_t RelaxedShardCount(size_t threadCount = std::thread::hardware_concurrency()) {
+        return SHARDS_PER_THREAD * std::max<size_t>(threadCount, 1);
+    }
+
+public:
+    /**
+     *@param     shardCount --- 1 means strict mode, larger means relaxed mode, rounded up to power of 2.
+     *@param     nShardSizeHint --- preserved size of every shard, shards grow when full.
+     */
+    ConcurrentIndexedPriorityQueue(size_t shardCount = 1, size_t nShardSizeHint = 32,
+                                   VALUE_COMPARE compareFunc = VALUE_COMPARE());
+    ConcurrentIndexedPriorityQueue(const ConcurrentIndexedPriorityQueue&) = delete;
+    ConcurrentIndexedPriorityQueue& operator=(const ConcurrentIndexedPriorityQueue&) = delete;
+
+    inline size_t GetShardCount() { return m_shardCount; }
+    inline bool   IsStrict() { return m_shardCount == 1; }
+    /// elements count, which is only a snapshot if other threads are changing the queue
+    size_t GetCount() {
+        size_t count = 0;
+        for (size_t i = 0; i < m_shardCount; ++i) { count += m_shardVec[i]->m_elemCnt.load(std::memory_order_relaxed); }
+        return count;
+    }
+    inline bool IsEmpty() { return GetCount() == 0; }
+
+    /// push *elem*, return its handle, INVALID_HANDLE if the shard reaches its max count
+    HANDLE_TYPE Push(const T& elem);
+
+    /**
+     *@brief     update element of handle *ht* to *newElem*.
+     *@param     pRemovedElem --- element substituted if it is not null.
+     *@return    handle of updated element, INVALID_HANDLE if *ht* is invalid, e.g. popped by another thread.
+     */
+    HANDLE_TYPE Update(HANDLE_TYPE ht, const T& newElem, T* pRemovedElem = nullptr);
+
+    /// copy element of handle *ht* to *elem*, return false if *ht* is invalid.
+    bool GetElem(HANDLE_TYPE ht, T& elem);
+
+    /**
+     *@brief     pop the top element in strict mode, or the better top of two random shards in relaxed mode.
+     *@param     pElem --- popped element if it is not null.
+     *@param     pHt --- handle of popped element if it is not null, which is stale and its slot may be reused by
+     *                   later *Push*.
+     *@return    false if the queue is empty.
+     */
+    bool Pop(T* pElem = nullptr, HANDLE_TYPE* pHt = nullptr);
+
+    /// Reset status of all shards
+    void Reset();
+
+private:
+    struct alignas(64) Shard {
+        Shard(size_t nSizeHint, VALUE_COMPARE compareFunc) : m_queue(nSizeHint, 32, false, compareFunc), m_elemCnt(0) {}
+        std::mutex              m_mutex;
+        QUEUE_TYPE              m_queue;
+        std::atomic<size_t>     m_elemCnt;      /// count of m_queue, readable without lock to skip empty shards
+    };
+
+    typedef typename QUEUE_TYPE::HANDLE_TYPE SHARD_HANDLE_TYPE;
+    /// generation of shard handle is kept in the top bits, slot is shifted by shard bits below it
+    static constexpr size_t GENERATION_BITS = QUEUE_TYPE::GENERATION_BITS;
+    static constexpr size_t GENERATION_SHIFT = sizeof(HANDLE_TYPE) * 8 - GENERATION_BITS;
+    inline HANDLE_TYPE EncodeHandle(size_t shard, SHARD_HANDLE_TYPE ht) {
+        HANDLE_TYPE slot = ht & QUEUE_TYPE::SLOT_MASK;
+        assert(GENERATION_BITS + m_shardBits == 0 || (slot >> (GENERATION_SHIFT - m_shardBits)) == 0);
+        if constexpr (GENERATION_BITS > 0) {
+            slot |= HANDLE_TYPE(ht >> QUEUE_TYPE::SLOT_BITS) << (GENERATION_SHIFT - m_shardBits);
+        }
+        return (slot << m_shardBits) | shard;
+    }
+    inline size_t ShardOfHandle(HANDLE_TYPE ht) { return ht & (m_shardCount - 1); }
+    inline SHARD_HANDLE_TYPE ShardHandle(HANDLE_TYPE ht) {
+        HANDLE_TYPE slot = (ht & (HANDLE_TYPE(-1) >> GENERATION_BITS)) >> m_shardBits;
+        if constexpr (GENERATION_BITS > 0) {
+            slot |= HANDLE_TYPE(ht >> GENERATION_SHIFT) << QUEUE_TYPE::SLOT_BITS;
+        }
+        return SHARD_HANDLE_TYPE(slot);
+    }
+
+    /// random shard index by a thread local xorshift generator
+    size_t RandomShard() {
+        static thread_local uint64_t s_state = std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+        s_state ^= s_state << 13;
+        s_state ^= s_state >> 7;
+        s_state ^= s_state << 17;
+        return s_state & (m_shardCount - 1);
+    }
+    /// copy top element of *shard* to *elem*, return false if it is empty
+    bool PeekTop(size_t shard, T& elem) {
+        Shard& s = *m_shardVec[shard];
+        if (s.m_elemCnt.load(std::memory_order_relaxed) == 0) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(s.m_mutex);
+        if (s.m_queue.IsEmpty()) {
+            return false;
+        }
+        elem = s.m_queue.TopElem();
+        return true;
+    }
+    /// pop top element of *shard*, return false if it is empty
+    bool PopShard(size_t shard, T* pElem, HANDLE_TYPE* pHt);
+
+private:
+    std::vector<std::unique_ptr<Shard> >    m_shardVec;
+    size_t                                  m_shardCount;       /// power of 2
+    size_t                                  m_shardBits;        /// log2(m_shardCount)
+    VALUE_COMPARE                           m_valueCmpFunc;
+};
+
+template <class T, class CompareFunc, class Policy>
+ConcurrentIndexedPriorityQueue<T, CompareFunc, Policy>::
+ConcurrentIndexedPriorityQueue(size_t shardCount        /* = 1 */,
+                               size_t nShardSizeHint    /* = 32 */,
+                               VALUE_COMPARE compareFunc /* = VALUE_COMPARE() */) {
+    m_shardCount = 1;
+    m_shardBits = 0;
+    while (m_shardCount < shardCount) {
+        m_shardCount *= 2;
+        ++m_shardBits;
+    }
+    for (size_t i = 0; i < m_shardCount; ++i) {
+        m_shardVec.emplace_back(new Shard(nShardSizeHint, compareFunc));
+    }
+    m_valueCmpFunc = compareFunc;
+}
+
+template <class T, class CompareFunc, class Policy>
+typename ConcurrentIndexedPriorityQueue<T, CompareFunc, Policy>::HANDLE_TYPE
+ConcurrentIndexedPriorityQueue<T, CompareFunc, Policy>::Push(const T& elem) {
+    size_t shard = 0;
+    std::unique_lock<std::mutex> lock;
+    if (IsStrict()) {
+        lock = std::unique_lock<std::mutex>(m_shardVec[0]->m_mutex);
+    }
+    else {
+        /// any shard is fine for relaxed mode, so skip the locked ones
+        for (size_t i = 0; i < PUSH_TRY_LOCK_TIMES && !lock.owns_lock(); ++i) {
+            shard = RandomShard();
+            lock = std::unique_lock<std::mutex>(m_shardVec[shard]->m_mutex, std::try_to_lock);
+        }
+        if (!lock.owns_lock()) {
+            lock = std::unique_lock<std::mutex>(m_shardVec[shard]->m_mutex);
+        }
+    }
+    Shard& s = *m_shardVec[shard];
+    typename QUEUE_TYPE::HANDLE_TYPE ht = s.m_queue.Push(elem);
+    if (ht == QUEUE_TYPE::INVALID_HANDLE) {
+        return INVALID_HANDLE;
+    }
+    s.m_elemCnt.store(s.m_queue.GetCount(), std::memory_order_relaxed);
+    return EncodeHandle(shard, ht);
+}
+
+template <class T, class CompareFunc, class Policy>
+typename ConcurrentIndexedPriorityQueue<T, CompareFunc, Policy>::HANDLE_TYPE
+ConcurrentIndexedPriorityQueue<T, CompareFunc, Policy>::Update(HANDLE_TYPE ht, const T& newElem, T* pRemovedElem /* = nullptr */) {
+    if (ht == INVALID_HANDLE) {
+        return INVALID_HANDLE;
+    }
+    size_t shard = ShardOfHandle(ht);
+    Shard& s = *m_shardVec[shard];
+    std::lock_guard<std::mutex> lock(s.m_mutex);
+    if (!s.m_queue.Contains(ShardHandle(ht))
+        || s.m_queue.Update(ShardHandle(ht), newElem, pRemovedElem) == QUEUE_TYPE::INVALID_HANDLE) {
+        return INVALID_HANDLE;
+    }
+    return ht;
+}
+
+template <class T, class CompareFunc, class Policy>
+bool ConcurrentIndexedPriorityQueue<T, CompareFunc, Policy>::GetElem(HANDLE_TYPE ht, T& elem) {
+    if (ht == INVALID_HANDLE) {
+        return false;
+    }
+    Shard& s = *m_shardVec[ShardOfHandle(ht)];
+    std::lock_guard<std::mutex> lock(s.m_mutex);
+    if (!s.m_queue.Contains(ShardHandle(ht))) {
+        return false;
+    }
+    elem = s.m_queue.Elem(ShardHandle(ht));
+    return true;
+}
+
+template <class T, class CompareFunc, class Policy>
+bool ConcurrentIndexedPriorityQueue<T, CompareFunc, Policy>::PopShard(size_t shard, T* pElem, HANDLE_TYPE* pHt) {
+    Shard& s = *m_shardVec[shard];
+    std::lock_guard<std::mutex> lock(s.m_mutex);
+    if (s.m_queue.IsEmpty()) {
+        return false;
+    }
+    if (nullptr != pElem) { *pElem = s.m_queue.TopElem(); }
+    typename QUEUE_TYPE::HANDLE_TYPE ht = s.m_queue.Pop();
+    s.m_elemCnt.store(s.m_queue.GetCount(), std::memory_order_relaxed);
+    if (nullptr != pHt) { *pHt = EncodeHandle(shard, ht); }
+    return true;
+}
+
+template <class T, class CompareFunc, class Policy>
+bool ConcurrentIndexedPriorityQueue<T, CompareFunc, Policy>::Pop(T* pElem /* = nullptr */, HANDLE_TYPE* pHt /* = nullptr */) {
+    if (IsStrict()) {
+        return PopShard(0, pElem, pHt);
+    }
+    /// the better of two random shards, tops may change after peeking, which is allowed by relaxed semantics
+    size_t a = RandomShard(), b = RandomShard();
+    T aTop, bTop;
+    bool hasA = PeekTop(a, aTop), hasB = PeekTop(b, bTop);
+    if (hasA && hasB) {
+        size_t better = m_valueCmpFunc(aTop, bTop) ? b : a;
+        if (PopShard(better, pElem, pHt) || PopShard(better == a ? b : a, pElem, pHt)) {
+            return true;
+        }
+    }
+    else if ((hasA && PopShard(a, pElem, pHt)) || (hasB && PopShard(b, pElem, pHt))) {
+        return true;
+    }
+    /// both sampled shards are empty, scan all shards before reporting empty
+    size_t start = RandomShard();
+    for (size_t i = 0; i < m_shardCount; ++i) {
+        if (PopShard((start + i) & (m_shardCount - 1), pElem, pHt)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <class T, class CompareFunc, class Policy>
+void ConcurrentIndexedPriorityQueue<T, CompareFunc, Policy>::Reset() {
+    for (size_t i = 0; i < m_shardCount; ++i) {
+        std::lock_guard<std::mutex> lock(m_shardVec[i]->m_mutex);
+        m_shardVec[i]->m_queue.Reset();
+        m_shardVec[i]->m_elemCnt.store(0, std::memory_order_relaxed);
+    }
+}
+
+#endif //__INDEXEDPQ_CONCURRENT_INDEXED_PRIORITY_QUEUE_H__
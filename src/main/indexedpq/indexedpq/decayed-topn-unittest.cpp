@@ -0,0 +1,193 @@
+#include "indexedpq/decayed-topn-unittest.h"
+#include "indexedpq/indexed-priority-queue-unittest.h"
+#include <cppunit/TestAssert.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+CPPUNIT_TEST_SUITE_REGISTRATION(DecayedTopNTest);
+
+void DecayedTopNTest::DecayTest() {
+    int64_t halfLife = 1000, ttl = 1000000;
+    DecayedTopN<string> topN(10, halfLife, ttl);
+    CPPUNIT_ASSERT(topN.Add("a", 8, 0));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(8.0, topN.ScoreOf("a", 0), 1e-9);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(4.0, topN.ScoreOf("a", halfLife), 1e-9);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, topN.ScoreOf("a", 3 * halfLife), 1e-9);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, topN.ScoreOf("b", 0), 1e-9);
+
+    /// adding accumulates decayed scores
+    CPPUNIT_ASSERT(topN.Add("a", 4, halfLife));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(8.0, topN.ScoreOf("a", halfLife), 1e-9);
+
+    /// an old high score falls behind a recent lower one
+    CPPUNIT_ASSERT(topN.Add("b", 5, 2 * halfLife));
+    vector<pair<string, double> > result;
+    topN.GetTopN(2 * halfLife, result);
+    CPPUNIT_ASSERT_EQUAL((size_t)2, result.size());
+    CPPUNIT_ASSERT_EQUAL(string("b"), result[0].first);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0, result[0].second, 1e-9);
+    CPPUNIT_ASSERT_EQUAL(string("a"), result[1].first);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(4.0, result[1].second, 1e-9);
+
+    /// far in time log scores stay exact
+    int64_t farTime = (int64_t)1e12;
+    CPPUNIT_ASSERT(topN.Add("c", 3, farTime));
+    CPPUNIT_ASSERT(topN.Add("c", 3, farTime + halfLife));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(4.5, topN.ScoreOf("c", farTime + halfLife), 1e-6);
+
+    /// no decay if half life is not positive
+    DecayedTopN<uint64_t> flatTopN(10, 0, ttl);
+    flatTopN.Add(1, 3, 0);
+    flatTopN.Add(1, 3, 500000);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(6.0, flatTopN.ScoreOf(1, 900000), 1e-9);
+}
+
+void DecayedTopNTest::ExpiryTest() {
+    int64_t ttl = 100;
+    DecayedTopN<uint64_t> topN(3, 1000, ttl);
+    topN.Add(1, 10, 0);
+    topN.Add(2, 20, 10);
+    topN.Add(3, 30, 20);
+    CPPUNIT_ASSERT_EQUAL((size_t)3, topN.GetCount());
+    /// key 1 is renewed
+    topN.Add(1, 1, 90);
+    CPPUNIT_ASSERT_EQUAL((size_t)0, topN.Expire(99));
+    CPPUNIT_ASSERT_EQUAL((size_t)1, topN.Expire(110));
+    CPPUNIT_ASSERT_EQUAL(0.0, topN.ScoreOf(2, 110));
+    /// expired keys are evicted lazily by *Add*, in one batch
+    topN.Add(4, 5, 200);
+    CPPUNIT_ASSERT_EQUAL((size_t)1, topN.GetCount());
+    CPPUNIT_ASSERT(topN.ScoreOf(4, 200) > 0);
+    vector<pair<uint64_t, double> > result;
+    topN.GetTopN(300, result);
+    CPPUNIT_ASSERT(result.empty());
+    CPPUNIT_ASSERT(topN.IsEmpty());
+
+    /// full TopN rejects worse keys and evicts the worst for better ones
+    topN.Add(1, 10, 1000);
+    topN.Add(2, 20, 1000);
+    topN.Add(3, 30, 1000);
+    CPPUNIT_ASSERT(!topN.Add(4, 5, 1000));
+    CPPUNIT_ASSERT(topN.Add(5, 50, 1000));
+    CPPUNIT_ASSERT_EQUAL(0.0, topN.ScoreOf(1, 1000));
+    /// evicted key's expiry is taken over by the new key
+    CPPUNIT_ASSERT_EQUAL((size_t)3, topN.Expire(1100));
+    CPPUNIT_ASSERT(topN.IsEmpty());
+}
+
+void DecayedTopNTest::TopNTest() {
+    /// against brute force, every key fits in TopN so no key loses its score
+    size_t keyCount = 200, opCount = 50000;
+    int64_t halfLife = 500, ttl = 300;
+    DecayedTopN<uint64_t> topN(keyCount, halfLife, ttl);
+    double decayRate = std::log(2.0) / halfLife;
+    /// key to (score at time of last add, time of last add)
+    map<uint64_t, pair<double, int64_t> > refMap;
+    int64_t now = 0;
+    for (size_t i = 0; i < opCount; ++i) {
+        now += RandomUtil<int64_t>::RandomInt64(0, 3);
+        uint64_t key = RandomUtil<int64_t>::RandomInt64(0, keyCount - 1);
+        double score = RandomUtil<int64_t>::RandomInt64(1, 100);
+        auto it = refMap.find(key);
+        if (it != refMap.end() && it->second.second + ttl <= now) {
+            refMap.erase(it);
+            it = refMap.end();
+        }
+        if (it == refMap.end()) {
+            refMap[key] = make_pair(score, now);
+        }
+        else {
+            it->second.first = it->second.first * std::exp(-decayRate * (now - it->second.second)) + score;
+            it->second.second = now;
+        }
+        CPPUNIT_ASSERT(topN.Add(key, score, now));
+
+        if (i % 1000 == 999) {
+            vector<pair<double, uint64_t> > expected;
+            for (auto& kv : refMap) {
+                if (kv.second.second + ttl > now) {
+                    expected.push_back(make_pair(kv.second.first * std::exp(-decayRate * (now - kv.second.second)), kv.first));
+                }
+            }
+            std::sort(expected.rbegin(), expected.rend());
+            vector<pair<uint64_t, double> > result;
+            topN.GetTopN(now, result);
+            CPPUNIT_ASSERT_EQUAL(expected.size(), result.size());
+            for (size_t j = 0; j < result.size(); ++j) {
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[j].first, result[j].second, 1e-6 * expected[j].first);
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[j].first, topN.ScoreOf(expected[j].second, now), 1e-6 * expected[j].first);
+            }
+        }
+    }
+}
+
+void DecayedTopNTest::PerformanceTest() {
+    /// trending items: decaying by log domain, against rewriting every score by *Update* on each tick. Time advances
+    /// one tick per add, so both decay exactly the same and must keep the same TopN.
+    size_t topNCount = 1e3, keyCount = 5e3, opCount = 2e4;
+    int64_t halfLife = 1e4, ttl = 1e9;
+    vector<uint64_t> keys;
+    for (size_t i = 0; i < opCount; ++i) {
+        keys.push_back(RandomUtil<int64_t>::RandomInt64(0, keyCount - 1));
+    }
+
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    DecayedTopN<uint64_t> topN(topNCount, halfLife, ttl);
+    for (size_t i = 0; i < opCount; ++i) {
+        topN.Add(keys[i], 1, i);
+    }
+    int64_t tLogDomain = TimeUtil::CurrentTimeInMicroSeconds();
+
+    /// plain scores decayed by a full rewrite every tick
+    typedef DecayedTopN<uint64_t>::Entry Entry;
+    IndexedPriorityQueue<Entry, DecayedTopN<uint64_t>::EntryComparator> pq(topNCount, 1, true);
+    IndexedPQHashMap<uint64_t, size_t> key2HtMap(topNCount);
+    double tickFactor = std::exp(-std::log(2.0) / halfLife);
+    for (size_t i = 0; i < opCount; ++i) {
+        for (size_t j = 0; j < pq.GetCount(); ++j) {
+            size_t ht = pq.GetElementsArray()[j];
+            Entry entry = pq.Elem(ht);
+            entry.m_logScore *= tickFactor;
+            pq.Update(ht, entry);
+        }
+        size_t* pHt = key2HtMap.Find(keys[i]);
+        if (nullptr != pHt) {
+            Entry entry = pq.Elem(*pHt);
+            entry.m_logScore += 1;
+            pq.Update(*pHt, entry);
+            continue;
+        }
+        Entry entry{keys[i], 1}, removedEntry;
+        if (pq.IsNotNeedPushWhenSeekFixedTopN(entry)) {
+            continue;
+        }
+        bool isFull = pq.IsFull();
+        size_t ht = pq.Push(entry, &removedEntry);
+        if (ht == pq.INVALID_HANDLE) {
+            continue;
+        }
+        if (isFull) { key2HtMap.Erase(removedEntry.m_key); }
+        key2HtMap.Insert(keys[i], ht);
+    }
+    int64_t tRewrite = TimeUtil::CurrentTimeInMicroSeconds();
+    cout << "-------------opCount:[" << opCount << "],topN:[" << topNCount << "],log domain:["
+         << (tLogDomain - tBegin) / 1000 << "]ms,rewrite per tick:[" << (tRewrite - tLogDomain) / 1000 << "]ms." << endl;
+
+    vector<pair<uint64_t, double> > result;
+    topN.GetTopN(opCount - 1, result);
+    vector<Entry> expected;
+    for (size_t i = 0; i < pq.GetCount(); ++i) {
+        expected.push_back(pq.ElemAtHeap(i));
+    }
+    std::sort(expected.begin(), expected.end(), DecayedTopN<uint64_t>::EntryComparator());
+    CPPUNIT_ASSERT_EQUAL(topNCount, result.size());
+    CPPUNIT_ASSERT_EQUAL(expected.size(), result.size());
+    for (size_t i = 0; i < result.size(); ++i) {
+        CPPUNIT_ASSERT_EQUAL(expected[i].m_key, result[i].first);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[i].m_logScore, result[i].second, 1e-9 * expected[i].m_logScore);
+    }
+}
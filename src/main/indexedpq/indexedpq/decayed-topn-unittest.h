@@ -0,0 +1,28 @@
+#ifndef __INDEXEDPQ_TEST_DECAYED_TOPN_UNITTEST_H__
+#define __INDEXEDPQ_TEST_DECAYED_TOPN_UNITTEST_H__
+
+#include "indexedpq/decayed-topn.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+class DecayedTopNTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(DecayedTopNTest);
+    CPPUNIT_TEST(DecayTest);
+    CPPUNIT_TEST(ExpiryTest);
+    CPPUNIT_TEST(TopNTest);
+    CPPUNIT_TEST(PerformanceTest);
+    CPPUNIT_TEST_SUITE_END();
+public:
+    DecayedTopNTest() {}
+    ~DecayedTopNTest() {}
+    void setUp() {}
+    void tearDown() {}
+public:
+
+    void DecayTest();
+    void ExpiryTest();
+    void TopNTest();
+    void PerformanceTest();
+};
+
+
+#endif //__INDEXEDPQ_TEST_DECAYED_TOPN_UNITTEST_H__
@@ -0,0 +1,183 @@
+#ifndef __INDEXEDPQ_DECAYED_TOPN_H__
+#define __INDEXEDPQ_DECAYED_TOPN_H__
+
+#include "indexedpq/indexed-priority-queue.h"
+#include "indexedpq/indexed-pq-hash-map.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/**
+ *@brief     TopN keys by exponentially decayed score, with expiry of keys not added within a TTL. Score *s* added at
+ *           time *t* is worth s*exp(-lambda*(now-t)) at time *now*, where lambda is ln2 divided by *halfLife*.
+ *           Scores are kept in log domain as ln(s)+lambda*t, which does not change with time, so all scores decay at
+ *           once without any rewrite, and the order of log scores is the order of decayed scores at any time. Adding
+ *           to a key is a log-sum-exp of its log score.
+ *           A fixed IndexedPriorityQueue keeps the TopN log scores and an expiry IndexedPriorityQueue keeps the expiry
+ *           time of every kept key. Expired keys are evicted lazily by *Add* and *GetTopN*, all expired ones in one
+ *           batch of the score queue. As in DedupTopN, a key evicted by better ones loses its accumulated score.
+ *           Times are integers of any unit, e.g. milliseconds, as long as *halfLife* and *ttl* are of the same unit.
+ */
+template <class Key, class HashFunc = std::hash<Key>, class Policy = IndexedPQDefaultPolicy >
+class DecayedTopN
+{
+public:
+    typedef Key                 KEY_TYPE;
+    /// key and its log score
+    struct Entry {
+        Key         m_key;
+        double      m_logScore;
+    };
+    /// higher log score ranks before, so the top of fixed score queue is the worst kept key
+    struct EntryComparator {
+        bool operator() (const Entry& a, const Entry& b) const { return a.m_logScore > b.m_logScore; }
+    };
+    typedef IndexedPriorityQueue<Entry, EntryComparator, Policy>      QUEUE_TYPE;
+    typedef typename QUEUE_TYPE::HANDLE_TYPE                          HANDLE_TYPE;
+    /// expiry time of key of score handle
+    struct Expiry {
+        int64_t         m_expireTime;
+        HANDLE_TYPE     m_scoreHt;
+    };
+    /// earlier expiry time on top
+    struct ExpiryComparator {
+        bool operator() (const Expiry& a, const Expiry& b) const { return a.m_expireTime > b.m_expireTime; }
+    };
+    typedef IndexedPriorityQueue<Expiry, ExpiryComparator, Policy>    EXPIRY_QUEUE_TYPE;
+
+public:
+    /**
+     *@param     topN --- count of keys to keep.
+     *@param     halfLife --- time for score to decay to half, scores do not decay if it is not positive.
+     *@param     ttl --- keys not added for *ttl* expire.
+     */
+    DecayedTopN(size_t topN, double halfLife, int64_t ttl, HashFunc hashFunc = HashFunc())
+        : m_queue(topN, 1, true), m_expiryQueue(topN, 1), m_expiryHtVec(std::max<size_t>(topN, 1)),
+          m_key2HtMap(topN, hashFunc), m_decayRate(halfLife > 0 ? std::log(2.0) / halfLife : 0), m_ttl(ttl) {}
+
+    inline size_t GetCount() { return m_queue.GetCount(); }
+    inline bool   IsEmpty() { return m_queue.IsEmpty(); }
+    /// decay rate lambda of scores per time unit
+    inline double GetDecayRate() { return m_decayRate; }
+
+    /// clear all keys
+    void Reset() { m_queue.Reset(); m_expiryQueue.Reset(); m_key2HtMap.Clear(); }
+
+    /**
+     *@brief     add positive *score* to *key* at time *now*, and renew its expiry time to *now* + *ttl*. Times of
+     *           calls should not go backwards, expired keys are evicted firstly.
+     *@return    true if the key is kept in TopN.
+     */
+    bool Add(const Key& key, double score, int64_t now);
+
+    /// evict keys expired at time *now*, return count of evicted keys
+    size_t Expire(int64_t now);
+
+    /// decayed score of *key* at time *now*, 0 if it is not kept
+    double ScoreOf(const Key& key, int64_t now) {
+        HANDLE_TYPE* pHt = m_key2HtMap.Find(key);
+        return nullptr == pHt ? 0 : DecayedScore(m_queue.Elem(*pHt).m_logScore, now);
+    }
+
+    /// evict keys expired at time *now*, and output kept keys with decayed scores at *now* in rank order, best first.
+    void GetTopN(int64_t now, std::vector<std::pair<Key, double> >& result);
+
+private:
+    inline double LogScore(double score, int64_t now) { return std::log(score) + m_decayRate * (double)now; }
+    inline double DecayedScore(double logScore, int64_t now) { return std::exp(logScore - m_decayRate * (double)now); }
+    /// ln(exp(a) + exp(b)) without overflow
+    static inline double LogAddExp(double a, double b) {
+        double hi = std::max(a, b);
+        return hi + std::log1p(std::exp(std::min(a, b) - hi));
+    }
+    /// expiry handle of score handle *ht*, handles of fixed queue are less than *topN*
+    inline HANDLE_TYPE& ExpiryHt(HANDLE_TYPE ht) { return m_expiryHtVec[ht & QUEUE_TYPE::SLOT_MASK]; }
+
+private:
+    QUEUE_TYPE                                      m_queue;            /// fixed TopN log scores, top is the worst
+    EXPIRY_QUEUE_TYPE                               m_expiryQueue;      /// expiry times, top is the earliest
+    std::vector<HANDLE_TYPE>                        m_expiryHtVec;      /// score handle slot to expiry handle
+    IndexedPQHashMap<Key, HANDLE_TYPE, HashFunc>    m_key2HtMap;        /// key to score handle
+    double                                          m_decayRate;
+    int64_t                                         m_ttl;
+};
+
+template <class Key, class HashFunc, class Policy>
+bool DecayedTopN<Key, HashFunc, Policy>::Add(const Key& key, double score, int64_t now) {
+    assert(score > 0);
+    if (!m_expiryQueue.IsEmpty() && m_expiryQueue.TopElem().m_expireTime <= now) {
+        Expire(now);
+    }
+    Entry entry{key, LogScore(score, now)};
+    Expiry expiry{now + m_ttl, QUEUE_TYPE::INVALID_HANDLE};
+    HANDLE_TYPE* pHt = m_key2HtMap.Find(key);
+    if (nullptr != pHt) {
+        HANDLE_TYPE ht = *pHt;
+        entry.m_logScore = LogAddExp(m_queue.Elem(ht).m_logScore, entry.m_logScore);
+        m_queue.Update(ht, entry);
+        expiry.m_scoreHt = ht;
+        m_expiryQueue.Update(ExpiryHt(ht), expiry);
+        return true;
+    }
+    if (m_queue.IsNotNeedPushWhenSeekFixedTopN(entry)) {
+        return false;
+    }
+    bool isFull = m_queue.IsFull();
+    Entry removedEntry;
+    HANDLE_TYPE ht = m_queue.Push(entry, &removedEntry);
+    if (ht == QUEUE_TYPE::INVALID_HANDLE) {
+        return false;
+    }
+    expiry.m_scoreHt = ht;
+    if (isFull) {
+        /// the new key takes over the handle of the evicted one, and so its expiry entry
+        m_key2HtMap.Erase(removedEntry.m_key);
+        m_expiryQueue.Update(ExpiryHt(ht), expiry);
+    }
+    else {
+        ExpiryHt(ht) = m_expiryQueue.Push(expiry);
+    }
+    m_key2HtMap.Insert(key, ht);
+    return true;
+}
+
+template <class Key, class HashFunc, class Policy>
+size_t DecayedTopN<Key, HashFunc, Policy>::Expire(int64_t now) {
+    size_t expiredCnt = 0;
+    Entry removedEntry;
+    while (!m_expiryQueue.IsEmpty() && m_expiryQueue.TopElem().m_expireTime <= now) {
+        HANDLE_TYPE ht = m_expiryQueue.TopElem().m_scoreHt;
+        m_expiryQueue.Pop();
+        /// heap of scores is restored once for all expired keys
+        if (0 == expiredCnt++) {
+            m_queue.BeginBatch();
+        }
+        m_queue.Remove(ht, &removedEntry);
+        m_key2HtMap.Erase(removedEntry.m_key);
+    }
+    if (expiredCnt > 0) {
+        m_queue.CommitBatch();
+    }
+    return expiredCnt;
+}
+
+template <class Key, class HashFunc, class Policy>
+void DecayedTopN<Key, HashFunc, Policy>::GetTopN(int64_t now, std::vector<std::pair<Key, double> >& result) {
+    Expire(now);
+    std::vector<Entry> entries;
+    entries.reserve(m_queue.GetCount());
+    for (size_t i = 0; i < m_queue.GetCount(); ++i) {
+        entries.push_back(m_queue.ElemAtHeap(i));
+    }
+    std::sort(entries.begin(), entries.end(), EntryComparator());
+    result.clear();
+    result.reserve(entries.size());
+    for (const Entry& entry : entries) {
+        result.push_back(std::make_pair(entry.m_key, DecayedScore(entry.m_logScore, now)));
+    }
+}
+
+#endif //__INDEXEDPQ_DECAYED_TOPN_H__
@@ -0,0 +1,145 @@
+#include "indexedpq/dedup-topn-unittest.h"
+#include "indexedpq/indexed-priority-queue-unittest.h"
+#include <cppunit/TestAssert.h>
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+CPPUNIT_TEST_SUITE_REGISTRATION(DedupTopNTest);
+
+class FakeItemFlag {
+public:
+    uint64_t operator() (const FakeItem & item) { return item.m_flag; }
+};
+
+void DedupTopNTest::HashMapTest() {
+    size_t maxCount = 1000;
+    IndexedPQHashMap<uint64_t, size_t> hashMap(maxCount);
+    unordered_map<uint64_t, size_t> stdMap;
+    CPPUNIT_ASSERT(hashMap.IsEmpty());
+    for (size_t i = 0; i < 200000; ++i) {
+        /// small key range makes long clusters, which exercises backward shift deletion
+        uint64_t key = RandomUtil<int64_t>::RandomInt64(0, 3000) * 1024;
+        if (RandomUtil<int64_t>::RandomInt64(0, 1) == 0 && stdMap.size() < maxCount) {
+            size_t* pValue = hashMap.Insert(key, i);
+            auto ret = stdMap.emplace(key, i);
+            CPPUNIT_ASSERT_EQUAL(ret.first->second, *pValue);
+        }
+        else {
+            CPPUNIT_ASSERT_EQUAL(stdMap.erase(key) > 0, hashMap.Erase(key));
+        }
+        CPPUNIT_ASSERT_EQUAL(stdMap.size(), hashMap.GetCount());
+        if (i % 1000 == 0) {
+            for (uint64_t k = 0; k <= 3000; ++k) {
+                size_t* pValue = hashMap.Find(k * 1024);
+                auto it = stdMap.find(k * 1024);
+                CPPUNIT_ASSERT_EQUAL(it != stdMap.end(), nullptr != pValue);
+                if (nullptr != pValue) {
+                    CPPUNIT_ASSERT_EQUAL(it->second, *pValue);
+                }
+            }
+        }
+    }
+    size_t iterCount = 0;
+    hashMap.ForEach([&](const uint64_t& key, size_t& value) {
+        CPPUNIT_ASSERT_EQUAL(stdMap[key], value);
+        ++iterCount;
+    });
+    CPPUNIT_ASSERT_EQUAL(stdMap.size(), iterCount);
+    hashMap.Clear();
+    CPPUNIT_ASSERT(hashMap.IsEmpty());
+    CPPUNIT_ASSERT(nullptr == hashMap.Find(0));
+}
+
+void DedupTopNTest::InternalTopNTest(size_t itemCount, size_t flagCount, size_t topN) {
+    std::vector<FakeItem> itemsVec, topNItemsVec, allTopItemsVec;
+    FakeItemMgr::sGenItems(itemCount, flagCount, itemsVec);
+    FakeItemComparator itemComparator;
+    DedupTopN<FakeItem, FakeItemFlag, FakeItemComparator> topNItems(topN);
+    for (size_t times = 0; times < 2; ++times) {
+        topNItems.Reset();
+        for (size_t i = 0; i < itemCount; ++i) {
+            topNItems.Push(itemsVec[i]);
+        }
+        topNItems.GetSortedElems(topNItemsVec);
+
+        map<uint64_t, FakeItem> flag2itemsAllMap;
+        for (size_t i = 0; i < itemCount; ++i) {
+            FakeItem & item = itemsVec[i];
+            auto it = flag2itemsAllMap.find(item.m_flag);
+            if (it == flag2itemsAllMap.end() || itemComparator(item, it->second)) {
+                flag2itemsAllMap[item.m_flag] = item;
+            }
+        }
+        allTopItemsVec.clear();
+        for (auto it : flag2itemsAllMap) {
+            allTopItemsVec.push_back(it.second);
+        }
+        std::sort(allTopItemsVec.begin(), allTopItemsVec.end(), itemComparator);
+        size_t realTopN = std::min(topN, allTopItemsVec.size());
+        CPPUNIT_ASSERT_EQUAL(realTopN, topNItemsVec.size());
+        for (size_t i = 0; i < realTopN; ++i) {
+            CPPUNIT_ASSERT(allTopItemsVec[i] == topNItemsVec[i]);
+            CPPUNIT_ASSERT(topNItems.Contains(topNItemsVec[i].m_flag));
+            CPPUNIT_ASSERT(topNItemsVec[i] == topNItems.ElemOfKey(topNItemsVec[i].m_flag));
+        }
+        if (realTopN < allTopItemsVec.size()) {
+            CPPUNIT_ASSERT(!topNItems.Contains(allTopItemsVec[realTopN].m_flag));
+        }
+    }
+}
+
+void DedupTopNTest::TopNTest() {
+    InternalTopNTest(2e4, 2e3, 400);
+    InternalTopNTest(2e4, 2e2, 300);
+    InternalTopNTest(2e3, 2e1, 80);
+    InternalTopNTest(2e3, 2e3, 1);
+    InternalTopNTest(200, 200, 1000);
+}
+
+void DedupTopNTest::PerformanceTest() {
+    size_t itemCount = 1e6, flagCount = 2e5, topN = 1000;
+    std::vector<FakeItem> itemsVec;
+    FakeItemMgr::sGenItems(itemCount, flagCount, itemsVec);
+    FakeItemComparator itemComparator;
+
+    /// the pattern of *InternalTopNRemoveDuplicateTest* with std::map
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    IndexedPriorityQueue<FakeItem, FakeItemComparator> queue(topN, 128, true);
+    std::map<uint64_t, size_t> flag2PqHtMap;
+    for (size_t i = 0; i < itemCount; ++i) {
+        FakeItem & item = itemsVec[i];
+        if (queue.IsNotNeedPushWhenSeekFixedTopN(item)) {
+            continue;
+        }
+        auto it = flag2PqHtMap.find(item.m_flag);
+        if (it == flag2PqHtMap.end()) {
+            FakeItem oldItem;
+            oldItem.m_flag = string::npos;
+            auto ht = queue.Push(item, &oldItem);
+            if (queue.IsValid(ht)) {
+                if (oldItem.m_flag != string::npos) {
+                    flag2PqHtMap.erase(oldItem.m_flag);
+                }
+                flag2PqHtMap.emplace(item.m_flag, ht);
+            }
+        }
+        else if (itemComparator(item, queue.Elem(it->second))) {
+            queue.Update(it->second, item);
+        }
+    }
+    int64_t tMap = TimeUtil::CurrentTimeInMicroSeconds();
+    DedupTopN<FakeItem, FakeItemFlag, FakeItemComparator> topNItems(topN);
+    for (size_t i = 0; i < itemCount; ++i) {
+        topNItems.Push(itemsVec[i]);
+    }
+    int64_t tDedup = TimeUtil::CurrentTimeInMicroSeconds();
+    cout << "-------------itemCount:[" << itemCount << "],flagCount:[" << flagCount << "],topN:[" << topN
+         << "],std::map consumed time:[" << (tMap - tBegin) / 1000 << "]ms,DedupTopN consumed time:["
+         << (tDedup - tMap) / 1000 << "]ms." << endl;
+    CPPUNIT_ASSERT_EQUAL(queue.GetCount(), topNItems.GetCount());
+    FakeItem topItem = queue.TopElem();
+    CPPUNIT_ASSERT(topItem == topNItems.GetQueue().TopElem());
+}
@@ -0,0 +1,29 @@
+#ifndef __INDEXEDPQ_TEST_DEDUP_TOPN_UNITTEST_H__
+#define __INDEXEDPQ_TEST_DEDUP_TOPN_UNITTEST_H__
+
+#include "indexedpq/dedup-topn.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+class DedupTopNTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(DedupTopNTest);
+    CPPUNIT_TEST(HashMapTest);
+    CPPUNIT_TEST(TopNTest);
+    CPPUNIT_TEST(PerformanceTest);
+    CPPUNIT_TEST_SUITE_END();
+public:
+    DedupTopNTest() {}
+    ~DedupTopNTest() {}
+    void setUp() {}
+    void tearDown() {}
+public:
+
+    void HashMapTest();
+    void TopNTest();
+    void PerformanceTest();
+
+private:
+    void InternalTopNTest(size_t itemCount, size_t flagCount, size_t topN);
+};
+
+
+#endif //__INDEXEDPQ_TEST_DEDUP_TOPN_UNITTEST_H__
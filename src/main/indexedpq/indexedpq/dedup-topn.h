@@ -0,0 +1,94 @@
+#ifndef __INDEXEDPQ_DEDUP_TOPN_H__
+#define __INDEXEDPQ_DEDUP_TOPN_H__
+
+#include "indexedpq/indexed-priority-queue.h"
+#include "indexedpq/indexed-pq-hash-map.h"
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+/**
+ *@brief     TopN elements deduplicated by key, which fuses a fixed IndexedPriorityQueue with an open-addressing index
+ *           from dedup key to handle. Only keys of elements currently in the queue are indexed, so memory is bounded
+ *           by *topN*: an element whose key was evicted can not be better than the remaining ones.
+ *           *CompareFunc(a, b)* is true if *a* ranks before *b*, the queue top is the worst kept element.
+ *           *KeyFunc(elem)* returns the dedup key of element.
+ */
+template <class T, class KeyFunc, class CompareFunc, class Policy = IndexedPQDefaultPolicy >
+class DedupTopN
+{
+public:
+    typedef T                                                          VALUE_TYPE;
+    typedef typename std::decay<decltype(std::declval<KeyFunc&>()(std::declval<const T&>()))>::type KEY_TYPE;
+    typedef IndexedPriorityQueue<T, CompareFunc, Policy>              QUEUE_TYPE;
+    typedef typename QUEUE_TYPE::HANDLE_TYPE                           HANDLE_TYPE;
+
+public:
+    DedupTopN(size_t topN, CompareFunc compareFunc = CompareFunc(), KeyFunc keyFunc = KeyFunc())
+        : m_queue(topN, 1, true, compareFunc), m_key2HtMap(topN), m_valueCmpFunc(compareFunc), m_keyFunc(keyFunc) {}
+
+    inline size_t GetCount() { return m_queue.GetCount(); }
+    inline bool   IsEmpty() { return m_queue.IsEmpty(); }
+    /// underlying queue, elements can be iterated unsorted by *ElemAtHeap*
+    inline QUEUE_TYPE& GetQueue() { return m_queue; }
+
+    /// clear all elements and keys
+    void Reset() { m_queue.Reset(); m_key2HtMap.Clear(); }
+
+    /**
+     *@brief     offer an element, keep the best element for every key.
+     *@return    true if the element is kept in TopN.
+     */
+    bool Push(const T& elem) {
+        if (m_queue.IsNotNeedPushWhenSeekFixedTopN(elem)) {
+            return false;
+        }
+        KEY_TYPE key = m_keyFunc(elem);
+        HANDLE_TYPE* pHt = m_key2HtMap.Find(key);
+        if (nullptr != pHt) {
+            if (m_valueCmpFunc(elem, m_queue.Elem(*pHt))) {
+                m_queue.Update(*pHt, elem);
+                return true;
+            }
+            return false;
+        }
+        bool isFull = m_queue.IsFull();
+        T removedElem;
+        HANDLE_TYPE ht = m_queue.Push(elem, &removedElem);
+        if (ht == QUEUE_TYPE::INVALID_HANDLE) {
+            return false;
+        }
+        if (isFull) {
+            m_key2HtMap.Erase(m_keyFunc(removedElem));
+        }
+        m_key2HtMap.Insert(key, ht);
+        return true;
+    }
+
+    /// whether there is an element of *key* in TopN
+    bool Contains(const KEY_TYPE& key) { return nullptr != m_key2HtMap.Find(key); }
+    /// element of *key*, which must be contained
+    const T& ElemOfKey(const KEY_TYPE& key) {
+        HANDLE_TYPE* pHt = m_key2HtMap.Find(key);
+        assert(nullptr != pHt);
+        return m_queue.Elem(*pHt);
+    }
+
+    /// output TopN elements in rank order, best first, the queue is kept untouched.
+    void GetSortedElems(std::vector<T>& elems) {
+        elems.clear();
+        elems.reserve(m_queue.GetCount());
+        for (size_t i = 0; i < m_queue.GetCount(); ++i) {
+            elems.push_back(m_queue.ElemAtHeap(i));
+        }
+        std::sort(elems.begin(), elems.end(), m_valueCmpFunc);
+    }
+
+private:
+    QUEUE_TYPE                                  m_queue;            /// fixed TopN queue, top is the worst
+    IndexedPQHashMap<KEY_TYPE, HANDLE_TYPE>     m_key2HtMap;        /// dedup key to handle of elements in m_queue
+    CompareFunc                                 m_valueCmpFunc;
+    KeyFunc                                     m_keyFunc;
+};
+
+#endif //__INDEXEDPQ_DEDUP_TOPN_H__
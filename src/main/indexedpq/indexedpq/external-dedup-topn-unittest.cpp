@@ -0,0 +1,120 @@
+#include "indexedpq/external-dedup-topn-unittest.h"
+#include "indexedpq/indexed-priority-queue-unittest.h"
+#include <cppunit/TestAssert.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <dirent.h>
+
+using namespace std;
+CPPUNIT_TEST_SUITE_REGISTRATION(ExternalDedupTopNTest);
+
+namespace {
+class FakeItemFlag {
+public:
+    uint64_t operator() (const FakeItem & item) { return item.m_flag; }
+};
+
+/// count of spill files left in current directory
+size_t CountSpillFiles() {
+    size_t count = 0;
+    DIR* pDir = opendir(".");
+    for (struct dirent* pEntry = readdir(pDir); nullptr != pEntry; pEntry = readdir(pDir)) {
+        if (0 == strncmp(pEntry->d_name, "indexedpq_spill_", 16)) { ++count; }
+    }
+    closedir(pDir);
+    return count;
+}
+}
+
+void ExternalDedupTopNTest::InternalTopNTest(size_t itemCount, size_t flagCount, size_t topN, size_t partitionCount,
+                                             size_t bufferElemCount) {
+    vector<FakeItem> itemsVec, topNItemsVec, allTopItemsVec;
+    FakeItemMgr::sGenItems(itemCount, flagCount, itemsVec);
+    FakeItemComparator itemComparator;
+    ExternalDedupTopN<FakeItem, FakeItemFlag, FakeItemComparator> topNItems(topN, ".", partitionCount, bufferElemCount);
+    map<uint64_t, FakeItem> flag2itemsAllMap;
+    for (size_t i = 0; i < itemCount; ++i) {
+        FakeItem & item = itemsVec[i];
+        auto it = flag2itemsAllMap.find(item.m_flag);
+        if (it == flag2itemsAllMap.end() || itemComparator(item, it->second)) {
+            flag2itemsAllMap[item.m_flag] = item;
+        }
+    }
+    for (auto it : flag2itemsAllMap) {
+        allTopItemsVec.push_back(it.second);
+    }
+    std::sort(allTopItemsVec.begin(), allTopItemsVec.end(), itemComparator);
+    size_t realTopN = std::min(topN, allTopItemsVec.size());
+
+    /// the stage is reusable after *Finish*
+    for (size_t times = 0; times < 2; ++times) {
+        for (size_t i = 0; i < itemCount; ++i) {
+            CPPUNIT_ASSERT(topNItems.Push(itemsVec[i]));
+        }
+        CPPUNIT_ASSERT_EQUAL(itemCount, topNItems.GetPushedCount());
+        CPPUNIT_ASSERT(topNItems.Finish(topNItemsVec));
+        CPPUNIT_ASSERT_EQUAL((size_t)0, CountSpillFiles());
+        CPPUNIT_ASSERT_EQUAL(realTopN, topNItemsVec.size());
+        for (size_t i = 0; i < realTopN; ++i) {
+            CPPUNIT_ASSERT(allTopItemsVec[i] == topNItemsVec[i]);
+        }
+    }
+}
+
+void ExternalDedupTopNTest::TopNTest() {
+    InternalTopNTest(2e4, 2e3, 400, 16, 64);
+    InternalTopNTest(2e4, 2e2, 300, 7, 1);
+    InternalTopNTest(2e3, 2e1, 80, 64, 4096);
+    InternalTopNTest(2e3, 2e3, 1, 3, 10);
+    InternalTopNTest(200, 200, 1000, 1, 16);
+    InternalTopNTest(0, 1, 10, 4, 16);
+}
+
+void ExternalDedupTopNTest::FailureTest() {
+    ExternalDedupTopN<FakeItem, FakeItemFlag, FakeItemComparator> topNItems(10, "./not_exist_dir", 4, 2);
+    vector<FakeItem> itemsVec, topNItemsVec;
+    FakeItemMgr::sGenItems(100, 100, itemsVec);
+    bool isOk = true;
+    for (size_t i = 0; i < itemsVec.size(); ++i) {
+        isOk = topNItems.Push(itemsVec[i]) && isOk;
+    }
+    CPPUNIT_ASSERT(!isOk);
+    CPPUNIT_ASSERT(topNItems.IsFailed());
+    CPPUNIT_ASSERT(!topNItems.Finish(topNItemsVec));
+    CPPUNIT_ASSERT(topNItemsVec.empty());
+    /// failure is kept until Reset
+    CPPUNIT_ASSERT(topNItems.IsFailed());
+    CPPUNIT_ASSERT(!topNItems.Push(itemsVec[0]));
+    CPPUNIT_ASSERT(!topNItems.Finish(topNItemsVec));
+    topNItems.Reset();
+    CPPUNIT_ASSERT(!topNItems.IsFailed());
+    CPPUNIT_ASSERT_EQUAL((size_t)0, topNItems.GetPushedCount());
+}
+
+void ExternalDedupTopNTest::PerformanceTest() {
+    size_t itemCount = 1e6, flagCount = 2e5, topN = 1000;
+    vector<FakeItem> itemsVec, topNItemsVec, externalTopNItemsVec;
+    FakeItemMgr::sGenItems(itemCount, flagCount, itemsVec);
+
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    DedupTopN<FakeItem, FakeItemFlag, FakeItemComparator> topNItems(topN);
+    for (size_t i = 0; i < itemCount; ++i) {
+        topNItems.Push(itemsVec[i]);
+    }
+    topNItems.GetSortedElems(topNItemsVec);
+    int64_t tMemory = TimeUtil::CurrentTimeInMicroSeconds();
+    ExternalDedupTopN<FakeItem, FakeItemFlag, FakeItemComparator> externalTopNItems(topN, ".", 64, 4096);
+    for (size_t i = 0; i < itemCount; ++i) {
+        externalTopNItems.Push(itemsVec[i]);
+    }
+    CPPUNIT_ASSERT(externalTopNItems.Finish(externalTopNItemsVec));
+    int64_t tExternal = TimeUtil::CurrentTimeInMicroSeconds();
+    CPPUNIT_ASSERT_EQUAL(topNItemsVec.size(), externalTopNItemsVec.size());
+    for (size_t i = 0; i < topNItemsVec.size(); ++i) {
+        CPPUNIT_ASSERT(topNItemsVec[i] == externalTopNItemsVec[i]);
+    }
+    cout << endl << "-------------itemCount:[" << itemCount << "],flagCount:[" << flagCount << "],topN:[" << topN
+         << "],in memory DedupTopN:[" << (tMemory - tBegin) / 1000 << "]ms,ExternalDedupTopN(64 partitions):["
+         << (tExternal - tMemory) / 1000 << "]ms." << endl;
+}
@@ -0,0 +1,29 @@
+#ifndef __INDEXEDPQ_TEST_EXTERNAL_DEDUP_TOPN_UNITTEST_H__
+#define __INDEXEDPQ_TEST_EXTERNAL_DEDUP_TOPN_UNITTEST_H__
+
+#include "indexedpq/external-dedup-topn.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+class ExternalDedupTopNTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(ExternalDedupTopNTest);
+    CPPUNIT_TEST(TopNTest);
+    CPPUNIT_TEST(FailureTest);
+    CPPUNIT_TEST(PerformanceTest);
+    CPPUNIT_TEST_SUITE_END();
+public:
+    ExternalDedupTopNTest() {}
+    ~ExternalDedupTopNTest() {}
+    void setUp() {}
+    void tearDown() {}
+public:
+
+    void TopNTest();
+    void FailureTest();
+    void PerformanceTest();
+
+private:
+    void InternalTopNTest(size_t itemCount, size_t flagCount, size_t topN, size_t partitionCount, size_t bufferElemCount);
+};
+
+
+#endif //__INDEXEDPQ_TEST_EXTERNAL_DEDUP_TOPN_UNITTEST_H__
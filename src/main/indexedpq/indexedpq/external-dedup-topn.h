@@ -0,0 +1,278 @@
+#ifndef __INDEXEDPQ_EXTERNAL_DEDUP_TOPN_H__
+#define __INDEXEDPQ_EXTERNAL_DEDUP_TOPN_H__
+
+#include "indexedpq/dedup-topn.h"
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <unistd.h>
+
+/**
+ *@brief     deduplicated TopN over inputs larger than memory. *Push* hash-partitions elements by dedup key into spill
+ *           files, so all elements of one key land in the same partition. *Finish* then runs a DedupTopN over every
+ *           partition in turn, writes its sorted TopN to a run file, and k-way merges the run files into the global
+ *           TopN. Memory is bounded by *partitionCount* buffers of *bufferElemCount* elements plus one DedupTopN,
+ *           whatever the input size, and all file I/O is sequential.
+ *           Elements are spilled as raw bytes, so *T* must be trivially copyable.
+ *           *CompareFunc(a, b)* is true if *a* ranks before *b*, *KeyFunc(elem)* returns the dedup key of element.
+ */
+template <class T, class KeyFunc, class CompareFunc, class Policy = IndexedPQDefaultPolicy,
+          class HashFunc = std::hash<typename DedupTopN<T, KeyFunc, CompareFunc, Policy>::KEY_TYPE> >
+class ExternalDedupTopN
+{
+public:
+    typedef T                                                   VALUE_TYPE;
+    typedef DedupTopN<T, KeyFunc, CompareFunc, Policy>          PARTITION_TOPN_TYPE;
+    typedef typename PARTITION_TOPN_TYPE::KEY_TYPE              KEY_TYPE;
+    static_assert(std::is_trivially_copyable<T>::value, "spilled elements must be trivially copyable");
+
+public:
+    /**
+     *@param     topN --- count of elements to keep, one per key.
+     *@param     spillDir --- directory of spill and run files, which are removed by *Finish* or destructor.
+     *@param     partitionCount --- count of spill files, every partition should have few enough keys that its
+     *                              elements are read in reasonable time, the DedupTopN memory does not depend on it.
+     *@param     bufferElemCount --- elements buffered per partition before written, also the read chunk of merge.
+     */
+    ExternalDedupTopN(size_t topN, const std::string& spillDir, size_t partitionCount = 64, size_t bufferElemCount = 4096,
+                      CompareFunc compareFunc = CompareFunc(), KeyFunc keyFunc = KeyFunc(), HashFunc hashFunc = HashFunc());
+    ~ExternalDedupTopN() { RemoveFiles(); }
+    ExternalDedupTopN(const ExternalDedupTopN&) = delete;
+    ExternalDedupTopN& operator=(const ExternalDedupTopN&) = delete;
+
+    /// count of elements pushed since construction or last *Finish*
+    inline size_t GetPushedCount() { return m_pushedCnt; }
+    /// whether any spill file failed, *Push* and *Finish* return false afterwards until *Reset*
+    inline bool   IsFailed() { return m_isFailed; }
+
+    /// drop all pushed elements and remove all files, and clear the failure, e.g. to retry after a failure
+    void Reset() { RemoveFiles(); m_isFailed = false; }
+
+    /// spill *elem* to its partition, return false on I/O failure
+    bool Push(const T& elem) {
+        if (m_isFailed) {
+            return false;
+        }
+        Partition& partition = m_partitions[PartitionOf(elem)];
+        partition.m_buffer.push_back(elem);
+        ++m_pushedCnt;
+        if (partition.m_buffer.size() >= m_bufferElemCnt) {
+            return FlushPartition(partition);
+        }
+        return true;
+    }
+
+    /**
+     *@brief     compute TopN of all pushed elements and remove all files, the stage can be reused afterwards unless
+     *           it failed, see *IsFailed*.
+     *@param     result --- TopN elements in rank order, best first, one per key.
+     *@return    false on I/O failure, *result* is empty then.
+     */
+    bool Finish(std::vector<T>& result);
+
+private:
+    /// spill file of one partition, reused as its run file after the partition is reduced
+    struct Partition {
+        std::string         m_path;
+        FILE*               m_pFile = nullptr;
+        std::vector<T>      m_buffer;           /// elements to be written, or chunk being merged
+        size_t              m_bufferPos = 0;    /// cursor in m_buffer when merging
+        size_t              m_elemCnt = 0;      /// elements written to file
+        size_t              m_readCnt = 0;      /// elements of run file read when merging
+    };
+
+    /// partition of *elem*, key hash is mixed again so that it is independent of the hash map inside DedupTopN
+    size_t PartitionOf(const T& elem) {
+        uint64_t h = (uint64_t)m_hashFunc(m_keyFunc(elem));
+        h ^= h >> 33; h *= 0xFF51AFD7ED558CCDULL; h ^= h >> 33;
+        return (size_t)(h % m_partitions.size());
+    }
+    bool FlushPartition(Partition& partition);
+    /// reduce spill file of *partition* to its sorted TopN in the same file
+    bool ReducePartition(Partition& partition);
+    /// refill chunk of run file, return false if run is exhausted or fails, which also fails the stage
+    bool ReadChunk(Partition& partition);
+    bool Fail() { m_isFailed = true; return false; }
+    void RemoveFiles();
+
+private:
+    size_t                      m_topN;
+    size_t                      m_bufferElemCnt;
+    std::vector<Partition>      m_partitions;
+    PARTITION_TOPN_TYPE         m_partitionTopN;    /// reused for every partition
+    size_t                      m_pushedCnt;
+    bool                        m_isFailed;
+    CompareFunc                 m_valueCmpFunc;
+    KeyFunc                     m_keyFunc;
+    HashFunc                    m_hashFunc;
+};
+
+template <class T, class KeyFunc, class CompareFunc, class Policy, class HashFunc>
+ExternalDedupTopN<T, KeyFunc, CompareFunc, Policy, HashFunc>::
+ExternalDedupTopN(size_t topN, const std::string& spillDir, size_t partitionCount /* = 64 */,
+                  size_t bufferElemCount /* = 4096 */, CompareFunc compareFunc /* = CompareFunc() */,
+                  KeyFunc keyFunc /* = KeyFunc() */, HashFunc hashFunc /* = HashFunc() */)
+    : m_topN(std::max<size_t>(topN, 1)), m_bufferElemCnt(std::max<size_t>(bufferElemCount, 1)),
+      m_partitions(std::max<size_t>(partitionCount, 1)), m_partitionTopN(m_topN, compareFunc, keyFunc),
+      m_pushedCnt(0), m_isFailed(false), m_valueCmpFunc(compareFunc), m_keyFunc(keyFunc), m_hashFunc(hashFunc) {
+    /// pid and address keep names of concurrent stages in one directory apart
+    char name[128];
+    for (size_t i = 0; i < m_partitions.size(); ++i) {
+        snprintf(name, sizeof(name), "/indexedpq_spill_%d_%p_%zu.bin", (int)getpid(), (void*)this, i);
+        m_partitions[i].m_path = spillDir + name;
+        m_partitions[i].m_buffer.reserve(m_bufferElemCnt);
+    }
+}
+
+template <class T, class KeyFunc, class CompareFunc, class Policy, class HashFunc>
+bool ExternalDedupTopN<T, KeyFunc, CompareFunc, Policy, HashFunc>::FlushPartition(Partition& partition) {
+    if (partition.m_buffer.empty()) {
+        return true;
+    }
+    if (nullptr == partition.m_pFile) {
+        partition.m_pFile = fopen(partition.m_path.c_str(), "wb");
+        if (nullptr == partition.m_pFile) {
+            return Fail();
+        }
+    }
+    size_t count = partition.m_buffer.size();
+    if (fwrite(partition.m_buffer.data(), sizeof(T), count, partition.m_pFile) != count) {
+        return Fail();
+    }
+    partition.m_elemCnt += count;
+    partition.m_buffer.clear();
+    return true;
+}
+
+template <class T, class KeyFunc, class CompareFunc, class Policy, class HashFunc>
+bool ExternalDedupTopN<T, KeyFunc, CompareFunc, Policy, HashFunc>::ReducePartition(Partition& partition) {
+    if (0 == partition.m_elemCnt) {
+        return true;
+    }
+    FILE* pFile = fopen(partition.m_path.c_str(), "rb");
+    if (nullptr == pFile) {
+        return Fail();
+    }
+    m_partitionTopN.Reset();
+    size_t readCnt = 0;
+    partition.m_buffer.resize(m_bufferElemCnt);
+    while (readCnt < partition.m_elemCnt) {
+        size_t count = fread(partition.m_buffer.data(), sizeof(T), m_bufferElemCnt, pFile);
+        if (0 == count) {
+            break;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            m_partitionTopN.Push(partition.m_buffer[i]);
+        }
+        readCnt += count;
+    }
+    fclose(pFile);
+    if (readCnt != partition.m_elemCnt) {
+        return Fail();
+    }
+    /// the run is small, at most *m_topN* elements, and overwrites the spill file
+    m_partitionTopN.GetSortedElems(partition.m_buffer);
+    partition.m_elemCnt = 0;
+    partition.m_pFile = fopen(partition.m_path.c_str(), "wb");
+    if (nullptr == partition.m_pFile) {
+        return Fail();
+    }
+    bool isOk = FlushPartition(partition);
+    isOk = 0 == fclose(partition.m_pFile) && isOk;
+    partition.m_pFile = nullptr;
+    return isOk || Fail();
+}
+
+template <class T, class KeyFunc, class CompareFunc, class Policy, class HashFunc>
+bool ExternalDedupTopN<T, KeyFunc, CompareFunc, Policy, HashFunc>::ReadChunk(Partition& partition) {
+    partition.m_buffer.resize(m_bufferElemCnt);
+    size_t count = fread(partition.m_buffer.data(), sizeof(T), m_bufferElemCnt, partition.m_pFile);
+    partition.m_buffer.resize(count);
+    partition.m_bufferPos = 0;
+    partition.m_readCnt += count;
+    /// a short read ends the run only if it is not an error and all written elements are read
+    if (partition.m_readCnt > partition.m_elemCnt
+        || (count < m_bufferElemCnt && (0 != ferror(partition.m_pFile) || partition.m_readCnt != partition.m_elemCnt))) {
+        return Fail();
+    }
+    return count > 0;
+}
+
+template <class T, class KeyFunc, class CompareFunc, class Policy, class HashFunc>
+bool ExternalDedupTopN<T, KeyFunc, CompareFunc, Policy, HashFunc>::Finish(std::vector<T>& result) {
+    result.clear();
+    for (size_t i = 0; i < m_partitions.size() && !m_isFailed; ++i) {
+        Partition& partition = m_partitions[i];
+        FlushPartition(partition);
+        if (nullptr != partition.m_pFile && 0 != fclose(partition.m_pFile)) {
+            Fail();
+        }
+        partition.m_pFile = nullptr;
+    }
+    for (size_t i = 0; i < m_partitions.size() && !m_isFailed; ++i) {
+        ReducePartition(m_partitions[i]);
+    }
+
+    /// k-way merge of sorted runs, the heap top is the run whose current element ranks first
+    std::vector<size_t> heap;
+    for (size_t i = 0; i < m_partitions.size() && !m_isFailed; ++i) {
+        Partition& partition = m_partitions[i];
+        if (0 == partition.m_elemCnt) {
+            continue;
+        }
+        partition.m_pFile = fopen(partition.m_path.c_str(), "rb");
+        partition.m_readCnt = 0;
+        if (nullptr == partition.m_pFile || !ReadChunk(partition)) {
+            Fail();
+            break;
+        }
+        heap.push_back(i);
+    }
+    auto runCmp = [this](size_t a, size_t b) {
+        const Partition& pa = m_partitions[a];
+        const Partition& pb = m_partitions[b];
+        return m_valueCmpFunc(pb.m_buffer[pb.m_bufferPos], pa.m_buffer[pa.m_bufferPos]);
+    };
+    std::make_heap(heap.begin(), heap.end(), runCmp);
+    while (!m_isFailed && !heap.empty() && result.size() < m_topN) {
+        std::pop_heap(heap.begin(), heap.end(), runCmp);
+        Partition& partition = m_partitions[heap.back()];
+        result.push_back(partition.m_buffer[partition.m_bufferPos]);
+        if (++partition.m_bufferPos < partition.m_buffer.size() || ReadChunk(partition)) {
+            std::push_heap(heap.begin(), heap.end(), runCmp);
+        }
+        else {
+            heap.pop_back();
+        }
+    }
+
+    bool isOk = !m_isFailed;
+    RemoveFiles();
+    if (!isOk) {
+        result.clear();
+    }
+    return isOk;
+}
+
+template <class T, class KeyFunc, class CompareFunc, class Policy, class HashFunc>
+void ExternalDedupTopN<T, KeyFunc, CompareFunc, Policy, HashFunc>::RemoveFiles() {
+    for (size_t i = 0; i < m_partitions.size(); ++i) {
+        Partition& partition = m_partitions[i];
+        if (nullptr != partition.m_pFile) {
+            fclose(partition.m_pFile);
+            partition.m_pFile = nullptr;
+        }
+        unlink(partition.m_path.c_str());
+        partition.m_buffer.clear();
+        partition.m_bufferPos = 0;
+        partition.m_elemCnt = 0;
+        partition.m_readCnt = 0;
+    }
+    m_partitionTopN.Reset();
+    m_pushedCnt = 0;
+}
+
+#endif //__INDEXEDPQ_EXTERNAL_DEDUP_TOPN_H__
@@ -0,0 +1,175 @@
+#include "indexedpq/heavy-hitters-unittest.h"
+#include "indexedpq/indexed-priority-queue-unittest.h"
+#include <cppunit/TestAssert.h>
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+CPPUNIT_TEST_SUITE_REGISTRATION(HeavyHittersTest);
+
+namespace {
+/// *count* keys of Zipf distribution with exponent *s* over [0, keyCount), key 0 is the most frequent
+void GenZipfKeys(size_t keyCount, double s, size_t count, vector<uint64_t>& keys) {
+    vector<double> cdf(keyCount);
+    double sum = 0;
+    for (size_t i = 0; i < keyCount; ++i) {
+        sum += 1.0 / std::pow(i + 1, s);
+        cdf[i] = sum;
+    }
+    keys.clear();
+    for (size_t i = 0; i < count; ++i) {
+        double u = RandomUtil<int64_t>::RandomInt64(0, (1 << 30) - 1) / double(1 << 30) * sum;
+        keys.push_back(std::upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+    }
+}
+
+/// SpaceSaving bounds of *sketch* against exact counts of a stream
+template <class Sketch>
+void CheckBounds(Sketch& sketch, const unordered_map<uint64_t, uint64_t>& exactMap) {
+    uint64_t errorBound = sketch.GetTotalCount() / sketch.GetCapacity();
+    CPPUNIT_ASSERT(sketch.GetMinCount() <= errorBound);
+    for (auto& kv : exactMap) {
+        auto pCounter = sketch.Find(kv.first);
+        if (nullptr == pCounter) {
+            CPPUNIT_ASSERT(kv.second <= sketch.GetMinCount());
+            continue;
+        }
+        CPPUNIT_ASSERT(pCounter->m_count >= kv.second);
+        CPPUNIT_ASSERT(pCounter->m_count - pCounter->m_error <= kv.second);
+        CPPUNIT_ASSERT(pCounter->m_error <= errorBound);
+    }
+}
+}
+
+void HeavyHittersTest::NormalTest() {
+    HeavyHitters<string> sketch(3);
+    sketch.Add("a", 5);
+    sketch.Add("b", 3);
+    sketch.Add("a");
+    sketch.Add("c", 2);
+    /// exact while keys fit
+    CPPUNIT_ASSERT_EQUAL((uint64_t)6, sketch.Estimate("a"));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)2, sketch.Find("c")->m_count);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)0, sketch.Find("c")->m_error);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)2, sketch.GetMinCount());
+
+    /// a new key takes over the minimum counter
+    sketch.Add("d");
+    CPPUNIT_ASSERT(nullptr == sketch.Find("c"));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)3, sketch.Find("d")->m_count);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)2, sketch.Find("d")->m_error);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)3, sketch.Estimate("c"));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)12, sketch.GetTotalCount());
+
+    vector<HeavyHitters<string>::Counter> topK;
+    sketch.GetTopK(topK);
+    CPPUNIT_ASSERT_EQUAL((size_t)3, topK.size());
+    CPPUNIT_ASSERT_EQUAL(string("a"), topK[0].m_key);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)3, topK[2].m_count);
+
+    sketch.Reset();
+    CPPUNIT_ASSERT_EQUAL((size_t)0, sketch.GetCount());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)0, sketch.Estimate("a"));
+}
+
+void HeavyHittersTest::ErrorBoundTest() {
+    size_t k = 100, keyCount = 10000, count = 200000;
+    for (double s : {0.8, 1.1}) {
+        vector<uint64_t> keys;
+        GenZipfKeys(keyCount, s, count, keys);
+        HeavyHitters<uint64_t> sketch(k);
+        unordered_map<uint64_t, uint64_t> exactMap;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            sketch.Add(keys[i]);
+            ++exactMap[keys[i]];
+            if (i % 20000 == 19999) {
+                CheckBounds(sketch, exactMap);
+            }
+        }
+        /// the most frequent keys are found in order
+        vector<HeavyHitters<uint64_t>::Counter> topK;
+        sketch.GetTopK(topK);
+        for (size_t i = 0; i < 3; ++i) {
+            CPPUNIT_ASSERT_EQUAL((uint64_t)i, topK[i].m_key);
+        }
+    }
+}
+
+void HeavyHittersTest::MergeTest() {
+    /// sketches of shards merged in a tree, against the exact counts of all shards
+    size_t k = 50, keyCount = 5000, shardCount = 8, count = 20000;
+    vector<HeavyHitters<uint64_t>*> sketches;
+    unordered_map<uint64_t, uint64_t> exactMap;
+    for (size_t i = 0; i < shardCount; ++i) {
+        vector<uint64_t> keys;
+        /// shards have different skew and hot keys
+        GenZipfKeys(keyCount, 0.7 + 0.1 * i, count * (i + 1), keys);
+        sketches.push_back(new HeavyHitters<uint64_t>(k));
+        for (uint64_t key : keys) {
+            key = (key + i * 7) % keyCount;
+            sketches.back()->Add(key);
+            ++exactMap[key];
+        }
+    }
+    for (size_t step = 1; step < shardCount; step *= 2) {
+        for (size_t i = 0; i + step < shardCount; i += 2 * step) {
+            sketches[i]->Merge(*sketches[i + step]);
+        }
+    }
+    HeavyHitters<uint64_t>& merged = *sketches[0];
+    uint64_t totalCount = 0;
+    for (auto& kv : exactMap) { totalCount += kv.second; }
+    CPPUNIT_ASSERT_EQUAL(totalCount, merged.GetTotalCount());
+    CPPUNIT_ASSERT_EQUAL(k, merged.GetCount());
+    CheckBounds(merged, exactMap);
+
+    /// merging into an empty sketch copies it
+    HeavyHitters<uint64_t> empty(k);
+    empty.Merge(merged);
+    for (auto& kv : exactMap) {
+        CPPUNIT_ASSERT_EQUAL(merged.Estimate(kv.first), empty.Estimate(kv.first));
+    }
+    for (HeavyHitters<uint64_t>* pSketch : sketches) { delete pSketch; }
+}
+
+void HeavyHittersTest::PerformanceTest() {
+    /// Zipf stream, against the usual SpaceSaving of an ordered set of counters and a hash map from key to counter
+    size_t k = 1000, keyCount = 1e6, count = 1e6;
+    vector<uint64_t> keys;
+    GenZipfKeys(keyCount, 1.0, count, keys);
+
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    HeavyHitters<uint64_t> sketch(k);
+    for (uint64_t key : keys) { sketch.Add(key); }
+    int64_t tSketch = TimeUtil::CurrentTimeInMicroSeconds();
+
+    typedef pair<uint64_t, uint64_t> COUNTER_TYPE;      /// count and key
+    set<COUNTER_TYPE> counters;
+    unordered_map<uint64_t, uint64_t> key2CountMap;
+    for (uint64_t key : keys) {
+        auto it = key2CountMap.find(key);
+        if (it != key2CountMap.end()) {
+            counters.erase(COUNTER_TYPE(it->second, key));
+            counters.insert(COUNTER_TYPE(++it->second, key));
+            continue;
+        }
+        uint64_t newCount = 1;
+        if (counters.size() >= k) {
+            COUNTER_TYPE minCounter = *counters.begin();
+            counters.erase(counters.begin());
+            key2CountMap.erase(minCounter.second);
+            newCount += minCounter.first;
+        }
+        counters.insert(COUNTER_TYPE(newCount, key));
+        key2CountMap[key] = newCount;
+    }
+    int64_t tSet = TimeUtil::CurrentTimeInMicroSeconds();
+    cout << "-------------count:[" << count << "],k:[" << k << "],heavy hitters:[" << (tSketch - tBegin) / 1000
+         << "]ms,set and hash map:[" << (tSet - tSketch) / 1000 << "]ms." << endl;
+    CPPUNIT_ASSERT_EQUAL(k, sketch.GetCount());
+    CPPUNIT_ASSERT_EQUAL(counters.begin()->first, sketch.GetMinCount());
+}
@@ -0,0 +1,28 @@
+#ifndef __INDEXEDPQ_TEST_HEAVY_HITTERS_UNITTEST_H__
+#define __INDEXEDPQ_TEST_HEAVY_HITTERS_UNITTEST_H__
+
+#include "indexedpq/heavy-hitters.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+class HeavyHittersTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(HeavyHittersTest);
+    CPPUNIT_TEST(NormalTest);
+    CPPUNIT_TEST(ErrorBoundTest);
+    CPPUNIT_TEST(MergeTest);
+    CPPUNIT_TEST(PerformanceTest);
+    CPPUNIT_TEST_SUITE_END();
+public:
+    HeavyHittersTest() {}
+    ~HeavyHittersTest() {}
+    void setUp() {}
+    void tearDown() {}
+public:
+
+    void NormalTest();
+    void ErrorBoundTest();
+    void MergeTest();
+    void PerformanceTest();
+};
+
+
+#endif //__INDEXEDPQ_TEST_HEAVY_HITTERS_UNITTEST_H__
@@ -0,0 +1,167 @@
+#ifndef __INDEXEDPQ_HEAVY_HITTERS_H__
+#define __INDEXEDPQ_HEAVY_HITTERS_H__
+
+#include "indexedpq/indexed-priority-queue.h"
+#include "indexedpq/indexed-pq-hash-map.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ *@brief     heavy hitters sketch of SpaceSaving, the top *k* frequent keys of a stream in bounded memory.
+ *           A fixed IndexedPriorityQueue of *k* counters keeps the minimum count on top, and an IndexedPQHashMap maps a
+ *           key to its counter handle. A kept key is counted by *Update*, a new key replaces the minimum counter by
+ *           *ReplaceTopElem* and inherits its count as overestimation error.
+ *           Error bounds, for total count *N* of the stream:
+ *             - estimated count of a key is never less than its true count, and exceeds it by at most *m_error* of
+ *               its counter, which is not larger than the minimum count, so not larger than N/k;
+ *             - every key whose true count is larger than N/k is kept.
+ *           Sketches of shards, e.g. of threads, merge by *Merge* into a sketch of the total count of both with the
+ *           same bounds, as the kept *k* counters still sum to not larger than N.
+ *           All memory is allocated in constructor.
+ */
+template <class Key, class HashFunc = std::hash<Key>, class Policy = IndexedPQDefaultPolicy >
+class HeavyHitters
+{
+public:
+    typedef Key                 KEY_TYPE;
+    /// counter of a key, its true count is in [m_count - m_error, m_count]
+    struct Counter {
+        Key         m_key;
+        uint64_t    m_count;
+        uint64_t    m_error;
+    };
+    /// higher count ranks before, so the top of fixed queue is the minimum counter
+    struct CounterComparator {
+        bool operator() (const Counter& a, const Counter& b) const { return a.m_count > b.m_count; }
+    };
+    typedef IndexedPriorityQueue<Counter, CounterComparator, Policy>   QUEUE_TYPE;
+    typedef typename QUEUE_TYPE::HANDLE_TYPE                           HANDLE_TYPE;
+
+public:
+    /// *k* is the count of counters
+    HeavyHitters(size_t k, HashFunc hashFunc = HashFunc())
+        : m_queue(k, 1, true), m_key2HtMap(k, hashFunc), m_totalCount(0) { assert(k > 0); }
+
+    inline size_t   GetCount() { return m_queue.GetCount(); }
+    inline size_t   GetCapacity() { return m_queue.GetCapacity(); }
+    /// total count added, *N* of the error bounds
+    inline uint64_t GetTotalCount() { return m_totalCount; }
+    /// count of the minimum counter if all counters are used, else 0. It bounds the error of every estimation.
+    inline uint64_t GetMinCount() { return m_queue.IsFull() ? m_queue.TopElem().m_count : 0; }
+
+    /// clear all counters
+    void Reset() { m_queue.Reset(); m_key2HtMap.Clear(); m_totalCount = 0; }
+
+    /// add *count* occurrences of *key*
+    void Add(const Key& key, uint64_t count = 1);
+
+    /// counter of *key*, nullptr if it is not kept, whose true count is then not larger than *GetMinCount*
+    const Counter* Find(const Key& key) {
+        HANDLE_TYPE* pHt = m_key2HtMap.Find(key);
+        return nullptr == pHt ? nullptr : &m_queue.Elem(*pHt);
+    }
+    /// upper bound of true count of *key*
+    uint64_t Estimate(const Key& key) {
+        const Counter* pCounter = Find(key);
+        return nullptr == pCounter ? GetMinCount() : pCounter->m_count;
+    }
+
+    /**
+     *@brief     merge counters of *other*, e.g. a sketch of another shard or thread, which is not changed. Count of a
+     *           key missing in one sketch is bounded by the minimum count of that sketch, which is added to its count
+     *           and error, then the top *k* counters are kept.
+     */
+    void Merge(HeavyHitters& other);
+
+    /// counters in rank order, the most frequent first
+    void GetTopK(std::vector<Counter>& result);
+
+private:
+    /// keep the top *k* of *counters* as all counters
+    void Rebuild(std::vector<Counter>& counters);
+
+private:
+    QUEUE_TYPE                                      m_queue;            /// fixed counters, top is the minimum
+    IndexedPQHashMap<Key, HANDLE_TYPE, HashFunc>    m_key2HtMap;        /// key to counter handle
+    uint64_t                                        m_totalCount;
+};
+
+template <class Key, class HashFunc, class Policy>
+void HeavyHitters<Key, HashFunc, Policy>::Add(const Key& key, uint64_t count /* = 1 */) {
+    m_totalCount += count;
+    HANDLE_TYPE* pHt = m_key2HtMap.Find(key);
+    if (nullptr != pHt) {
+        Counter counter = m_queue.Elem(*pHt);
+        counter.m_count += count;
+        m_queue.Update(*pHt, counter);
+        return;
+    }
+    if (!m_queue.IsFull()) {
+        HANDLE_TYPE ht = m_queue.Push(Counter{key, count, 0});
+        if (ht != QUEUE_TYPE::INVALID_HANDLE) {
+            m_key2HtMap.Insert(key, ht);
+        }
+        return;
+    }
+    /// the new key takes over the minimum counter and its handle
+    HANDLE_TYPE ht = m_queue.Top();
+    const Counter& minCounter = m_queue.TopElem();
+    uint64_t minCount = minCounter.m_count;
+    m_key2HtMap.Erase(minCounter.m_key);
+    m_queue.ReplaceTopElem(Counter{key, minCount + count, minCount});
+    m_key2HtMap.Insert(key, ht);
+}
+
+template <class Key, class HashFunc, class Policy>
+void HeavyHitters<Key, HashFunc, Policy>::Merge(HeavyHitters& other) {
+    uint64_t minCount = GetMinCount(), otherMinCount = other.GetMinCount();
+    std::vector<Counter> counters;
+    counters.reserve(GetCount() + other.GetCount());
+    for (size_t i = 0; i < GetCount(); ++i) {
+        Counter counter = m_queue.ElemAtHeap(i);
+        const Counter* pOther = other.Find(counter.m_key);
+        counter.m_count += nullptr == pOther ? otherMinCount : pOther->m_count;
+        counter.m_error += nullptr == pOther ? otherMinCount : pOther->m_error;
+        counters.push_back(counter);
+    }
+    for (size_t i = 0; i < other.GetCount(); ++i) {
+        Counter counter = other.m_queue.ElemAtHeap(i);
+        if (nullptr == m_key2HtMap.Find(counter.m_key)) {
+            counter.m_count += minCount;
+            counter.m_error += minCount;
+            counters.push_back(counter);
+        }
+    }
+    m_totalCount += other.m_totalCount;
+    Rebuild(counters);
+}
+
+template <class Key, class HashFunc, class Policy>
+void HeavyHitters<Key, HashFunc, Policy>::Rebuild(std::vector<Counter>& counters) {
+    size_t keepCount = std::min(counters.size(), GetCapacity());
+    if (keepCount < counters.size()) {
+        std::nth_element(counters.begin(), counters.begin() + keepCount, counters.end(), CounterComparator());
+    }
+    m_queue.Reset();
+    m_key2HtMap.Clear();
+    m_queue.BeginBatch();
+    for (size_t i = 0; i < keepCount; ++i) {
+        m_key2HtMap.Insert(counters[i].m_key, m_queue.Push(counters[i]));
+    }
+    m_queue.CommitBatch();
+}
+
+template <class Key, class HashFunc, class Policy>
+void HeavyHitters<Key, HashFunc, Policy>::GetTopK(std::vector<Counter>& result) {
+    result.clear();
+    result.reserve(GetCount());
+    for (size_t i = 0; i < GetCount(); ++i) {
+        result.push_back(m_queue.ElemAtHeap(i));
+    }
+    std::sort(result.begin(), result.end(), CounterComparator());
+}
+
+#endif //__INDEXEDPQ_HEAVY_HITTERS_H__
@@ -0,0 +1,182 @@
+#include "indexedpq/hierarchical-timer-wheel-unittest.h"
+#include "indexedpq/indexed-priority-queue-unittest.h"
+#include <cppunit/TestAssert.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+CPPUNIT_TEST_SUITE_REGISTRATION(HierarchicalTimerWheelTest);
+
+void HierarchicalTimerWheelTest::NormalTest() {
+    typedef HierarchicalTimerWheel<string> WHEEL_TYPE;
+    WHEEL_TYPE wheel(1000);
+    WHEEL_TYPE::HANDLE_TYPE nearHt = wheel.Schedule(1010, "near");
+    WHEEL_TYPE::HANDLE_TYPE farHt = wheel.Schedule(1000 + 70000, "far");
+    WHEEL_TYPE::HANDLE_TYPE pastHt = wheel.Schedule(10, "past");
+    WHEEL_TYPE::HANDLE_TYPE cancelHt = wheel.Schedule(5000, "cancel");
+    CPPUNIT_ASSERT_EQUAL((size_t)4, wheel.GetCount());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)5000, wheel.Deadline(cancelHt));
+
+    vector<string> expired;
+    auto onExpire = [&expired](WHEEL_TYPE::HANDLE_TYPE, string& value) { expired.push_back(value); };
+    /// a past deadline expires by the next pop
+    CPPUNIT_ASSERT_EQUAL((size_t)1, wheel.PopExpired(1000, onExpire));
+    CPPUNIT_ASSERT_EQUAL(string("past"), expired.back());
+    CPPUNIT_ASSERT(!wheel.Contains(pastHt));
+
+    string value;
+    CPPUNIT_ASSERT(wheel.Cancel(cancelHt, &value));
+    CPPUNIT_ASSERT_EQUAL(string("cancel"), value);
+    CPPUNIT_ASSERT(!wheel.Cancel(cancelHt));
+    CPPUNIT_ASSERT(!wheel.Reschedule(cancelHt, 2000));
+
+    /// near timer moves far and far timer moves near, in both directions of the heap and the wheel
+    CPPUNIT_ASSERT(wheel.Reschedule(nearHt, 1000 + 300000));
+    CPPUNIT_ASSERT(wheel.Reschedule(farHt, 1020));
+    CPPUNIT_ASSERT_EQUAL((size_t)0, wheel.PopExpired(1019, onExpire));
+    CPPUNIT_ASSERT_EQUAL((size_t)1, wheel.PopExpired(1020, onExpire));
+    CPPUNIT_ASSERT_EQUAL(string("far"), expired.back());
+    CPPUNIT_ASSERT_EQUAL((size_t)0, wheel.PopExpired(1000 + 299999, onExpire));
+    CPPUNIT_ASSERT_EQUAL((size_t)1, wheel.PopExpired(1000 + 300000, onExpire));
+    CPPUNIT_ASSERT_EQUAL(string("near"), expired.back());
+    CPPUNIT_ASSERT(wheel.IsEmpty());
+
+    /// handles are recycled, and the callback may schedule again
+    WHEEL_TYPE::HANDLE_TYPE ht = wheel.Schedule(wheel.GetNow() + 1, "again");
+    CPPUNIT_ASSERT(ht == nearHt || ht == farHt || ht == pastHt || ht == cancelHt);
+    size_t rescheduleCnt = 0;
+    auto onExpireAgain = [&](WHEEL_TYPE::HANDLE_TYPE, string& value) {
+        if (rescheduleCnt++ < 3) {
+            wheel.Schedule(wheel.GetNow() + 1000, value);
+        }
+    };
+    CPPUNIT_ASSERT_EQUAL((size_t)4, wheel.PopExpired(UINT64_MAX, onExpireAgain));
+    CPPUNIT_ASSERT(wheel.IsEmpty());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)UINT64_MAX, wheel.GetNow());
+}
+
+void HierarchicalTimerWheelTest::RandomOpsTest() {
+    /// against brute force, deadlines spread over all levels
+    typedef HierarchicalTimerWheel<uint64_t> WHEEL_TYPE;
+    size_t opCount = 200000, maxCount = 2000;
+    uint64_t now = 12345;
+    WHEEL_TYPE wheel(now);
+    map<WHEEL_TYPE::HANDLE_TYPE, uint64_t> refMap;
+    vector<WHEEL_TYPE::HANDLE_TYPE> hts;
+    auto randDeadline = [&now]() {
+        int64_t bits = RandomUtil<int64_t>::RandomInt64(0, 40);
+        return now + RandomUtil<int64_t>::RandomInt64(0, ((int64_t)1 << bits) - 1) - (bits == 0 ? 1 : 0);
+    };
+    uint64_t serial = 0;
+    for (size_t i = 0; i < opCount; ++i) {
+        int64_t op = RandomUtil<int64_t>::RandomInt64(0, 9);
+        if (op < 4 && refMap.size() < maxCount) {
+            uint64_t deadline = randDeadline();
+            WHEEL_TYPE::HANDLE_TYPE ht = wheel.Schedule(deadline, ++serial);
+            CPPUNIT_ASSERT(refMap.find(ht) == refMap.end());
+            refMap[ht] = deadline;
+            hts.push_back(ht);
+        }
+        else if (op < 7 && !hts.empty()) {
+            size_t index = RandomUtil<int64_t>::RandomInt64(0, hts.size() - 1);
+            WHEEL_TYPE::HANDLE_TYPE ht = hts[index];
+            bool isLive = refMap.find(ht) != refMap.end();
+            uint64_t deadline = randDeadline();
+            CPPUNIT_ASSERT_EQUAL(isLive, wheel.Reschedule(ht, deadline));
+            if (isLive) { refMap[ht] = deadline; }
+        }
+        else if (op < 8 && !hts.empty()) {
+            size_t index = RandomUtil<int64_t>::RandomInt64(0, hts.size() - 1);
+            WHEEL_TYPE::HANDLE_TYPE ht = hts[index];
+            hts[index] = hts.back();
+            hts.pop_back();
+            CPPUNIT_ASSERT_EQUAL(refMap.erase(ht) > 0, wheel.Cancel(ht));
+        }
+        else {
+            int64_t bits = RandomUtil<int64_t>::RandomInt64(0, 36);
+            now += RandomUtil<int64_t>::RandomInt64(0, (int64_t)1 << bits);
+            uint64_t lastDeadline = 0;
+            size_t expiredCnt = wheel.PopExpired(now, [&](WHEEL_TYPE::HANDLE_TYPE ht, uint64_t&) {
+                auto it = refMap.find(ht);
+                CPPUNIT_ASSERT(it != refMap.end());
+                CPPUNIT_ASSERT(it->second <= now);
+                CPPUNIT_ASSERT(it->second >= lastDeadline);
+                lastDeadline = it->second;
+                refMap.erase(it);
+            });
+            (void)expiredCnt;
+            for (auto& kv : refMap) {
+                CPPUNIT_ASSERT(kv.second > now);
+            }
+            /// forget handles which may have been recycled
+            hts.clear();
+            for (auto& kv : refMap) { hts.push_back(kv.first); }
+        }
+        CPPUNIT_ASSERT_EQUAL(refMap.size(), wheel.GetCount());
+    }
+    for (auto& kv : refMap) {
+        CPPUNIT_ASSERT(wheel.Contains(kv.first));
+        CPPUNIT_ASSERT_EQUAL(kv.second, wheel.Deadline(kv.first));
+    }
+}
+
+void HierarchicalTimerWheelTest::PerformanceTest() {
+    /// timeouts of connections: every live timer is pushed back on activity, few of them expire
+    size_t timerCount = 2e5, opCount = 4e5, timeout = 30000;
+    vector<uint64_t> hts, opTimes;
+    for (size_t i = 0; i < opCount; ++i) {
+        hts.push_back(RandomUtil<int64_t>::RandomInt64(0, timerCount - 1));
+    }
+    uint64_t expiredSum = 0;
+
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    typedef HierarchicalTimerWheel<uint64_t> WHEEL_TYPE;
+    WHEEL_TYPE wheel(0, timerCount);
+    vector<WHEEL_TYPE::HANDLE_TYPE> wheelHts(timerCount);
+    for (size_t i = 0; i < timerCount; ++i) {
+        wheelHts[i] = wheel.Schedule(timeout + i % timeout, i);
+    }
+    for (size_t i = 0; i < opCount; ++i) {
+        uint64_t now = i / 16;
+        wheel.Reschedule(wheelHts[hts[i]], now + timeout);
+        if (i % 16 == 15) {
+            wheel.PopExpired(now, [&](WHEEL_TYPE::HANDLE_TYPE, uint64_t& index) {
+                expiredSum += index;
+                wheelHts[index] = wheel.Schedule(now + timeout, index);
+            });
+        }
+    }
+    int64_t tWheel = TimeUtil::CurrentTimeInMicroSeconds();
+
+    /// plain heap of deadlines, rescheduled by *Update*
+    typedef IndexedPriorityQueue<uint64_t, std::greater<uint64_t> > QUEUE_TYPE;
+    QUEUE_TYPE pq(timerCount);
+    vector<QUEUE_TYPE::HANDLE_TYPE> pqHts(timerCount);
+    vector<uint64_t> ht2Index(timerCount);
+    for (size_t i = 0; i < timerCount; ++i) {
+        pqHts[i] = pq.Push(timeout + i % timeout);
+        ht2Index[pqHts[i] & QUEUE_TYPE::SLOT_MASK] = i;
+    }
+    for (size_t i = 0; i < opCount; ++i) {
+        uint64_t now = i / 16;
+        pq.Update(pqHts[hts[i]], now + timeout);
+        if (i % 16 == 15) {
+            while (pq.TopElem() <= now) {
+                uint64_t index = ht2Index[pq.Top() & QUEUE_TYPE::SLOT_MASK];
+                pq.Pop();
+                expiredSum -= index;
+                pqHts[index] = pq.Push(now + timeout);
+                ht2Index[pqHts[index] & QUEUE_TYPE::SLOT_MASK] = index;
+            }
+        }
+    }
+    int64_t tHeap = TimeUtil::CurrentTimeInMicroSeconds();
+    cout << "-------------timerCount:[" << timerCount << "],opCount:[" << opCount << "],timer wheel:["
+         << (tWheel - tBegin) / 1000 << "]ms,heap:[" << (tHeap - tWheel) / 1000 << "]ms." << endl;
+    CPPUNIT_ASSERT_EQUAL(timerCount, wheel.GetCount());
+    CPPUNIT_ASSERT_EQUAL(timerCount, pq.GetCount());
+    /// same timers expire in both
+    CPPUNIT_ASSERT_EQUAL((uint64_t)0, expiredSum);
+}
@@ -0,0 +1,26 @@
+#ifndef __INDEXEDPQ_TEST_HIERARCHICAL_TIMER_WHEEL_UNITTEST_H__
+#define __INDEXEDPQ_TEST_HIERARCHICAL_TIMER_WHEEL_UNITTEST_H__
+
+#include "indexedpq/hierarchical-timer-wheel.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+class HierarchicalTimerWheelTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(HierarchicalTimerWheelTest);
+    CPPUNIT_TEST(NormalTest);
+    CPPUNIT_TEST(RandomOpsTest);
+    CPPUNIT_TEST(PerformanceTest);
+    CPPUNIT_TEST_SUITE_END();
+public:
+    HierarchicalTimerWheelTest() {}
+    ~HierarchicalTimerWheelTest() {}
+    void setUp() {}
+    void tearDown() {}
+public:
+
+    void NormalTest();
+    void RandomOpsTest();
+    void PerformanceTest();
+};
+
+
+#endif //__INDEXEDPQ_TEST_HIERARCHICAL_TIMER_WHEEL_UNITTEST_H__
@@ -0,0 +1,264 @@
+#ifndef __INDEXEDPQ_HIERARCHICAL_TIMER_WHEEL_H__
+#define __INDEXEDPQ_HIERARCHICAL_TIMER_WHEEL_H__
+
+#include "indexedpq/indexed-priority-queue.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/**
+ *@brief     timer service of a hierarchical timing wheel, whose near-term bucket is an IndexedPriorityQueue.
+ *           Deadlines are ticks of uint64_t. A timer due in the current window of *SLOT_COUNT* ticks lives in the heap,
+ *           which keeps exact order, a later one lives in a slot of wheel level *k*, by the highest digit of
+ *           *SLOT_BITS* bits where its deadline differs from current time. So *Schedule*, *Reschedule* and *Cancel* of
+ *           far timers are O(1) unsorted appends and removes, and only the few near timers pay O(logN) of the heap.
+ *           When the heap runs out, the next non-empty slot found by per-level bitmaps is cascaded into lower levels,
+ *           every timer is cascaded at most once per level.
+ *           Handles are stable until the timer expires or is cancelled, then they are recycled.
+ *           Only *HANDLE_TYPE* of *Policy* is used.
+ */
+template <class T, class Policy = IndexedPQDefaultPolicy >
+class HierarchicalTimerWheel
+{
+public:
+    typedef T                               VALUE_TYPE;
+    typedef typename Policy::HANDLE_TYPE    HANDLE_TYPE;
+
+    static constexpr HANDLE_TYPE INVALID_HANDLE = HANDLE_TYPE(-1);
+    static constexpr size_t MAX_COUNT = INVALID_HANDLE;
+    static constexpr size_t SLOT_BITS = 8;
+    static constexpr size_t SLOT_COUNT = size_t(1) << SLOT_BITS;
+    static constexpr size_t LEVEL_COUNT = (64 + SLOT_BITS - 1) / SLOT_BITS;     /// level 0 is the heap
+    static constexpr size_t BITMAP_WORDS = SLOT_COUNT / 64;
+
+public:
+    /// *now* is the initial current time
+    HierarchicalTimerWheel(uint64_t now = 0, size_t nSizeHint = 32)
+        : m_now(now), m_nearQueue(nSizeHint) {
+        m_nodeVec.reserve(nSizeHint);
+        memset(m_bitmaps, 0, sizeof(m_bitmaps));
+    }
+
+    inline size_t   GetCount() { return m_nodeVec.size() - m_freeHtVec.size(); }
+    inline bool     IsEmpty() { return 0 == GetCount(); }
+    /// time of the last *PopExpired*, or the initial time
+    inline uint64_t GetNow() { return m_now; }
+    /// whether timer of handle *ht* is scheduled
+    inline bool     Contains(HANDLE_TYPE ht) { return ht < m_nodeVec.size() && m_nodeVec[ht].m_level < LEVEL_COUNT; }
+    inline uint64_t Deadline(HANDLE_TYPE ht) { assert(Contains(ht)); return m_nodeVec[ht].m_deadline; }
+    inline T&       Value(HANDLE_TYPE ht) { assert(Contains(ht)); return m_nodeVec[ht].m_value; }
+
+    /// schedule *value* at *deadline*, a deadline not later than current time expires by the next *PopExpired*.
+    /// return its handle, INVALID_HANDLE if *MAX_COUNT* is reached.
+    HANDLE_TYPE Schedule(uint64_t deadline, const T& value) { return ScheduleValue(deadline, value); }
+    HANDLE_TYPE Schedule(uint64_t deadline, T&& value) { return ScheduleValue(deadline, std::move(value)); }
+
+    /// move timer of handle *ht* to *deadline*, return false if it is not scheduled
+    bool Reschedule(HANDLE_TYPE ht, uint64_t deadline) {
+        if (!Contains(ht)) {
+            return false;
+        }
+        Node& node = m_nodeVec[ht];
+        if (0 == node.m_level && IsNear(deadline)) {
+            /// stays in the heap
+            node.m_deadline = deadline;
+            m_nearQueue.Update(node.m_pos, NearTimer{deadline, ht});
+            return true;
+        }
+        Unlink(ht);
+        node.m_deadline = deadline;
+        Link(ht);
+        return true;
+    }
+
+    /// cancel timer of handle *ht* and recycle the handle, return false if it is not scheduled
+    bool Cancel(HANDLE_TYPE ht, T* pValue = nullptr) {
+        if (!Contains(ht)) {
+            return false;
+        }
+        Unlink(ht);
+        Release(ht, pValue);
+        return true;
+    }
+
+    /**
+     *@brief     advance current time to *now* and expire all timers whose deadlines are not later than it, in
+     *           deadline order. *onExpire(ht, value)* is called for every one after its handle is recycled, so it
+     *           may schedule timers again, even reusing the same handle.
+     *@return    count of expired timers.
+     */
+    template<class ExpireFunc>
+    size_t PopExpired(uint64_t now, ExpireFunc&& onExpire);
+
+    /// drop all timers
+    void Reset() {
+        m_nodeVec.clear();
+        m_freeHtVec.clear();
+        m_nearQueue.Reset();
+        for (size_t level = 1; level < LEVEL_COUNT; ++level) {
+            for (size_t slot = 0; slot < SLOT_COUNT; ++slot) { m_slotVecs[level][slot].clear(); }
+        }
+        memset(m_bitmaps, 0, sizeof(m_bitmaps));
+    }
+
+private:
+    struct Node {
+        T           m_value;
+        uint64_t    m_deadline;
+        size_t      m_level;        /// 0 for heap, *LEVEL_COUNT* if not scheduled
+        size_t      m_slot;
+        size_t      m_pos;          /// heap handle, or position in its slot
+    };
+    /// element of the near heap, the earliest deadline on top
+    struct NearTimer {
+        uint64_t    m_deadline;
+        HANDLE_TYPE m_ht;
+    };
+    struct NearTimerComparator {
+        bool operator() (const NearTimer& a, const NearTimer& b) const { return a.m_deadline > b.m_deadline; }
+    };
+    typedef IndexedPriorityQueue<NearTimer, NearTimerComparator, Policy> NEAR_QUEUE_TYPE;
+
+    template<class U>
+    HANDLE_TYPE ScheduleValue(uint64_t deadline, U&& value);
+
+    /// whether *deadline* is due in the current window of the heap
+    inline bool IsNear(uint64_t deadline) { return (deadline >> SLOT_BITS) <= (m_now >> SLOT_BITS); }
+    /// put timer of handle *ht* into the heap or a wheel slot by its deadline
+    void Link(HANDLE_TYPE ht) {
+        Node& node = m_nodeVec[ht];
+        if (IsNear(node.m_deadline)) {
+            node.m_level = 0;
+            node.m_pos = m_nearQueue.Push(NearTimer{node.m_deadline, ht});
+            return;
+        }
+        size_t highBit = 63 - __builtin_clzll(node.m_deadline ^ m_now);
+        node.m_level = highBit / SLOT_BITS;
+        node.m_slot = (node.m_deadline >> (node.m_level * SLOT_BITS)) & (SLOT_COUNT - 1);
+        std::vector<HANDLE_TYPE>& slotVec = m_slotVecs[node.m_level][node.m_slot];
+        node.m_pos = slotVec.size();
+        slotVec.push_back(ht);
+        m_bitmaps[node.m_level][node.m_slot / 64] |= uint64_t(1) << (node.m_slot % 64);
+    }
+    void Unlink(HANDLE_TYPE ht) {
+        Node& node = m_nodeVec[ht];
+        if (0 == node.m_level) {
+            m_nearQueue.Remove(node.m_pos);
+            return;
+        }
+        std::vector<HANDLE_TYPE>& slotVec = m_slotVecs[node.m_level][node.m_slot];
+        HANDLE_TYPE lastHt = slotVec.back();
+        slotVec[node.m_pos] = lastHt;
+        m_nodeVec[lastHt].m_pos = node.m_pos;
+        slotVec.pop_back();
+        if (slotVec.empty()) {
+            m_bitmaps[node.m_level][node.m_slot / 64] &= ~(uint64_t(1) << (node.m_slot % 64));
+        }
+    }
+    void Release(HANDLE_TYPE ht, T* pValue) {
+        Node& node = m_nodeVec[ht];
+        if (nullptr != pValue) { *pValue = std::move(node.m_value); }
+        node.m_level = LEVEL_COUNT;
+        m_freeHtVec.push_back(ht);
+    }
+    /// first non-empty slot of *level* after *slot*, *SLOT_COUNT* if none
+    size_t NextSlot(size_t level, size_t slot) {
+        for (size_t i = slot + 1; i < SLOT_COUNT; i = (i | 63) + 1) {
+            uint64_t word = m_bitmaps[level][i / 64] >> (i % 64);
+            if (0 != word) {
+                return i + __builtin_ctzll(word);
+            }
+        }
+        return SLOT_COUNT;
+    }
+    /// cascade the earliest non-empty wheel slot if its window begins not later than *now*, return false if none
+    bool Cascade(uint64_t now);
+
+private:
+    std::vector<Node>           m_nodeVec;                              /// timers indexed by handle
+    std::vector<HANDLE_TYPE>    m_freeHtVec;                            /// recycled handles
+    uint64_t                    m_now;                                  /// current time
+    NEAR_QUEUE_TYPE             m_nearQueue;                            /// timers due in current window
+    std::vector<HANDLE_TYPE>    m_slotVecs[LEVEL_COUNT][SLOT_COUNT];    /// handles of wheel slots, level 0 unused
+    uint64_t                    m_bitmaps[LEVEL_COUNT][BITMAP_WORDS];   /// non-empty slots of every level
+    std::vector<HANDLE_TYPE>    m_cascadeVec;                           /// scratch of *Cascade*
+};
+
+template <class T, class Policy>
+template <class U>
+typename HierarchicalTimerWheel<T, Policy>::HANDLE_TYPE
+HierarchicalTimerWheel<T, Policy>::ScheduleValue(uint64_t deadline, U&& value) {
+    HANDLE_TYPE ht;
+    if (!m_freeHtVec.empty()) {
+        ht = m_freeHtVec.back();
+        m_freeHtVec.pop_back();
+        m_nodeVec[ht].m_value = std::forward<U>(value);
+    }
+    else {
+        if (m_nodeVec.size() >= MAX_COUNT) {
+            return INVALID_HANDLE;
+        }
+        ht = m_nodeVec.size();
+        m_nodeVec.push_back(Node{std::forward<U>(value), 0, LEVEL_COUNT, 0, 0});
+    }
+    m_nodeVec[ht].m_deadline = deadline;
+    Link(ht);
+    return ht;
+}
+
+template <class T, class Policy>
+bool HierarchicalTimerWheel<T, Policy>::Cascade(uint64_t now) {
+    /// slots of a lower level after current digit are in the current window of the upper level, so they come first
+    for (size_t level = 1; level < LEVEL_COUNT; ++level) {
+        size_t shift = level * SLOT_BITS;
+        size_t slot = NextSlot(level, (m_now >> shift) & (SLOT_COUNT - 1));
+        if (slot == SLOT_COUNT) {
+            continue;
+        }
+        /// begin of the window of the slot, higher digits are the same as current time
+        uint64_t windowMask = shift + SLOT_BITS >= 64 ? 0 : ~uint64_t(0) << (shift + SLOT_BITS);
+        uint64_t windowBegin = (m_now & windowMask) | (uint64_t(slot) << shift);
+        if (windowBegin > now) {
+            return false;
+        }
+        m_now = windowBegin;
+        m_cascadeVec.swap(m_slotVecs[level][slot]);
+        m_bitmaps[level][slot / 64] &= ~(uint64_t(1) << (slot % 64));
+        for (size_t i = 0; i < m_cascadeVec.size(); ++i) {
+            Link(m_cascadeVec[i]);
+        }
+        m_cascadeVec.clear();
+        return true;
+    }
+    return false;
+}
+
+template <class T, class Policy>
+template <class ExpireFunc>
+size_t HierarchicalTimerWheel<T, Policy>::PopExpired(uint64_t now, ExpireFunc&& onExpire) {
+    size_t expiredCnt = 0;
+    while (true) {
+        while (!m_nearQueue.IsEmpty() && m_nearQueue.TopElem().m_deadline <= now) {
+            HANDLE_TYPE ht = m_nearQueue.TopElem().m_ht;
+            m_nearQueue.Pop();
+            /// released before the callback, which may schedule timers and so move nodes
+            T value;
+            Release(ht, &value);
+            ++expiredCnt;
+            onExpire(ht, value);
+        }
+        /// wheel timers are later than the heap ones
+        if (!m_nearQueue.IsEmpty() || !Cascade(now)) {
+            break;
+        }
+    }
+    /// no wheel window begins before *now*, so timers stay in their slots
+    m_now = std::max(m_now, now);
+    return expiredCnt;
+}
+
+#endif //__INDEXEDPQ_HIERARCHICAL_TIMER_WHEEL_H__
@@ -0,0 +1,219 @@
+#include "indexedpq/indexed-min-max-heap-unittest.h"
+#include "indexedpq/indexed-priority-queue-unittest.h"
+#include <cppunit/TestAssert.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+CPPUNIT_TEST_SUITE_REGISTRATION(IndexedMinMaxHeapTest);
+
+void IndexedMinMaxHeapTest::NormalTest() {
+    /// same MaxTop order as IndexedPriorityQueue with std::less, the bottom is the min
+    IndexedMinMaxHeap<uint64_t> heap;
+    CPPUNIT_ASSERT(heap.IsEmpty());
+    size_t ht5 = heap.Push(5);
+    CPPUNIT_ASSERT_EQUAL(ht5, heap.Top());
+    CPPUNIT_ASSERT_EQUAL(ht5, heap.Bottom());
+    size_t ht9 = heap.Push(9);
+    size_t ht1 = heap.Push(1);
+    size_t ht7 = heap.Push(7);
+    CPPUNIT_ASSERT_EQUAL((size_t)4, heap.GetCount());
+    CPPUNIT_ASSERT_EQUAL(ht9, heap.Top());
+    CPPUNIT_ASSERT_EQUAL(ht1, heap.Bottom());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, heap.BottomElem());
+    uint64_t removed = 0;
+    CPPUNIT_ASSERT_EQUAL(ht1, heap.Update(ht1, 10, &removed));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, removed);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)10, heap.TopElem());
+    CPPUNIT_ASSERT_EQUAL(ht5, heap.Bottom());
+    CPPUNIT_ASSERT_EQUAL(ht5, heap.PopBottom());
+    CPPUNIT_ASSERT(!heap.Contains(ht5));
+    CPPUNIT_ASSERT(heap.Update(ht5, 3) == heap.INVALID_HANDLE);
+    CPPUNIT_ASSERT_EQUAL(ht1, heap.Pop());
+    CPPUNIT_ASSERT(heap.Remove(ht7, &removed));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)7, removed);
+    CPPUNIT_ASSERT(!heap.Remove(ht7));
+    CPPUNIT_ASSERT_EQUAL(ht9, heap.Top());
+    CPPUNIT_ASSERT_EQUAL(ht9, heap.Bottom());
+    CPPUNIT_ASSERT_EQUAL(ht9, heap.PopBottom());
+    CPPUNIT_ASSERT(heap.IsEmpty());
+
+    /// handles are recycled
+    size_t ht = heap.Push(4);
+    CPPUNIT_ASSERT(ht == ht9 || ht == ht7 || ht == ht1 || ht == ht5);
+
+    /// FakeItem order: the top ranks last
+    IndexedMinMaxHeap<FakeItem, FakeItemComparator> itemHeap;
+    vector<FakeItem> itemsVec;
+    FakeItemMgr::sGenItems(1000, 1000, itemsVec);
+    for (const FakeItem& item : itemsVec) { itemHeap.Push(item); }
+    vector<FakeItem> sortedVec(itemsVec);
+    std::sort(sortedVec.begin(), sortedVec.end(), FakeItemComparator());
+    CPPUNIT_ASSERT(itemHeap.IsHeap());
+    for (size_t i = 0; i < sortedVec.size() / 2; ++i) {
+        CPPUNIT_ASSERT(sortedVec[i] == itemHeap.BottomElem());
+        CPPUNIT_ASSERT(sortedVec[sortedVec.size() - 1 - i] == itemHeap.TopElem());
+        itemHeap.PopBottom();
+        itemHeap.Pop();
+    }
+    CPPUNIT_ASSERT(itemHeap.IsEmpty());
+}
+
+void IndexedMinMaxHeapTest::InternalRandomOpsTest(size_t opCount, uint64_t maxValue) {
+    typedef IndexedMinMaxHeap<uint64_t> Heap;
+    Heap heap(4);
+    /// reference of (value, handle)
+    set<pair<uint64_t, size_t> > refSet;
+    map<size_t, uint64_t> ht2Values;
+    vector<size_t> hts;
+    for (size_t i = 0; i < opCount; ++i) {
+        int64_t op = RandomUtil<int64_t>::RandomInt64(0, 9);
+        uint64_t value = RandomUtil<int64_t>::RandomInt64(0, maxValue);
+        if (op < 4 || ht2Values.empty()) {
+            size_t ht = heap.Push(value);
+            CPPUNIT_ASSERT(ht2Values.find(ht) == ht2Values.end());
+            ht2Values[ht] = value;
+            refSet.insert(make_pair(value, ht));
+        }
+        else {
+            auto it = ht2Values.begin();
+            std::advance(it, RandomUtil<int64_t>::RandomInt64(0, ht2Values.size() - 1));
+            size_t ht = it->first;
+            uint64_t removed = 0;
+            if (op < 6) {
+                CPPUNIT_ASSERT_EQUAL(ht, heap.Update(ht, value, &removed));
+                CPPUNIT_ASSERT_EQUAL(it->second, removed);
+                refSet.erase(make_pair(it->second, ht));
+                refSet.insert(make_pair(value, ht));
+                it->second = value;
+            }
+            else if (op < 7) {
+                CPPUNIT_ASSERT(heap.Remove(ht, &removed));
+                CPPUNIT_ASSERT_EQUAL(it->second, removed);
+                refSet.erase(make_pair(it->second, ht));
+                ht2Values.erase(it);
+            }
+            else {
+                /// ties may be at either end, so compare values
+                bool isTop = op < 8;
+                uint64_t expected = isTop ? refSet.rbegin()->first : refSet.begin()->first;
+                CPPUNIT_ASSERT_EQUAL(expected, isTop ? heap.TopElem() : heap.BottomElem());
+                size_t poppedHt = isTop ? heap.Pop() : heap.PopBottom();
+                CPPUNIT_ASSERT_EQUAL(expected, ht2Values[poppedHt]);
+                refSet.erase(make_pair(expected, poppedHt));
+                ht2Values.erase(poppedHt);
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL(refSet.size(), heap.GetCount());
+        if (i % 100 == 0) {
+            CPPUNIT_ASSERT(heap.IsHeap());
+        }
+    }
+    CPPUNIT_ASSERT(heap.IsHeap());
+}
+
+void IndexedMinMaxHeapTest::RandomOpsTest() {
+    InternalRandomOpsTest(20000, 1e6);
+    /// many ties
+    InternalRandomOpsTest(20000, 10);
+}
+
+void IndexedMinMaxHeapTest::FixedTest() {
+    /// bounded cache keeps the smallest values, evicts by the top and serves by the bottom
+    size_t capacity = 100, count = 10000;
+    IndexedMinMaxHeap<uint64_t> heap(capacity, true);
+    vector<uint64_t> values;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t value = RandomUtil<int64_t>::RandomInt64(0, 1e9);
+        values.push_back(value);
+        uint64_t removed = 0;
+        bool isFull = heap.IsFull();
+        uint64_t top = isFull ? heap.TopElem() : 0;
+        size_t ht = heap.Push(value, &removed);
+        if (isFull) {
+            if (value < top) {
+                CPPUNIT_ASSERT(ht != heap.INVALID_HANDLE);
+                CPPUNIT_ASSERT_EQUAL(top, removed);
+            }
+            else {
+                CPPUNIT_ASSERT(ht == heap.INVALID_HANDLE);
+                CPPUNIT_ASSERT_EQUAL(value, removed);
+            }
+        }
+    }
+    CPPUNIT_ASSERT(heap.IsFull());
+    CPPUNIT_ASSERT(heap.IsHeap());
+    std::sort(values.begin(), values.end());
+    for (size_t i = 0; i < capacity; ++i) {
+        CPPUNIT_ASSERT_EQUAL(values[i], heap.BottomElem());
+        heap.PopBottom();
+    }
+    CPPUNIT_ASSERT(heap.IsEmpty());
+
+    /// new element referring to the old one itself is kept while the old one is moved out
+    IndexedMinMaxHeap<string> aliasHeap(2, true);
+    size_t ht = aliasHeap.Push(string("self"));
+    aliasHeap.Push(string("b"));
+    string old;
+    aliasHeap.Update(ht, aliasHeap.Elem(ht), &old);
+    CPPUNIT_ASSERT(old == "self");
+    CPPUNIT_ASSERT(aliasHeap.Elem(ht) == "self");
+    aliasHeap.Update(ht, old, &old);
+    CPPUNIT_ASSERT(old == "self");
+    CPPUNIT_ASSERT(aliasHeap.Elem(ht) == "self");
+    /// a full fixed heap replaces its top by *Update* as well
+    old = "a";
+    CPPUNIT_ASSERT_EQUAL(ht, aliasHeap.Push(old, &old));
+    CPPUNIT_ASSERT(old == "self");
+    CPPUNIT_ASSERT(aliasHeap.Elem(ht) == "a");
+    CPPUNIT_ASSERT(aliasHeap.IsHeap());
+}
+
+void IndexedMinMaxHeapTest::PerformanceTest() {
+    /// sliding leaderboard: scores change, the best is served and the worst is evicted, against two IndexedPQs kept
+    /// in sync by two handle maps
+    size_t count = 1e5, opCount = 5e5;
+    vector<uint64_t> values;
+    for (size_t i = 0; i < count + opCount; ++i) {
+        values.push_back(RandomUtil<int64_t>::RandomInt64(0, 1e12));
+    }
+
+    IndexedMinMaxHeap<uint64_t> heap(count);
+    vector<size_t> hts;
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    for (size_t i = 0; i < count; ++i) {
+        hts.push_back(heap.Push(values[i]));
+    }
+    uint64_t checksum = 0;
+    for (size_t i = 0; i < opCount; ++i) {
+        heap.Update(hts[i % count], values[count + i]);
+        if (i % 4 == 0) {
+            checksum += heap.TopElem() - heap.BottomElem();
+        }
+    }
+    int64_t tHeap = TimeUtil::CurrentTimeInMicroSeconds();
+
+    IndexedPriorityQueue<uint64_t> maxPq(count);
+    IndexedPriorityQueue<uint64_t, std::greater<uint64_t> > minPq(count);
+    vector<size_t> maxHts, minHts;
+    for (size_t i = 0; i < count; ++i) {
+        maxHts.push_back(maxPq.Push(values[i]));
+        minHts.push_back(minPq.Push(values[i]));
+    }
+    uint64_t pqChecksum = 0;
+    for (size_t i = 0; i < opCount; ++i) {
+        maxPq.Update(maxHts[i % count], values[count + i]);
+        minPq.Update(minHts[i % count], values[count + i]);
+        if (i % 4 == 0) {
+            pqChecksum += maxPq.TopElem() - minPq.TopElem();
+        }
+    }
+    int64_t tPq = TimeUtil::CurrentTimeInMicroSeconds();
+    cout << "-------------count:[" << count << "],opCount:[" << opCount << "],min-max heap:["
+         << (tHeap - tBegin) / 1000 << "]ms,two IndexedPQs:[" << (tPq - tHeap) / 1000 << "]ms." << endl;
+    CPPUNIT_ASSERT_EQUAL(pqChecksum, checksum);
+    CPPUNIT_ASSERT(heap.IsHeap());
+}
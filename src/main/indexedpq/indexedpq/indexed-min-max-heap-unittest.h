@@ -0,0 +1,31 @@
+#ifndef __INDEXEDPQ_TEST_INDEXED_MIN_MAX_HEAP_UNITTEST_H__
+#define __INDEXEDPQ_TEST_INDEXED_MIN_MAX_HEAP_UNITTEST_H__
+
+#include "indexedpq/indexed-min-max-heap.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+class IndexedMinMaxHeapTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(IndexedMinMaxHeapTest);
+    CPPUNIT_TEST(NormalTest);
+    CPPUNIT_TEST(RandomOpsTest);
+    CPPUNIT_TEST(FixedTest);
+    CPPUNIT_TEST(PerformanceTest);
+    CPPUNIT_TEST_SUITE_END();
+public:
+    IndexedMinMaxHeapTest() {}
+    ~IndexedMinMaxHeapTest() {}
+    void setUp() {}
+    void tearDown() {}
+public:
+
+    void NormalTest();
+    void RandomOpsTest();
+    void FixedTest();
+    void PerformanceTest();
+
+private:
+    void InternalRandomOpsTest(size_t opCount, uint64_t maxValue);
+};
+
+
+#endif //__INDEXEDPQ_TEST_INDEXED_MIN_MAX_HEAP_UNITTEST_H__
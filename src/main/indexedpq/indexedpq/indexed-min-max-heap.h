@@ -0,0 +1,290 @@
+#ifndef __INDEXEDPQ_INDEXED_MIN_MAX_HEAP_H__
+#define __INDEXEDPQ_INDEXED_MIN_MAX_HEAP_H__
+
+#include "indexedpq/indexed-priority-queue.h"
+#include <cassert>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/**
+ *@brief     indexed double-ended min-max heap sharing the handle API of IndexedPriorityQueue
+ *           (Push/Pop/Update/Remove/Top/Elem), plus *Bottom*, *BottomElem* and *PopBottom* of the other end, so one
+ *           heap serves both the best and the worst element of bounded caches and sliding leaderboards.
+ *           Levels alternate, nodes on even levels are not less than their descendants and nodes on odd levels are not
+ *           greater. The top is the root and the bottom is one of its children, both in O(1), and every change is
+ *           O(logN) with about twice the comparisons of a binary heap.
+ *           *CompareFunc* has the same meaning as IndexedPriorityQueue, the top is the max wrt it and the bottom is the
+ *           min. A fixed heap keeps *nSize* elements as a fixed IndexedPriorityQueue does, a new element replaces the
+ *           top if it is less than the top.
+ *           Only *HANDLE_TYPE* of *Policy* is used.
+ */
+template <class T, class CompareFunc = std::less<T>, class Policy = IndexedPQDefaultPolicy >
+class IndexedMinMaxHeap
+{
+public:
+    typedef T                               VALUE_TYPE;
+    typedef CompareFunc                     VALUE_COMPARE;
+    typedef Policy                          POLICY_TYPE;
+    typedef typename Policy::HANDLE_TYPE    HANDLE_TYPE;
+
+    static constexpr HANDLE_TYPE INVALID_HANDLE = HANDLE_TYPE(-1);
+    static constexpr size_t MAX_COUNT = INVALID_HANDLE;
+
+public:
+    IndexedMinMaxHeap(size_t nSize = 32, bool isFixed = false, VALUE_COMPARE compareFunc = VALUE_COMPARE())
+        : m_Size(std::max<size_t>(nSize, 1)), m_isFixed(isFixed), m_valueCmpFunc(compareFunc) {
+        m_elemVec.reserve(m_Size);
+        m_heapVec.reserve(m_Size);
+        m_posVec.reserve(m_Size);
+    }
+
+    inline size_t   GetCount() { return m_heapVec.size(); }
+    inline bool     IsEmpty() { return m_heapVec.empty(); }
+    /// whether heap is fixed and full
+    inline bool     IsFull() { return m_isFixed && m_heapVec.size() == m_Size; }
+    inline const T& Elem(HANDLE_TYPE ht) { assert(ht < m_elemVec.size()); return m_elemVec[ht]; }
+    /// whether element of handle *ht* is in the heap
+    inline bool     Contains(HANDLE_TYPE ht) { return ht < m_posVec.size() && m_posVec[ht] < m_heapVec.size(); }
+    /// return ht of top element, the max one
+    inline HANDLE_TYPE Top() { assert(!IsEmpty()); return m_heapVec[0]; }
+    /// return value of top element
+    inline const T& TopElem() { return m_elemVec[Top()]; }
+    /// return ht of bottom element, the min one
+    inline HANDLE_TYPE Bottom() { return m_heapVec[BottomIndex()]; }
+    /// return value of bottom element
+    inline const T& BottomElem() { return m_elemVec[Bottom()]; }
+
+    /// Reset status of heap
+    void Reset() { m_elemVec.clear(); m_heapVec.clear(); m_posVec.clear(); m_freeHtVec.clear(); }
+
+    /**
+     *@brief     push *elem* to heap. If the heap is fixed and full, *elem* replaces the top element if it is less than
+     *           the top, and takes over its handle.
+     *@param     pRemovedElem --- the replaced top element, or *elem* if it is not pushed, when it is not null.
+     *@return    handle of *elem*, INVALID_HANDLE if it is not pushed.
+     */
+    HANDLE_TYPE Push(const T& elem, T* pRemovedElem = nullptr) { return PushElem(elem, pRemovedElem); }
+    HANDLE_TYPE Push(T&& elem, T* pRemovedElem = nullptr) { return PushElem(std::move(elem), pRemovedElem); }
+
+    /// pop top element and recycle its handle, return handle of popped element
+    HANDLE_TYPE Pop() { HANDLE_TYPE ht = Top(); RemoveAt(0); return ht; }
+    /// pop bottom element and recycle its handle, return handle of popped element
+    HANDLE_TYPE PopBottom() { HANDLE_TYPE ht = Bottom(); RemoveAt(m_posVec[ht]); return ht; }
+
+    /**
+     *@brief     update element of handle *ht* to *newElem*.
+     *@param     pRemovedElem --- element substituted if it is not null.
+     *@return    *ht*, INVALID_HANDLE if *ht* is not in the heap.
+     */
+    HANDLE_TYPE Update(HANDLE_TYPE ht, const T& newElem, T* pRemovedElem = nullptr) { return UpdateElem(ht, newElem, pRemovedElem); }
+    HANDLE_TYPE Update(HANDLE_TYPE ht, T&& newElem, T* pRemovedElem = nullptr) { return UpdateElem(ht, std::move(newElem), pRemovedElem); }
+
+    /// remove element of handle *ht* and recycle the handle, return false if it is not in the heap
+    bool Remove(HANDLE_TYPE ht, T* pRemovedElem = nullptr) {
+        if (!Contains(ht)) {
+            return false;
+        }
+        if (nullptr != pRemovedElem) { *pRemovedElem = std::move(m_elemVec[ht]); }
+        RemoveAt(m_posVec[ht]);
+        return true;
+    }
+
+    /// whether min-max heap feature holds, used by tests
+    bool IsHeap();
+
+private:
+    template<class U>
+    HANDLE_TYPE PushElem(U&& elem, T* pRemovedElem);
+    template<class U>
+    HANDLE_TYPE UpdateElem(HANDLE_TYPE ht, U&& newElem, T* pRemovedElem);
+
+    /// whether heap index *nIndex* is on a max level, i.e. an even level
+    static inline bool IsMaxLevel(size_t nIndex) {
+        size_t level = sizeof(unsigned long long) * 8 - 1 - __builtin_clzll((unsigned long long)nIndex + 1);
+        return 0 == (level & 1);
+    }
+    /// whether element at heap index *a* is less than element at *b*
+    inline bool Less(size_t a, size_t b) { return m_valueCmpFunc(m_elemVec[m_heapVec[a]], m_elemVec[m_heapVec[b]]); }
+    inline size_t BottomIndex() {
+        assert(!IsEmpty());
+        if (m_heapVec.size() < 3) { return m_heapVec.size() - 1; }
+        return Less(2, 1) ? 2 : 1;
+    }
+    inline void SwapHeapElem(size_t a, size_t b) {
+        std::swap(m_heapVec[a], m_heapVec[b]);
+        m_posVec[m_heapVec[a]] = a;
+        m_posVec[m_heapVec[b]] = b;
+    }
+    /// restore heap feature after element at *nIndex* changed, return its new heap index
+    size_t Adjust(size_t nIndex) {
+        HANDLE_TYPE ht = m_heapVec[nIndex];
+        TrickleDown(nIndex);
+        /// the subtree is a min-max heap now, so only ancestors of the element may be violated
+        BubbleUp(m_posVec[ht]);
+        return m_posVec[ht];
+    }
+    /// move element at *nIndex* upwards along levels of its kind
+    void BubbleUp(size_t nIndex);
+    /// move element at *nIndex* downwards, *IsMax* is the kind of its level
+    template<bool IsMax>
+    void TrickleDown(size_t nIndex);
+    void TrickleDown(size_t nIndex) {
+        if (IsMaxLevel(nIndex)) { TrickleDown<true>(nIndex); }
+        else { TrickleDown<false>(nIndex); }
+    }
+    /// unlink element at *nIndex* and recycle its handle
+    void RemoveAt(size_t nIndex) {
+        HANDLE_TYPE ht = m_heapVec[nIndex];
+        size_t lastIndex = m_heapVec.size() - 1;
+        if (nIndex != lastIndex) {
+            SwapHeapElem(nIndex, lastIndex);
+        }
+        m_heapVec.pop_back();
+        m_posVec[ht] = INVALID_HANDLE;
+        m_freeHtVec.push_back(ht);
+        if (nIndex < m_heapVec.size()) {
+            Adjust(nIndex);
+        }
+    }
+
+private:
+    std::vector<T>              m_elemVec;      /// elements indexed by handle
+    std::vector<HANDLE_TYPE>    m_heapVec;      /// handles in heap order
+    std::vector<HANDLE_TYPE>    m_posVec;       /// heap index of handle, INVALID_HANDLE if not in heap
+    std::vector<HANDLE_TYPE>    m_freeHtVec;    /// recycled handles
+    size_t                      m_Size;         /// bound of fixed heap
+    bool                        m_isFixed;
+    VALUE_COMPARE               m_valueCmpFunc;
+};
+
+template <class T, class CompareFunc, class Policy>
+template <class U>
+typename IndexedMinMaxHeap<T, CompareFunc, Policy>::HANDLE_TYPE
+IndexedMinMaxHeap<T, CompareFunc, Policy>::PushElem(U&& elem, T* pRemovedElem) {
+    if (IsFull()) {
+        HANDLE_TYPE topHt = m_heapVec[0];
+        if (m_valueCmpFunc(elem, m_elemVec[topHt])) {
+            return UpdateElem(topHt, std::forward<U>(elem), pRemovedElem);
+        }
+        if (nullptr != pRemovedElem) { *pRemovedElem = std::forward<U>(elem); }
+        return INVALID_HANDLE;
+    }
+    HANDLE_TYPE ht;
+    if (!m_freeHtVec.empty()) {
+        ht = m_freeHtVec.back();
+        m_freeHtVec.pop_back();
+        m_elemVec[ht] = std::forward<U>(elem);
+    }
+    else {
+        if (m_elemVec.size() >= MAX_COUNT) {
+            if (nullptr != pRemovedElem) { *pRemovedElem = std::forward<U>(elem); }
+            return INVALID_HANDLE;
+        }
+        ht = m_elemVec.size();
+        m_elemVec.push_back(std::forward<U>(elem));
+        m_posVec.push_back(INVALID_HANDLE);
+    }
+    m_posVec[ht] = m_heapVec.size();
+    m_heapVec.push_back(ht);
+    BubbleUp(m_heapVec.size() - 1);
+    return ht;
+}
+
+template <class T, class CompareFunc, class Policy>
+template <class U>
+typename IndexedMinMaxHeap<T, CompareFunc, Policy>::HANDLE_TYPE
+IndexedMinMaxHeap<T, CompareFunc, Policy>::UpdateElem(HANDLE_TYPE ht, U&& newElem, T* pRemovedElem) {
+    if (!Contains(ht)) {
+        return INVALID_HANDLE;
+    }
+    if (nullptr != pRemovedElem) {
+        /// *newElem* may refer to the old element itself or to *pRemovedElem*, so it is taken before the move out
+        T newValue(std::forward<U>(newElem));
+        *pRemovedElem = std::move(m_elemVec[ht]);
+        m_elemVec[ht] = std::move(newValue);
+    }
+    else {
+        m_elemVec[ht] = std::forward<U>(newElem);
+    }
+    Adjust(m_posVec[ht]);
+    return ht;
+}
+
+template <class T, class CompareFunc, class Policy>
+void IndexedMinMaxHeap<T, CompareFunc, Policy>::BubbleUp(size_t nIndex) {
+    if (0 == nIndex) {
+        return;
+    }
+    size_t parent = (nIndex - 1) >> 1;
+    bool isMax = IsMaxLevel(nIndex);
+    /// the parent is on a level of the other kind, crossing it turns the element to that kind
+    if (isMax ? Less(nIndex, parent) : Less(parent, nIndex)) {
+        SwapHeapElem(nIndex, parent);
+        nIndex = parent;
+        isMax = !isMax;
+    }
+    while (nIndex > 2) {
+        size_t grandParent = (((nIndex - 1) >> 1) - 1) >> 1;
+        if (!(isMax ? Less(grandParent, nIndex) : Less(nIndex, grandParent))) {
+            break;
+        }
+        SwapHeapElem(nIndex, grandParent);
+        nIndex = grandParent;
+    }
+}
+
+template <class T, class CompareFunc, class Policy>
+template <bool IsMax>
+void IndexedMinMaxHeap<T, CompareFunc, Policy>::TrickleDown(size_t nIndex) {
+    /// whether element at *a* is nearer to the end of this level kind than element at *b*
+    auto isBefore = [this](size_t a, size_t b) { return IsMax ? Less(b, a) : Less(a, b); };
+    size_t count = m_heapVec.size();
+    while (true) {
+        size_t firstChild = 2 * nIndex + 1;
+        if (firstChild >= count) {
+            return;
+        }
+        /// the extreme one of children and grandchildren
+        size_t best = firstChild;
+        if (firstChild + 1 < count && isBefore(firstChild + 1, best)) { best = firstChild + 1; }
+        size_t firstGrandChild = 2 * firstChild + 1;
+        for (size_t i = firstGrandChild; i < firstGrandChild + 4 && i < count; ++i) {
+            if (isBefore(i, best)) { best = i; }
+        }
+        if (!isBefore(best, nIndex)) {
+            return;
+        }
+        SwapHeapElem(best, nIndex);
+        if (best < firstGrandChild) {
+            return;
+        }
+        /// element moved down two levels may cross its new parent of the other kind
+        size_t parent = (best - 1) >> 1;
+        if (isBefore(parent, best)) {
+            SwapHeapElem(best, parent);
+        }
+        nIndex = best;
+    }
+}
+
+template <class T, class CompareFunc, class Policy>
+bool IndexedMinMaxHeap<T, CompareFunc, Policy>::IsHeap() {
+    for (size_t i = 1; i < m_heapVec.size(); ++i) {
+        if (m_posVec[m_heapVec[i]] != i) {
+            return false;
+        }
+        /// every ancestor bounds its descendants by its level kind
+        for (size_t ancestor = (i - 1) >> 1; ; ancestor = (ancestor - 1) >> 1) {
+            if (IsMaxLevel(ancestor) ? Less(ancestor, i) : Less(i, ancestor)) {
+                return false;
+            }
+            if (0 == ancestor) {
+                break;
+            }
+        }
+    }
+    return m_heapVec.empty() || m_posVec[m_heapVec[0]] == 0;
+}
+
+#endif //__INDEXEDPQ_INDEXED_MIN_MAX_HEAP_H__
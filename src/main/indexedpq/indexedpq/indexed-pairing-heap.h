@@ -0,0 +1,232 @@
+#ifndef __INDEXEDPQ_INDEXED_PAIRING_HEAP_H__
+#define __INDEXEDPQ_INDEXED_PAIRING_HEAP_H__
+
+#include "indexedpq/indexed-priority-queue.h"
+#include <cassert>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/**
+ *@brief     indexed pairing heap sharing the handle API of IndexedPriorityQueue(Push/Pop/Update/Remove/Top/Elem).
+ *           Moving an element towards the top by *Update* is O(1) amortized: its subtree is cut and melded with the
+ *           root, without sifting. So it beats the d-ary heap when most updates only improve priority, such as
+ *           decrease-key in shortest path and scheduling. Moving an element away from the top is a *Remove* and a
+ *           re-insert of the same handle, O(logN) amortized.
+ *           *CompareFunc* has the same meaning as IndexedPriorityQueue, the top is the max wrt it.
+ *           Only *HANDLE_TYPE* of *Policy* is used.
+ */
+template <class T, class CompareFunc = std::less<T>, class Policy = IndexedPQDefaultPolicy >
+class IndexedPairingHeap
+{
+public:
+    typedef T                               VALUE_TYPE;
+    typedef CompareFunc                     VALUE_COMPARE;
+    typedef Policy                          POLICY_TYPE;
+    typedef typename Policy::HANDLE_TYPE    HANDLE_TYPE;
+
+    static constexpr HANDLE_TYPE INVALID_HANDLE = HANDLE_TYPE(-1);
+    static constexpr size_t MAX_COUNT = INVALID_HANDLE;
+
+public:
+    IndexedPairingHeap(size_t nSizeHint = 32, VALUE_COMPARE compareFunc = VALUE_COMPARE())
+        : m_root(INVALID_HANDLE), m_elemCnt(0), m_valueCmpFunc(compareFunc) {
+        m_nodeVec.reserve(nSizeHint);
+    }
+
+    inline size_t   GetCount() { return m_elemCnt; }
+    inline bool     IsEmpty() { return m_elemCnt == 0; }
+    inline const T& Elem(HANDLE_TYPE ht) { assert(ht < m_nodeVec.size()); return m_nodeVec[ht].m_elem; }
+    /// whether element of handle *ht* is in the heap
+    inline bool     Contains(HANDLE_TYPE ht) { return ht < m_nodeVec.size() && m_nodeVec[ht].m_isInHeap; }
+    /// return ht of top element
+    inline HANDLE_TYPE Top() { assert(m_elemCnt > 0); return m_root; }
+    /// return value of top element
+    inline const T& TopElem() { assert(m_elemCnt > 0); return m_nodeVec[m_root].m_elem; }
+
+    /// Reset status of heap
+    void Reset() { m_nodeVec.clear(); m_freeHtVec.clear(); m_root = INVALID_HANDLE; m_elemCnt = 0; }
+
+    /// push *elem*, return its handle, INVALID_HANDLE if *MAX_COUNT* is reached.
+    HANDLE_TYPE Push(const T& elem) { return PushElem(elem); }
+    HANDLE_TYPE Push(T&& elem) { return PushElem(std::move(elem)); }
+
+    /// pop top element and recycle its handle, return handle of popped element
+    HANDLE_TYPE Pop() {
+        assert(m_elemCnt > 0);
+        HANDLE_TYPE ht = m_root;
+        Detach(ht);
+        return ht;
+    }
+
+    /**
+     *@brief     update element of handle *ht* to *newElem*.
+     *@param     pRemovedElem --- element substituted if it is not null.
+     *@return    *ht*, INVALID_HANDLE if *ht* is not in the heap.
+     */
+    HANDLE_TYPE Update(HANDLE_TYPE ht, const T& newElem, T* pRemovedElem = nullptr) { return UpdateElem(ht, newElem, pRemovedElem); }
+    HANDLE_TYPE Update(HANDLE_TYPE ht, T&& newElem, T* pRemovedElem = nullptr) { return UpdateElem(ht, std::move(newElem), pRemovedElem); }
+
+    /// remove element of handle *ht* and recycle the handle, return false if it is not in the heap
+    bool Remove(HANDLE_TYPE ht, T* pRemovedElem = nullptr) {
+        if (!Contains(ht)) {
+            return false;
+        }
+        if (nullptr != pRemovedElem) { *pRemovedElem = std::move(m_nodeVec[ht].m_elem); }
+        Detach(ht);
+        return true;
+    }
+
+private:
+    struct Node {
+        T               m_elem;
+        HANDLE_TYPE     m_child;        /// leftmost child
+        HANDLE_TYPE     m_sibling;      /// right sibling
+        HANDLE_TYPE     m_prev;         /// left sibling, or parent if it is the leftmost child
+        bool            m_isInHeap;
+    };
+
+    template<class U>
+    HANDLE_TYPE PushElem(U&& elem);
+    template<class U>
+    HANDLE_TYPE UpdateElem(HANDLE_TYPE ht, U&& newElem, T* pRemovedElem);
+
+    /// link roots of two heaps, return the new root
+    HANDLE_TYPE Meld(HANDLE_TYPE a, HANDLE_TYPE b) {
+        if (a == INVALID_HANDLE) { return b; }
+        if (b == INVALID_HANDLE) { return a; }
+        if (m_valueCmpFunc(m_nodeVec[a].m_elem, m_nodeVec[b].m_elem)) {
+            std::swap(a, b);
+        }
+        Node& parent = m_nodeVec[a];
+        Node& child = m_nodeVec[b];
+        child.m_prev = a;
+        child.m_sibling = parent.m_child;
+        if (parent.m_child != INVALID_HANDLE) { m_nodeVec[parent.m_child].m_prev = b; }
+        parent.m_child = b;
+        return a;
+    }
+    /// cut subtree of non-root node *ht* from its parent
+    void Cut(HANDLE_TYPE ht) {
+        Node& node = m_nodeVec[ht];
+        Node& prev = m_nodeVec[node.m_prev];
+        if (prev.m_child == ht) { prev.m_child = node.m_sibling; }
+        else { prev.m_sibling = node.m_sibling; }
+        if (node.m_sibling != INVALID_HANDLE) { m_nodeVec[node.m_sibling].m_prev = node.m_prev; }
+        node.m_prev = node.m_sibling = INVALID_HANDLE;
+    }
+    /// merge children list starting at *first* with the standard two pass pairing, return the new root
+    HANDLE_TYPE MergePairs(HANDLE_TYPE first);
+    /// unlink node *ht* from heap, its children are merged back, and recycle its handle
+    void Detach(HANDLE_TYPE ht) {
+        if (ht != m_root) { Cut(ht); }
+        HANDLE_TYPE subRoot = MergePairs(m_nodeVec[ht].m_child);
+        m_root = ht == m_root ? subRoot : Meld(m_root, subRoot);
+        m_nodeVec[ht].m_child = INVALID_HANDLE;
+        m_nodeVec[ht].m_isInHeap = false;
+        m_freeHtVec.push_back(ht);
+        --m_elemCnt;
+    }
+
+private:
+    std::vector<Node>           m_nodeVec;      /// nodes indexed by handle
+    std::vector<HANDLE_TYPE>    m_freeHtVec;    /// recycled handles
+    std::vector<HANDLE_TYPE>    m_pairVec;      /// scratch of *MergePairs*
+    HANDLE_TYPE                 m_root;
+    size_t                      m_elemCnt;
+    VALUE_COMPARE               m_valueCmpFunc;
+};
+
+template <class T, class CompareFunc, class Policy>
+template <class U>
+typename IndexedPairingHeap<T, CompareFunc, Policy>::HANDLE_TYPE
+IndexedPairingHeap<T, CompareFunc, Policy>::PushElem(U&& elem) {
+    HANDLE_TYPE ht;
+    if (!m_freeHtVec.empty()) {
+        ht = m_freeHtVec.back();
+        m_freeHtVec.pop_back();
+        m_nodeVec[ht].m_elem = std::forward<U>(elem);
+    }
+    else {
+        if (m_nodeVec.size() >= MAX_COUNT) {
+            return INVALID_HANDLE;
+        }
+        ht = m_nodeVec.size();
+        m_nodeVec.push_back(Node{std::forward<U>(elem), INVALID_HANDLE, INVALID_HANDLE, INVALID_HANDLE, false});
+    }
+    Node& node = m_nodeVec[ht];
+    node.m_child = node.m_sibling = node.m_prev = INVALID_HANDLE;
+    node.m_isInHeap = true;
+    m_root = Meld(m_root, ht);
+    ++m_elemCnt;
+    return ht;
+}
+
+template <class T, class CompareFunc, class Policy>
+template <class U>
+typename IndexedPairingHeap<T, CompareFunc, Policy>::HANDLE_TYPE
+IndexedPairingHeap<T, CompareFunc, Policy>::UpdateElem(HANDLE_TYPE ht, U&& newElem, T* pRemovedElem) {
+    if (!Contains(ht)) {
+        return INVALID_HANDLE;
+    }
+    Node& node = m_nodeVec[ht];
+    bool isUpward = m_valueCmpFunc(node.m_elem, newElem);
+    if (nullptr != pRemovedElem) {
+        /// *newElem* may refer to the old element itself or to *pRemovedElem*, so it is taken before the move out
+        T newValue(std::forward<U>(newElem));
+        *pRemovedElem = std::move(node.m_elem);
+        node.m_elem = std::move(newValue);
+    }
+    else {
+        node.m_elem = std::forward<U>(newElem);
+    }
+    if (isUpward) {
+        /// subtree stays heap ordered, so cutting and melding it with root is enough
+        if (ht != m_root) {
+            Cut(ht);
+            m_root = Meld(m_root, ht);
+        }
+    }
+    else {
+        /// children may be better now, so detach the node and insert it again as a single node
+        HANDLE_TYPE subRoot = MergePairs(node.m_child);
+        if (ht == m_root) {
+            m_root = subRoot;
+        }
+        else {
+            Cut(ht);
+            m_root = Meld(m_root, subRoot);
+        }
+        node.m_child = INVALID_HANDLE;
+        m_root = Meld(m_root, ht);
+    }
+    return ht;
+}
+
+template <class T, class CompareFunc, class Policy>
+typename IndexedPairingHeap<T, CompareFunc, Policy>::HANDLE_TYPE
+IndexedPairingHeap<T, CompareFunc, Policy>::MergePairs(HANDLE_TYPE first) {
+    if (first == INVALID_HANDLE) {
+        return INVALID_HANDLE;
+    }
+    /// first pass melds siblings pairwise from left to right
+    m_pairVec.clear();
+    while (first != INVALID_HANDLE) {
+        HANDLE_TYPE a = first;
+        HANDLE_TYPE b = m_nodeVec[a].m_sibling;
+        first = b == INVALID_HANDLE ? INVALID_HANDLE : m_nodeVec[b].m_sibling;
+        m_nodeVec[a].m_sibling = m_nodeVec[a].m_prev = INVALID_HANDLE;
+        if (b != INVALID_HANDLE) {
+            m_nodeVec[b].m_sibling = m_nodeVec[b].m_prev = INVALID_HANDLE;
+        }
+        m_pairVec.push_back(Meld(a, b));
+    }
+    /// second pass melds the pairs from right to left
+    HANDLE_TYPE root = m_pairVec.back();
+    for (size_t i = m_pairVec.size() - 1; i > 0; --i) {
+        root = Meld(m_pairVec[i - 1], root);
+    }
+    return root;
+}
+
+#endif //__INDEXEDPQ_INDEXED_PAIRING_HEAP_H__
@@ -0,0 +1,203 @@
+#include "indexedpq/indexed-pq-engine-unittest.h"
+#include "indexedpq/indexed-priority-queue-unittest.h"
+#include <cppunit/TestAssert.h>
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+CPPUNIT_TEST_SUITE_REGISTRATION(IndexedPQEngineTest);
+
+void IndexedPQEngineTest::SelectorTest() {
+    static_assert(std::is_same<IndexedPQEngineType<uint64_t>, IndexedPriorityQueue<uint64_t> >::value,
+                  "default engine should be d-ary heap");
+    typedef IndexedPQEnginePolicy<IndexedPQEngine::PAIRING_HEAP> PairingPolicy;
+    static_assert(std::is_same<IndexedPQEngineType<uint64_t, std::less<uint64_t>, PairingPolicy>,
+                               IndexedPairingHeap<uint64_t, std::less<uint64_t>, PairingPolicy> >::value,
+                  "pairing engine mismatch");
+    typedef IndexedPQEnginePolicy<IndexedPQEngine::RADIX_HEAP> RadixPolicy;
+    static_assert(std::is_same<IndexedPQEngineType<uint32_t, std::greater<uint32_t>, RadixPolicy>,
+                               IndexedRadixHeap<uint32_t, RadixPolicy> >::value,
+                  "radix engine mismatch");
+
+    /// same MaxTop order as IndexedPriorityQueue with std::less
+    IndexedPQEngineType<uint64_t, std::less<uint64_t>, PairingPolicy> pairingHeap;
+    CPPUNIT_ASSERT(pairingHeap.IsEmpty());
+    size_t ht5 = pairingHeap.Push(5);
+    size_t ht9 = pairingHeap.Push(9);
+    size_t ht1 = pairingHeap.Push(1);
+    CPPUNIT_ASSERT_EQUAL((size_t)3, pairingHeap.GetCount());
+    CPPUNIT_ASSERT_EQUAL(ht9, pairingHeap.Top());
+    CPPUNIT_ASSERT_EQUAL(ht1, pairingHeap.Update(ht1, 10));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)10, pairingHeap.TopElem());
+    uint64_t removed = 0;
+    CPPUNIT_ASSERT_EQUAL(ht1, pairingHeap.Update(ht1, 0, &removed));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)10, removed);
+    CPPUNIT_ASSERT_EQUAL(ht9, pairingHeap.Pop());
+    CPPUNIT_ASSERT(!pairingHeap.Contains(ht9));
+    CPPUNIT_ASSERT(pairingHeap.Update(ht9, 3) == pairingHeap.INVALID_HANDLE);
+    CPPUNIT_ASSERT(pairingHeap.Remove(ht5, &removed));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)5, removed);
+    CPPUNIT_ASSERT_EQUAL(ht1, pairingHeap.Pop());
+    CPPUNIT_ASSERT(pairingHeap.IsEmpty());
+
+    IndexedPQEngineType<uint32_t, std::greater<uint32_t>, RadixPolicy> radixHeap;
+    ht5 = radixHeap.Push(5);
+    ht9 = radixHeap.Push(9);
+    ht1 = radixHeap.Push(1);
+    CPPUNIT_ASSERT_EQUAL(ht1, radixHeap.Top());
+    CPPUNIT_ASSERT_EQUAL(ht1, radixHeap.Pop());
+    CPPUNIT_ASSERT_EQUAL((uint32_t)1, radixHeap.GetLowerBound());
+    CPPUNIT_ASSERT_EQUAL(ht9, radixHeap.Update(ht9, 2));
+    CPPUNIT_ASSERT_EQUAL((uint32_t)2, radixHeap.TopElem());
+    CPPUNIT_ASSERT(radixHeap.Remove(ht9));
+    CPPUNIT_ASSERT(!radixHeap.Remove(ht9));
+    CPPUNIT_ASSERT_EQUAL(ht5, radixHeap.Pop());
+    CPPUNIT_ASSERT(radixHeap.IsEmpty());
+
+    /// new element referring to the old one itself is kept while the old one is moved out
+    IndexedPQEngineType<string, std::less<string>, PairingPolicy> aliasHeap;
+    size_t ht = aliasHeap.Push(string("self"));
+    aliasHeap.Push(string("other"));
+    string old;
+    aliasHeap.Update(ht, aliasHeap.Elem(ht), &old);
+    CPPUNIT_ASSERT(old == "self");
+    CPPUNIT_ASSERT(aliasHeap.Elem(ht) == "self");
+    aliasHeap.Update(ht, old, &old);
+    CPPUNIT_ASSERT(old == "self");
+    CPPUNIT_ASSERT(aliasHeap.Elem(ht) == "self");
+}
+
+template<IndexedPQEngine Engine>
+void IndexedPQEngineTest::InternalRandomOpsTest(size_t opCount) {
+    /// MinTop with monotone keys, so that the same ops are valid for every engine
+    typedef typename IndexedPQEngineSelector<uint64_t, std::greater<uint64_t>, IndexedPQEnginePolicy<Engine> >::type ENGINE_TYPE;
+    ENGINE_TYPE pq;
+    map<size_t, uint64_t> htElems;
+    multiset<uint64_t> elems;
+    uint64_t last = 0;
+    for (size_t i = 0; i < opCount; ++i) {
+        int64_t op = RandomUtil<int64_t>::RandomInt64(0, 9);
+        if (op < 4 || htElems.empty()) {
+            uint64_t elem = last + RandomUtil<int64_t>::RandomInt64(0, 1000);
+            size_t ht = pq.Push(elem);
+            CPPUNIT_ASSERT(htElems.find(ht) == htElems.end());
+            htElems[ht] = elem;
+            elems.insert(elem);
+        }
+        else {
+            auto it = htElems.begin();
+            std::advance(it, RandomUtil<int64_t>::RandomInt64(0, htElems.size() - 1));
+            size_t ht = it->first;
+            if (op < 7) {
+                uint64_t elem = last + RandomUtil<int64_t>::RandomInt64(0, 1000);
+                uint64_t removed = 0;
+                CPPUNIT_ASSERT_EQUAL(ht, (size_t)pq.Update(ht, elem, &removed));
+                CPPUNIT_ASSERT_EQUAL(it->second, removed);
+                elems.erase(elems.find(it->second));
+                elems.insert(elem);
+                it->second = elem;
+            }
+            else if (op < 8) {
+                CPPUNIT_ASSERT(pq.Remove(ht));
+                CPPUNIT_ASSERT(!pq.Contains(ht));
+                elems.erase(elems.find(it->second));
+                htElems.erase(it);
+            }
+            else {
+                size_t topHt = pq.Pop();
+                last = pq.Elem(topHt);
+                CPPUNIT_ASSERT_EQUAL(*elems.begin(), last);
+                CPPUNIT_ASSERT_EQUAL(last, htElems[topHt]);
+                elems.erase(elems.begin());
+                htElems.erase(topHt);
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL(elems.size(), pq.GetCount());
+        if (!elems.empty()) {
+            CPPUNIT_ASSERT_EQUAL(*elems.begin(), pq.TopElem());
+            /// radix heap requires keys not smaller than the top once it is read
+            last = *elems.begin();
+        }
+    }
+}
+
+void IndexedPQEngineTest::RandomOpsTest() {
+    InternalRandomOpsTest<IndexedPQEngine::DARY_HEAP>(20000);
+    InternalRandomOpsTest<IndexedPQEngine::PAIRING_HEAP>(20000);
+    InternalRandomOpsTest<IndexedPQEngine::RADIX_HEAP>(20000);
+}
+
+template<IndexedPQEngine Engine>
+uint64_t IndexedPQEngineTest::InternalDijkstra(const Graph& graph, size_t source, std::vector<uint64_t>& dists) {
+    typedef typename IndexedPQEngineSelector<uint64_t, std::greater<uint64_t>, IndexedPQEnginePolicy<Engine> >::type ENGINE_TYPE;
+    static constexpr size_t NOT_SEEN = std::numeric_limits<size_t>::max();
+    static constexpr size_t DONE = NOT_SEEN - 1;
+    size_t nodeCount = graph.m_offsets.size() - 1;
+    ENGINE_TYPE pq(nodeCount);
+    vector<size_t> nodeHts(nodeCount, NOT_SEEN);    /// handle of node in queue, or its status
+    vector<size_t> htNodes;                         /// node of handle
+    dists.assign(nodeCount, std::numeric_limits<uint64_t>::max());
+    uint64_t updateCnt = 0;
+
+    dists[source] = 0;
+    nodeHts[source] = pq.Push(0);
+    htNodes.resize(nodeHts[source] + 1);
+    htNodes[nodeHts[source]] = source;
+    while (!pq.IsEmpty()) {
+        size_t node = htNodes[pq.Pop()];
+        nodeHts[node] = DONE;
+        for (size_t e = graph.m_offsets[node]; e < graph.m_offsets[node + 1]; ++e) {
+            size_t target = graph.m_targets[e];
+            uint64_t dist = dists[node] + graph.m_weights[e];
+            if (nodeHts[target] == DONE || dist >= dists[target]) {
+                continue;
+            }
+            dists[target] = dist;
+            if (nodeHts[target] == NOT_SEEN) {
+                size_t ht = pq.Push(dist);
+                if (ht >= htNodes.size()) { htNodes.resize(ht + 1); }
+                htNodes[ht] = target;
+                nodeHts[target] = ht;
+            }
+            else {
+                pq.Update(nodeHts[target], dist);
+                ++updateCnt;
+            }
+        }
+    }
+    return updateCnt;
+}
+
+void IndexedPQEngineTest::DijkstraPerformanceTest() {
+    size_t nodeCount = 200000, degree = 8;
+    Graph graph;
+    graph.m_offsets.push_back(0);
+    for (size_t i = 0; i < nodeCount; ++i) {
+        for (size_t j = 0; j < degree; ++j) {
+            graph.m_targets.push_back(RandomUtil<int64_t>::RandomInt64(0, nodeCount - 1));
+            graph.m_weights.push_back(RandomUtil<int64_t>::RandomInt64(1, 100000));
+        }
+        graph.m_offsets.push_back(graph.m_targets.size());
+    }
+
+    vector<uint64_t> daryDists, pairingDists, radixDists;
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    uint64_t updateCnt = InternalDijkstra<IndexedPQEngine::DARY_HEAP>(graph, 0, daryDists);
+    int64_t tDary = TimeUtil::CurrentTimeInMicroSeconds();
+    InternalDijkstra<IndexedPQEngine::PAIRING_HEAP>(graph, 0, pairingDists);
+    int64_t tPairing = TimeUtil::CurrentTimeInMicroSeconds();
+    InternalDijkstra<IndexedPQEngine::RADIX_HEAP>(graph, 0, radixDists);
+    int64_t tRadix = TimeUtil::CurrentTimeInMicroSeconds();
+    CPPUNIT_ASSERT(daryDists == pairingDists);
+    CPPUNIT_ASSERT(daryDists == radixDists);
+
+    cout << endl << "-------------Dijkstra of [" << nodeCount << "] nodes and [" << graph.m_targets.size() << "] edges, ["
+         << updateCnt << "] decrease-keys:" << endl;
+    cout << "-------------d-ary heap cost[" << (tDary - tBegin) / 1000.0 << "]ms." << endl;
+    cout << "-------------pairing heap cost[" << (tPairing - tDary) / 1000.0 << "]ms." << endl;
+    cout << "-------------radix heap cost[" << (tRadix - tPairing) / 1000.0 << "]ms." << endl;
+}
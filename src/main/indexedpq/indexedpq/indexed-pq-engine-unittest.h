@@ -0,0 +1,41 @@
+#ifndef __INDEXEDPQ_TEST_INDEXED_PQ_ENGINE_UNITTEST_H__
+#define __INDEXEDPQ_TEST_INDEXED_PQ_ENGINE_UNITTEST_H__
+
+#include "indexedpq/indexed-pq-engine.h"
+#include <cppunit/extensions/HelperMacros.h>
+#include <vector>
+
+class IndexedPQEngineTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(IndexedPQEngineTest);
+    CPPUNIT_TEST(SelectorTest);
+    CPPUNIT_TEST(RandomOpsTest);
+    CPPUNIT_TEST(DijkstraPerformanceTest);
+    CPPUNIT_TEST_SUITE_END();
+public:
+    IndexedPQEngineTest() {}
+    ~IndexedPQEngineTest() {}
+    void setUp() {}
+    void tearDown() {}
+public:
+
+    void SelectorTest();
+    void RandomOpsTest();
+    void DijkstraPerformanceTest();
+
+public:
+    /// directed graph in compressed sparse rows
+    struct Graph {
+        std::vector<size_t>     m_offsets;
+        std::vector<size_t>     m_targets;
+        std::vector<uint64_t>   m_weights;
+    };
+
+private:
+    template<IndexedPQEngine Engine>
+    void InternalRandomOpsTest(size_t opCount);
+    template<IndexedPQEngine Engine>
+    uint64_t InternalDijkstra(const Graph& graph, size_t source, std::vector<uint64_t>& dists);
+};
+
+
+#endif //__INDEXEDPQ_TEST_INDEXED_PQ_ENGINE_UNITTEST_H__
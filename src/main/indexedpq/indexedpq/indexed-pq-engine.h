@@ -0,0 +1,37 @@
+#ifndef __INDEXEDPQ_INDEXED_PQ_ENGINE_H__
+#define __INDEXEDPQ_INDEXED_PQ_ENGINE_H__
+
+#include "indexedpq/indexed-priority-queue.h"
+#include "indexedpq/indexed-pairing-heap.h"
+#include "indexedpq/indexed-radix-heap.h"
+#include <functional>
+#include <type_traits>
+
+/**
+ *@brief     select the engine of *Policy::ENGINE*. All engines share the handle API
+ *           Push/Pop/Top/TopElem/Elem/Update/Remove/Contains/GetCount/IsEmpty/Reset, so code written against it switches
+ *           engine by policy only, e.g.
+ *               IndexedPQEngineSelector<uint64_t, std::greater<uint64_t>, IndexedPQEnginePolicy<IndexedPQEngine::RADIX_HEAP> >::type
+ *           Radix heap only supports unsigned integer keys in MinTop order, i.e. std::greater.
+ */
+template <class T, class CompareFunc = std::less<T>, class Policy = IndexedPQDefaultPolicy,
+          IndexedPQEngine Engine = Policy::ENGINE>
+struct IndexedPQEngineSelector {
+    typedef IndexedPriorityQueue<T, CompareFunc, Policy> type;
+};
+
+template <class T, class CompareFunc, class Policy>
+struct IndexedPQEngineSelector<T, CompareFunc, Policy, IndexedPQEngine::PAIRING_HEAP> {
+    typedef IndexedPairingHeap<T, CompareFunc, Policy> type;
+};
+
+template <class T, class CompareFunc, class Policy>
+struct IndexedPQEngineSelector<T, CompareFunc, Policy, IndexedPQEngine::RADIX_HEAP> {
+    static_assert(std::is_same<CompareFunc, std::greater<T> >::value, "radix heap engine is MinTop, use std::greater");
+    typedef IndexedRadixHeap<T, Policy> type;
+};
+
+template <class T, class CompareFunc = std::less<T>, class Policy = IndexedPQDefaultPolicy>
+using IndexedPQEngineType = typename IndexedPQEngineSelector<T, CompareFunc, Policy>::type;
+
+#endif //__INDEXEDPQ_INDEXED_PQ_ENGINE_H__
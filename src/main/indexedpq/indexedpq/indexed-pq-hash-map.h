@@ -0,0 +1,160 @@
+#ifndef __INDEXEDPQ_INDEXED_PQ_HASH_MAP_H__
+#define __INDEXEDPQ_INDEXED_PQ_HASH_MAP_H__
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+/**
+ *@brief     bounded open-addressing hash map with linear probing, used as the side index from a key to an
+ *           IndexedPriorityQueue handle. All memory is allocated in constructor, the table keeps load factor not
+ *           larger than 0.5 for *nMaxSize* keys. Erase uses backward shift deletion, so there is no tombstone and
+ *           probe sequences stay short in long running replacement workloads.
+ */
+template <class K, class V, class Hash = std::hash<K>, class KeyEqual = std::equal_to<K> >
+class IndexedPQHashMap
+{
+public:
+    typedef K             KEY_TYPE;
+    typedef V             MAPPED_TYPE;
+
+public:
+    IndexedPQHashMap(size_t nMaxSize = 32, Hash hashFunc = Hash(), KeyEqual keyEqualFunc = KeyEqual());
+    ~IndexedPQHashMap();
+    IndexedPQHashMap(const IndexedPQHashMap&) = delete;
+    IndexedPQHashMap& operator=(const IndexedPQHashMap&) = delete;
+
+    inline size_t GetCount() { return m_elemCnt; }
+    inline size_t GetMaxCount() { return m_maxSize; }
+    inline bool   IsEmpty() { return m_elemCnt == 0; }
+
+    /// return pointer to value of *key*, nullptr if not exists
+    V* Find(const K& key) {
+        size_t pos = HomeSlot(key);
+        while (m_usedArr[pos]) {
+            if (m_keyEqualFunc(m_keyArr[pos], key)) {
+                return &m_valueArr[pos];
+            }
+            pos = (pos + 1) & m_mask;
+        }
+        return nullptr;
+    }
+
+    /// insert *key* with *value* if not exists, return pointer to value of *key*
+    V* Insert(const K& key, const V& value) {
+        size_t pos = HomeSlot(key);
+        while (m_usedArr[pos]) {
+            if (m_keyEqualFunc(m_keyArr[pos], key)) {
+                return &m_valueArr[pos];
+            }
+            pos = (pos + 1) & m_mask;
+        }
+        assert(m_elemCnt < m_maxSize);
+        m_usedArr[pos] = 1;
+        m_keyArr[pos] = key;
+        m_valueArr[pos] = value;
+        ++m_elemCnt;
+        return &m_valueArr[pos];
+    }
+
+    /// erase *key*, return false if not exists
+    bool Erase(const K& key);
+
+    /// remove all keys
+    void Clear() {
+        if (m_elemCnt > 0) {
+            memset(m_usedArr, 0, m_capacity);
+            m_elemCnt = 0;
+        }
+    }
+
+    /// iterate all key-value pairs unordered, *func(key, value)*
+    template<class Func>
+    void ForEach(Func func) {
+        for (size_t i = 0; i < m_capacity; ++i) {
+            if (m_usedArr[i]) { func(m_keyArr[i], m_valueArr[i]); }
+        }
+    }
+
+private:
+    size_t HomeSlot(const K& key) {
+        /// fibonacci hashing spreads identity hash of integers over the power of 2 table
+        return (size_t)(((uint64_t)m_hashFunc(key) * 0x9E3779B97F4A7C15ULL) >> m_shift);
+    }
+
+private:
+    K*                    m_keyArr;                 /// keys of slots
+    V*                    m_valueArr;               /// values of slots
+    uint8_t*              m_usedArr;                /// whether slot is used
+    size_t                m_capacity;               /// slots count, power of 2
+    size_t                m_mask;                   /// m_capacity - 1
+    size_t                m_shift;                  /// 64 - log2(m_capacity)
+    size_t                m_maxSize;                /// max keys count
+    size_t                m_elemCnt;                /// keys count
+
+    Hash                  m_hashFunc;
+    KeyEqual              m_keyEqualFunc;
+};
+
+template <class K, class V, class Hash, class KeyEqual>
+IndexedPQHashMap<K, V, Hash, KeyEqual>::IndexedPQHashMap(size_t nMaxSize     /* = 32 */,
+                                                         Hash hashFunc       /* = Hash() */,
+                                                         KeyEqual keyEqualFunc /* = KeyEqual() */) {
+    nMaxSize = std::max<size_t>(nMaxSize, 1);
+    m_capacity = 2;
+    m_shift = 63;
+    while (m_capacity < nMaxSize * 2) {
+        m_capacity *= 2;
+        --m_shift;
+    }
+    m_mask = m_capacity - 1;
+    m_maxSize = nMaxSize;
+    m_elemCnt = 0;
+    m_keyArr = new K[m_capacity];
+    m_valueArr = new V[m_capacity];
+    m_usedArr = new uint8_t[m_capacity];
+    memset(m_usedArr, 0, m_capacity);
+    m_hashFunc = hashFunc;
+    m_keyEqualFunc = keyEqualFunc;
+}
+
+template <class K, class V, class Hash, class KeyEqual>
+IndexedPQHashMap<K, V, Hash, KeyEqual>::~IndexedPQHashMap() {
+    if (nullptr != m_keyArr) { delete [] m_keyArr; m_keyArr = nullptr; }
+    if (nullptr != m_valueArr) { delete [] m_valueArr; m_valueArr = nullptr; }
+    if (nullptr != m_usedArr) { delete [] m_usedArr; m_usedArr = nullptr; }
+    m_elemCnt = 0;
+}
+
+template <class K, class V, class Hash, class KeyEqual>
+bool IndexedPQHashMap<K, V, Hash, KeyEqual>::Erase(const K& key) {
+    size_t pos = HomeSlot(key);
+    while (true) {
+        if (!m_usedArr[pos]) {
+            return false;
+        }
+        if (m_keyEqualFunc(m_keyArr[pos], key)) {
+            break;
+        }
+        pos = (pos + 1) & m_mask;
+    }
+    /// shift following keys of the cluster backward, if their home slots are not in (hole, current]
+    size_t hole = pos;
+    size_t next = (pos + 1) & m_mask;
+    while (m_usedArr[next]) {
+        size_t home = HomeSlot(m_keyArr[next]);
+        if (((next - home) & m_mask) >= ((next - hole) & m_mask)) {
+            m_keyArr[hole] = m_keyArr[next];
+            m_valueArr[hole] = m_valueArr[next];
+            hole = next;
+        }
+        next = (next + 1) & m_mask;
+    }
+    m_usedArr[hole] = 0;
+    --m_elemCnt;
+    return true;
+}
+
+#endif //__INDEXEDPQ_INDEXED_PQ_HASH_MAP_H__
@@ -0,0 +1,128 @@
+#ifndef __INDEXEDPQ_INDEXED_PQ_MEMORY_H__
+#define __INDEXEDPQ_INDEXED_PQ_MEMORY_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+/**
+ *@brief     aligned array storage on top of any byte allocator, e.g. std::allocator<char> or
+ *           std::pmr::polymorphic_allocator<char> of a per-request monotonic arena. Allocators only promise alignment
+ *           of their value type, so every block is over-allocated by its alignment and a header ahead of the aligned
+ *           address keeps the raw pointer and size needed to deallocate it.
+ *           Blocks not smaller than *hugePageThreshold* are aligned to huge page and advised to be backed by
+ *           transparent huge pages, which cuts TLB misses of sifting in big heaps.
+ *           Arrays may also live in an adopted file mapping, see *AdoptMapping*.
+ */
+template <class Allocator>
+class IndexedPQMemory
+{
+public:
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<char>  BYTE_ALLOCATOR_TYPE;
+
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+public:
+    IndexedPQMemory(const Allocator& allocator, size_t hugePageThreshold)
+        : m_allocator(allocator), m_hugePageThreshold(hugePageThreshold), m_pMapping(nullptr), m_mappingBytes(0) {}
+    ~IndexedPQMemory() { ReleaseMapping(); }
+    IndexedPQMemory(const IndexedPQMemory&) = delete;
+    IndexedPQMemory& operator=(const IndexedPQMemory&) = delete;
+
+    inline const BYTE_ALLOCATOR_TYPE& GetAllocator() const { return m_allocator; }
+
+    /// allocate *bytes* aligned to *align*, which must be a power of 2
+    void* Allocate(size_t bytes, size_t align) {
+        bool isHugePage = bytes >= m_hugePageThreshold;
+        if (isHugePage) {
+            align = HUGE_PAGE_SIZE;
+        }
+        align = align < sizeof(Header) ? sizeof(Header) : align;
+        size_t rawBytes = bytes + align + sizeof(Header);
+        char* pRaw = std::allocator_traits<BYTE_ALLOCATOR_TYPE>::allocate(m_allocator, rawBytes);
+        uintptr_t aligned = ((uintptr_t)pRaw + sizeof(Header) + align - 1) & ~(uintptr_t)(align - 1);
+        Header* pHeader = (Header*)aligned - 1;
+        pHeader->m_pRaw = pRaw;
+        pHeader->m_rawBytes = rawBytes;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if (isHugePage) {
+            madvise((void*)aligned, bytes & ~(HUGE_PAGE_SIZE - 1), MADV_HUGEPAGE);
+        }
+#endif
+        return (void*)aligned;
+    }
+
+    /// deallocate block returned by *Allocate*, blocks inside the adopted mapping are left to *ReleaseMapping*
+    void Deallocate(void* p) {
+        if (nullptr == p || IsMapped(p)) {
+            return;
+        }
+        Header* pHeader = (Header*)p - 1;
+        std::allocator_traits<BYTE_ALLOCATOR_TYPE>::deallocate(m_allocator, pHeader->m_pRaw, pHeader->m_rawBytes);
+    }
+
+    /// allocate array of *arraySz* default initialized *Type*, with *padding* slots ahead of the returned pointer.
+    template<class Type>
+    Type* AllocArray(size_t arraySz, size_t align = alignof(Type), size_t padding = 0) {
+        Type* pArray = static_cast<Type*>(Allocate((arraySz + padding) * sizeof(Type), align));
+        for (size_t i = 0; i < arraySz + padding; ++i) {
+            ::new ((void*)(pArray + i)) Type;
+        }
+        return pArray + padding;
+    }
+    /// destroy and deallocate array returned by *AllocArray* with the same *arraySz* and *padding*
+    template<class Type>
+    void FreeArray(Type* pArray, size_t arraySz, size_t padding = 0) {
+        if (nullptr == pArray) {
+            return;
+        }
+        pArray -= padding;
+        for (size_t i = 0; i < arraySz + padding; ++i) {
+            pArray[i].~Type();
+        }
+        Deallocate(pArray);
+    }
+
+    /**
+     *@brief     take ownership of file mapping [p, p+bytes), whose arrays are used in place. *Deallocate* skips them,
+     *           and the mapping is unmapped by *ReleaseMapping* or destructor. A previous mapping is released first,
+     *           so arrays inside it must have been freed.
+     */
+    void AdoptMapping(void* p, size_t bytes) {
+        ReleaseMapping();
+        m_pMapping = (char*)p;
+        m_mappingBytes = bytes;
+    }
+    /// unmap the adopted mapping if any
+    void ReleaseMapping() {
+#if defined(__linux__)
+        if (nullptr != m_pMapping) {
+            munmap(m_pMapping, m_mappingBytes);
+        }
+#endif
+        m_pMapping = nullptr;
+        m_mappingBytes = 0;
+    }
+    /// whether *p* points into the adopted mapping
+    inline bool IsMapped(const void* p) const {
+        return (const char*)p >= m_pMapping && (const char*)p < m_pMapping + m_mappingBytes;
+    }
+
+private:
+    /// kept just ahead of aligned address, 16 bytes so that it does not break 16 bytes alignment
+    struct alignas(16) Header {
+        char*   m_pRaw;
+        size_t  m_rawBytes;
+    };
+
+    BYTE_ALLOCATOR_TYPE   m_allocator;
+    size_t                m_hugePageThreshold;
+    char*                 m_pMapping;               /// adopted file mapping, null if none
+    size_t                m_mappingBytes;
+};
+
+#endif //__INDEXEDPQ_INDEXED_PQ_MEMORY_H__
@@ -0,0 +1,122 @@
+#include "indexedpq/indexed-pq-simd-unittest.h"
+#include "indexedpq/indexed-priority-queue-unittest.h"
+#include <cppunit/TestAssert.h>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+using namespace std;
+CPPUNIT_TEST_SUITE_REGISTRATION(IndexedPQSimdTest);
+
+template<size_t Arity, bool Simd>
+struct SimdPolicy : public IndexedPQArityPolicy<Arity> {
+    static constexpr bool INLINE_ELEM = true;
+    static constexpr bool SIMD_CHILD_SELECT = Simd;
+};
+
+template<class T, size_t N>
+void IndexedPQSimdTest::InternalSelectBestTest(size_t runTimes) {
+    CPPUNIT_ASSERT((IndexedPQSimd::IsSupported<T, N>()));
+    alignas(64) T arr[N];
+    for (size_t times = 0; times < runTimes; ++times) {
+        /// small value range makes many ties, which must be resolved to the first one
+        int64_t maxValue = times % 2 ? 4 : 1e9;
+        for (size_t i = 0; i < N; ++i) {
+            arr[i] = (T)RandomUtil<int64_t>::RandomInt64(0, maxValue);
+        }
+        if (times % 3 == 0) {
+            arr[RandomUtil<int64_t>::RandomInt64(0, N - 1)] = std::numeric_limits<T>::max();
+        }
+        CPPUNIT_ASSERT_EQUAL((IndexedPQSimd::SelectScalar<T, N>(arr, true)), (IndexedPQSimd::SelectBest<T, N>(arr, true)));
+        CPPUNIT_ASSERT_EQUAL((IndexedPQSimd::SelectScalar<T, N>(arr, false)), (IndexedPQSimd::SelectBest<T, N>(arr, false)));
+    }
+}
+
+void IndexedPQSimdTest::SelectBestTest() {
+    cout << "avx2 supported:" << IndexedPQSimd::HasAvx2() << endl;
+    InternalSelectBestTest<uint32_t, 4>(2000);
+    InternalSelectBestTest<uint32_t, 8>(2000);
+    InternalSelectBestTest<uint32_t, 16>(2000);
+    InternalSelectBestTest<uint64_t, 2>(2000);
+    InternalSelectBestTest<uint64_t, 4>(2000);
+    InternalSelectBestTest<uint64_t, 8>(2000);
+    InternalSelectBestTest<uint64_t, 16>(2000);
+    InternalSelectBestTest<float, 4>(2000);
+    InternalSelectBestTest<float, 8>(2000);
+    InternalSelectBestTest<float, 16>(2000);
+    InternalSelectBestTest<double, 4>(2000);
+    InternalSelectBestTest<double, 8>(2000);
+    InternalSelectBestTest<double, 16>(2000);
+    CPPUNIT_ASSERT(!(IndexedPQSimd::IsSupported<uint32_t, 2>()));
+    CPPUNIT_ASSERT(!(IndexedPQSimd::IsSupported<uint16_t, 8>()));
+
+    /// unsigned 64 bits values must not be compared as signed
+    alignas(64) uint64_t arr[4] = {1, 0x8000000000000000ULL, 3, 0x7FFFFFFFFFFFFFFFULL};
+    CPPUNIT_ASSERT_EQUAL((size_t)1, (IndexedPQSimd::SelectBest<uint64_t, 4>(arr, true)));
+    CPPUNIT_ASSERT_EQUAL((size_t)0, (IndexedPQSimd::SelectBest<uint64_t, 4>(arr, false)));
+}
+
+template<class T, class CompareFunc, size_t Arity>
+void IndexedPQSimdTest::InternalSimdQueueTest(size_t count, CompareFunc compareFunc) {
+    typedef IndexedPriorityQueue<T, CompareFunc, SimdPolicy<Arity, true> > Queue;
+    CPPUNIT_ASSERT(Queue::SIMD_CHILD_SELECT);
+    Queue pq(16, 16, false, compareFunc);
+    vector<T> arr;
+    vector<typename Queue::HANDLE_TYPE> hts;
+    for (size_t i = 0; i < count; ++i) {
+        T value = (T)RandomUtil<int64_t>::RandomInt64(0, 1e4);
+        hts.push_back(pq.Push(value));
+        arr.push_back(value);
+    }
+    CPPUNIT_ASSERT(pq.IsHeap());
+    for (size_t i = 0; i < count; ++i) {
+        size_t j = RandomUtil<int64_t>::RandomInt64(0, count - 1);
+        T value = (T)RandomUtil<int64_t>::RandomInt64(0, 1e4);
+        pq.Update(hts[j], value);
+        arr[j] = value;
+    }
+    CPPUNIT_ASSERT(pq.IsHeap());
+    sort(arr.begin(), arr.end(), compareFunc);
+    for (typename vector<T>::reverse_iterator rit = arr.rbegin(); rit != arr.rend(); ++rit) {
+        CPPUNIT_ASSERT_EQUAL(*rit, pq.TopElem());
+        pq.Pop();
+    }
+    CPPUNIT_ASSERT(pq.IsEmpty());
+}
+
+void IndexedPQSimdTest::SimdQueueTest() {
+    InternalSimdQueueTest<uint32_t, less<uint32_t>, 4>(5000, less<uint32_t>());
+    InternalSimdQueueTest<uint32_t, greater<uint32_t>, 8>(5000, greater<uint32_t>());
+    InternalSimdQueueTest<uint64_t, less<uint64_t>, 4>(5000, less<uint64_t>());
+    InternalSimdQueueTest<uint64_t, IndexedPQComparator<uint64_t>, 8>(5000, IndexedPQComparator<uint64_t>(false));
+    InternalSimdQueueTest<float, IndexedPQComparator<float>, 4>(5000, IndexedPQComparator<float>(true));
+    InternalSimdQueueTest<float, greater<float>, 16>(5000, greater<float>());
+    InternalSimdQueueTest<double, less<double>, 8>(5000, less<double>());
+    InternalSimdQueueTest<double, greater<double>, 2>(5000, greater<double>());
+}
+
+template<class Policy>
+void IndexedPQSimdTest::InternalSimdPerformanceTest(size_t count) {
+    typedef IndexedPriorityQueue<uint64_t, std::less<uint64_t>, Policy > Queue;
+    Queue pq(count);
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    for (size_t i = 0; i < count; ++i) {
+        pq.Push(RandomUtil<int64_t>::RandomInt64(0, 1e12));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        pq.ReplaceTopElem(RandomUtil<int64_t>::RandomInt64(0, 1e12));
+    }
+    while (!pq.IsEmpty()) {
+        pq.Pop();
+    }
+    int64_t tEnd = TimeUtil::CurrentTimeInMicroSeconds();
+    cout << "-------------arity:[" << Queue::ARITY << "],simd:[" << Queue::SIMD_CHILD_SELECT << "],count:[" << count
+         << "],Totally consumed time:[" << (tEnd - tBegin) << "]us." << endl;
+}
+
+void IndexedPQSimdTest::SimdPerformanceTest() {
+    InternalSimdPerformanceTest<SimdPolicy<4, false> >(1e5);
+    InternalSimdPerformanceTest<SimdPolicy<4, true> >(1e5);
+    InternalSimdPerformanceTest<SimdPolicy<8, false> >(1e5);
+    InternalSimdPerformanceTest<SimdPolicy<8, true> >(1e5);
+}
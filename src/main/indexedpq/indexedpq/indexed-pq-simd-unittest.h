@@ -0,0 +1,34 @@
+#ifndef __INDEXEDPQ_TEST_INDEXED_PQ_SIMD_UNITTEST_H__
+#define __INDEXEDPQ_TEST_INDEXED_PQ_SIMD_UNITTEST_H__
+
+#include "indexedpq/indexed-priority-queue.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+class IndexedPQSimdTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(IndexedPQSimdTest);
+    CPPUNIT_TEST(SelectBestTest);
+    CPPUNIT_TEST(SimdQueueTest);
+    CPPUNIT_TEST(SimdPerformanceTest);
+    CPPUNIT_TEST_SUITE_END();
+public:
+    IndexedPQSimdTest() {}
+    ~IndexedPQSimdTest() {}
+    void setUp() {}
+    void tearDown() {}
+public:
+
+    void SelectBestTest();
+    void SimdQueueTest();
+    void SimdPerformanceTest();
+
+private:
+    template<class T, size_t N>
+    void InternalSelectBestTest(size_t runTimes);
+    template<class T, class CompareFunc, size_t Arity>
+    void InternalSimdQueueTest(size_t count, CompareFunc compareFunc);
+    template<class Policy>
+    void InternalSimdPerformanceTest(size_t count);
+};
+
+
+#endif //__INDEXEDPQ_TEST_INDEXED_PQ_SIMD_UNITTEST_H__
@@ -0,0 +1,280 @@
+#ifndef __INDEXEDPQ_INDEXED_PQ_SIMD_H__
+#define __INDEXEDPQ_INDEXED_PQ_SIMD_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+#if defined(__x86_64__) && defined(__SSE4_2__) && (defined(__GNUC__) || defined(__clang__))
+#define INDEXEDPQ_SIMD_X86 1
+#include <immintrin.h>
+#define INDEXEDPQ_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+template<class T> class IndexedPQComparator;
+
+/**
+ *@brief     traits to know heap direction of a comparator, so that the best child can be found by a plain max or min
+ *           reduction. IS_KNOWN is false for comparators whose direction can not be decided, which always use the
+ *           scalar compare loop.
+ */
+template<class T, class CompareFunc>
+struct IndexedPQCompareTraits {
+    static constexpr bool IS_KNOWN = false;
+    static bool IsMaxHeap(const CompareFunc& ) { return true; }
+};
+
+template<class T>
+struct IndexedPQCompareTraits<T, std::less<T> > {
+    static constexpr bool IS_KNOWN = true;
+    static bool IsMaxHeap(const std::less<T>& ) { return true; }
+};
+
+template<class T>
+struct IndexedPQCompareTraits<T, std::greater<T> > {
+    static constexpr bool IS_KNOWN = true;
+    static bool IsMaxHeap(const std::greater<T>& ) { return false; }
+};
+
+template<class T>
+struct IndexedPQCompareTraits<T, IndexedPQComparator<T> > {
+    static constexpr bool IS_KNOWN = true;
+    static bool IsMaxHeap(const IndexedPQComparator<T>& cmp) { return cmp.IsMaxHeap(); }
+};
+
+
+/**
+ *@brief     vectorized kernels to select the best one of a full children group in wide-arity heap. SSE4.2 kernels are
+ *           used when the build enables it, AVX2 kernels are chosen at runtime if cpu supports, otherwise it falls
+ *           back to scalar loop. Ties are resolved to the first best element, same as the scalar sift loop.
+ */
+class IndexedPQSimd {
+public:
+    /// whether elements of type *T* in groups of *N* can be selected by vector kernels
+    template<class T, size_t N>
+    static constexpr bool IsSupported() {
+#ifdef INDEXEDPQ_SIMD_X86
+        return (std::is_same<T, uint32_t>::value || std::is_same<T, uint64_t>::value ||
+                std::is_same<T, float>::value || std::is_same<T, double>::value)
+               && N * sizeof(T) >= 16 && (N * sizeof(T)) % 16 == 0;
+#else
+        return false;
+#endif
+    }
+
+    /// whether AVX2 kernels are available on current cpu, decided once.
+    static bool HasAvx2() {
+#ifdef INDEXEDPQ_SIMD_X86
+        static const bool s_hasAvx2 = __builtin_cpu_supports("avx2");
+        return s_hasAvx2;
+#else
+        return false;
+#endif
+    }
+
+    /// return offset of the max(isMax is true) or min element within *p[0,N)*
+    template<class T, size_t N>
+    static size_t SelectBest(const T* p, bool isMax) {
+#ifdef INDEXEDPQ_SIMD_X86
+        if constexpr (IsSupported<T, N>()) {
+            if constexpr (N * sizeof(T) % 32 == 0) {
+                if (HasAvx2()) {
+                    return isMax ? SelectAvx2<T, N, true>(p) : SelectAvx2<T, N, false>(p);
+                }
+            }
+            return isMax ? SelectSse<T, N, true>(p) : SelectSse<T, N, false>(p);
+        }
+#endif
+        return SelectScalar<T, N>(p, isMax);
+    }
+
+    template<class T, size_t N>
+    static size_t SelectScalar(const T* p, bool isMax) {
+        size_t best = 0;
+        for (size_t i = 1; i < N; ++i) {
+            if (isMax ? (p[best] < p[i]) : (p[i] < p[best])) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+#ifdef INDEXEDPQ_SIMD_X86
+private:
+    /// 128 bits operations, *Spread* makes every lane hold the max or min of all lanes, *EqMask* has one bit per lane.
+    template<class T> struct SseOps;
+
+    /// 256 bits operations, same as *SseOps*
+    template<class T> struct Avx2Ops;
+
+    template<class T, size_t N, bool IsMax>
+    static size_t SelectSse(const T* p) {
+        typedef SseOps<T> Ops;
+        constexpr size_t LANES = 16 / sizeof(T);
+        typename Ops::V v = Ops::Load(p);
+        for (size_t i = LANES; i < N; i += LANES) {
+            v = IsMax ? Ops::Max(v, Ops::Load(p + i)) : Ops::Min(v, Ops::Load(p + i));
+        }
+        v = IsMax ? Ops::SpreadMax(v) : Ops::SpreadMin(v);
+        for (size_t i = 0; i + LANES < N; i += LANES) {
+            int mask = Ops::EqMask(Ops::Load(p + i), v);
+            if (mask) { return i + __builtin_ctz(mask); }
+        }
+        return N - LANES + __builtin_ctz(Ops::EqMask(Ops::Load(p + N - LANES), v));
+    }
+
+    template<class T, size_t N, bool IsMax>
+    INDEXEDPQ_AVX2_TARGET static size_t SelectAvx2(const T* p) {
+        typedef Avx2Ops<T> Ops;
+        constexpr size_t LANES = 32 / sizeof(T);
+        typename Ops::V v = Ops::Load(p);
+        for (size_t i = LANES; i < N; i += LANES) {
+            v = IsMax ? Ops::Max(v, Ops::Load(p + i)) : Ops::Min(v, Ops::Load(p + i));
+        }
+        v = IsMax ? Ops::SpreadMax(v) : Ops::SpreadMin(v);
+        for (size_t i = 0; i + LANES < N; i += LANES) {
+            int mask = Ops::EqMask(Ops::Load(p + i), v);
+            if (mask) { return i + __builtin_ctz(mask); }
+        }
+        return N - LANES + __builtin_ctz(Ops::EqMask(Ops::Load(p + N - LANES), v));
+    }
+#endif
+};
+
+#ifdef INDEXEDPQ_SIMD_X86
+template<> struct IndexedPQSimd::SseOps<uint32_t> {
+    typedef __m128i V;
+    static V Load(const uint32_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+    static V Max(V a, V b) { return _mm_max_epu32(a, b); }
+    static V Min(V a, V b) { return _mm_min_epu32(a, b); }
+    static V SpreadMax(V v) {
+        v = Max(v, _mm_shuffle_epi32(v, 0x4E));
+        return Max(v, _mm_shuffle_epi32(v, 0xB1));
+    }
+    static V SpreadMin(V v) {
+        v = Min(v, _mm_shuffle_epi32(v, 0x4E));
+        return Min(v, _mm_shuffle_epi32(v, 0xB1));
+    }
+    static int EqMask(V a, V b) { return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b))); }
+};
+
+template<> struct IndexedPQSimd::SseOps<uint64_t> {
+    typedef __m128i V;
+    static V Load(const uint64_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+    /// there is no unsigned 64 bits compare, flip the sign bits and compare signed.
+    static V Greater(V a, V b) {
+        const V sign = _mm_set1_epi64x((long long)0x8000000000000000ULL);
+        return _mm_cmpgt_epi64(_mm_xor_si128(a, sign), _mm_xor_si128(b, sign));
+    }
+    static V Max(V a, V b) { return _mm_blendv_epi8(a, b, Greater(b, a)); }
+    static V Min(V a, V b) { return _mm_blendv_epi8(a, b, Greater(a, b)); }
+    static V SpreadMax(V v) { return Max(v, _mm_shuffle_epi32(v, 0x4E)); }
+    static V SpreadMin(V v) { return Min(v, _mm_shuffle_epi32(v, 0x4E)); }
+    static int EqMask(V a, V b) { return _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(a, b))); }
+};
+
+template<> struct IndexedPQSimd::SseOps<float> {
+    typedef __m128 V;
+    static V Load(const float* p) { return _mm_loadu_ps(p); }
+    static V Max(V a, V b) { return _mm_max_ps(a, b); }
+    static V Min(V a, V b) { return _mm_min_ps(a, b); }
+    static V SpreadMax(V v) {
+        v = Max(v, _mm_shuffle_ps(v, v, 0x4E));
+        return Max(v, _mm_shuffle_ps(v, v, 0xB1));
+    }
+    static V SpreadMin(V v) {
+        v = Min(v, _mm_shuffle_ps(v, v, 0x4E));
+        return Min(v, _mm_shuffle_ps(v, v, 0xB1));
+    }
+    static int EqMask(V a, V b) { return _mm_movemask_ps(_mm_cmpeq_ps(a, b)); }
+};
+
+template<> struct IndexedPQSimd::SseOps<double> {
+    typedef __m128d V;
+    static V Load(const double* p) { return _mm_loadu_pd(p); }
+    static V Max(V a, V b) { return _mm_max_pd(a, b); }
+    static V Min(V a, V b) { return _mm_min_pd(a, b); }
+    static V SpreadMax(V v) { return Max(v, _mm_shuffle_pd(v, v, 0x1)); }
+    static V SpreadMin(V v) { return Min(v, _mm_shuffle_pd(v, v, 0x1)); }
+    static int EqMask(V a, V b) { return _mm_movemask_pd(_mm_cmpeq_pd(a, b)); }
+};
+
+template<> struct IndexedPQSimd::Avx2Ops<uint32_t> {
+    typedef __m256i V;
+    INDEXEDPQ_AVX2_TARGET static V Load(const uint32_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+    INDEXEDPQ_AVX2_TARGET static V Max(V a, V b) { return _mm256_max_epu32(a, b); }
+    INDEXEDPQ_AVX2_TARGET static V Min(V a, V b) { return _mm256_min_epu32(a, b); }
+    INDEXEDPQ_AVX2_TARGET static V SpreadMax(V v) {
+        v = Max(v, _mm256_permute2x128_si256(v, v, 0x01));
+        v = Max(v, _mm256_shuffle_epi32(v, 0x4E));
+        return Max(v, _mm256_shuffle_epi32(v, 0xB1));
+    }
+    INDEXEDPQ_AVX2_TARGET static V SpreadMin(V v) {
+        v = Min(v, _mm256_permute2x128_si256(v, v, 0x01));
+        v = Min(v, _mm256_shuffle_epi32(v, 0x4E));
+        return Min(v, _mm256_shuffle_epi32(v, 0xB1));
+    }
+    INDEXEDPQ_AVX2_TARGET static int EqMask(V a, V b) {
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)));
+    }
+};
+
+template<> struct IndexedPQSimd::Avx2Ops<uint64_t> {
+    typedef __m256i V;
+    INDEXEDPQ_AVX2_TARGET static V Load(const uint64_t* p) { return _mm256_loadu_si256((const __m256i*)p); }
+    INDEXEDPQ_AVX2_TARGET static V Greater(V a, V b) {
+        const V sign = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+        return _mm256_cmpgt_epi64(_mm256_xor_si256(a, sign), _mm256_xor_si256(b, sign));
+    }
+    INDEXEDPQ_AVX2_TARGET static V Max(V a, V b) { return _mm256_blendv_epi8(a, b, Greater(b, a)); }
+    INDEXEDPQ_AVX2_TARGET static V Min(V a, V b) { return _mm256_blendv_epi8(a, b, Greater(a, b)); }
+    INDEXEDPQ_AVX2_TARGET static V SpreadMax(V v) {
+        v = Max(v, _mm256_permute2x128_si256(v, v, 0x01));
+        return Max(v, _mm256_shuffle_epi32(v, 0x4E));
+    }
+    INDEXEDPQ_AVX2_TARGET static V SpreadMin(V v) {
+        v = Min(v, _mm256_permute2x128_si256(v, v, 0x01));
+        return Min(v, _mm256_shuffle_epi32(v, 0x4E));
+    }
+    INDEXEDPQ_AVX2_TARGET static int EqMask(V a, V b) {
+        return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(a, b)));
+    }
+};
+
+template<> struct IndexedPQSimd::Avx2Ops<float> {
+    typedef __m256 V;
+    INDEXEDPQ_AVX2_TARGET static V Load(const float* p) { return _mm256_loadu_ps(p); }
+    INDEXEDPQ_AVX2_TARGET static V Max(V a, V b) { return _mm256_max_ps(a, b); }
+    INDEXEDPQ_AVX2_TARGET static V Min(V a, V b) { return _mm256_min_ps(a, b); }
+    INDEXEDPQ_AVX2_TARGET static V SpreadMax(V v) {
+        v = Max(v, _mm256_permute2f128_ps(v, v, 0x01));
+        v = Max(v, _mm256_shuffle_ps(v, v, 0x4E));
+        return Max(v, _mm256_shuffle_ps(v, v, 0xB1));
+    }
+    INDEXEDPQ_AVX2_TARGET static V SpreadMin(V v) {
+        v = Min(v, _mm256_permute2f128_ps(v, v, 0x01));
+        v = Min(v, _mm256_shuffle_ps(v, v, 0x4E));
+        return Min(v, _mm256_shuffle_ps(v, v, 0xB1));
+    }
+    INDEXEDPQ_AVX2_TARGET static int EqMask(V a, V b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)); }
+};
+
+template<> struct IndexedPQSimd::Avx2Ops<double> {
+    typedef __m256d V;
+    INDEXEDPQ_AVX2_TARGET static V Load(const double* p) { return _mm256_loadu_pd(p); }
+    INDEXEDPQ_AVX2_TARGET static V Max(V a, V b) { return _mm256_max_pd(a, b); }
+    INDEXEDPQ_AVX2_TARGET static V Min(V a, V b) { return _mm256_min_pd(a, b); }
+    INDEXEDPQ_AVX2_TARGET static V SpreadMax(V v) {
+        v = Max(v, _mm256_permute2f128_pd(v, v, 0x01));
+        return Max(v, _mm256_shuffle_pd(v, v, 0x5));
+    }
+    INDEXEDPQ_AVX2_TARGET static V SpreadMin(V v) {
+        v = Min(v, _mm256_permute2f128_pd(v, v, 0x01));
+        return Min(v, _mm256_shuffle_pd(v, v, 0x5));
+    }
+    INDEXEDPQ_AVX2_TARGET static int EqMask(V a, V b) { return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ)); }
+};
+#endif
+
+#endif //__INDEXEDPQ_INDEXED_PQ_SIMD_H__
@@ -0,0 +1,153 @@
+#ifndef __INDEXEDPQ_INDEXED_PQ_SNAPSHOT_H__
+#define __INDEXEDPQ_INDEXED_PQ_SNAPSHOT_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// how *LoadSnapshot* opens a snapshot file
+enum class IndexedPQSnapshotMode {
+    COPY,                   /// copy arrays into memory of the allocator, the file is not kept open
+    MMAP_READ_ONLY,         /// map file shared and read only, the queue must not be changed
+    MMAP_COPY_ON_WRITE,     /// map file private and writable, changed pages are copied and never written back
+};
+
+/**
+ *@brief     header of snapshot file, followed by arrays of the queue at *SECTION_ALIGN* aligned offsets:
+ *           elements, handle to heap index, heap handles, inline heap elements if any, and popped handles.
+ *           Arrays are stored as they are in memory, so a snapshot is only readable by a queue of the same element
+ *           type, handle type, arity, inline flag, generation bits and comparator, on a machine of the same byte order.
+ *           Comparator is identified by *m_compareId*, see IndexedPQCompareId.
+ */
+struct IndexedPQSnapshotHeader {
+    static constexpr char       MAGIC[8] = {'I', 'D', 'X', 'P', 'Q', 'S', 'N', 'P'};
+    static constexpr uint32_t   VERSION = 2;
+    static constexpr uint32_t   BYTE_ORDER_MARK = 0x01020304;
+    static constexpr uint64_t   SECTION_ALIGN = 64;
+
+    char        m_magic[8];
+    uint32_t    m_version;
+    uint32_t    m_byteOrderMark;
+    uint32_t    m_elemSize;
+    uint32_t    m_handleSize;
+    uint32_t    m_arity;
+    uint32_t    m_generationBits;
+    uint32_t    m_isInlineElem;
+    uint32_t    m_isFixed;
+    uint64_t    m_compareId;            /// identity of comparator type and its order
+    uint64_t    m_capacity;             /// size of elements, index and heap arrays
+    uint64_t    m_elemCnt;
+    uint64_t    m_elemConstructedCnt;
+    uint64_t    m_poppedCnt;
+    uint64_t    m_poppedCapacity;       /// size of popped handles array, not less than 1
+    uint64_t    m_elemOffset;
+    uint64_t    m_indexOffset;
+    uint64_t    m_heapOffset;           /// heap array begins with its padding slots
+    uint64_t    m_heapElemOffset;       /// 0 if elements are not inline
+    uint64_t    m_poppedOffset;
+    uint64_t    m_fileSize;
+
+    /// FNV-1a hash of *name*, which is stable across processes unlike std::type_info::hash_code
+    static uint64_t HashName(const char* name) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (; *name != '\0'; ++name) {
+            hash = (hash ^ (unsigned char)*name) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    static uint64_t AlignUp(uint64_t offset) { return (offset + SECTION_ALIGN - 1) & ~(SECTION_ALIGN - 1); }
+
+    /// fill offsets and file size from sizes and counts
+    void Layout(size_t heapPadding) {
+        uint64_t offset = AlignUp(sizeof(IndexedPQSnapshotHeader));
+        m_elemOffset = offset;
+        offset = AlignUp(offset + m_capacity * m_elemSize);
+        m_indexOffset = offset;
+        offset = AlignUp(offset + m_capacity * m_handleSize);
+        m_heapOffset = offset;
+        offset = AlignUp(offset + (m_capacity + heapPadding) * m_handleSize);
+        m_heapElemOffset = 0;
+        if (m_isInlineElem) {
+            m_heapElemOffset = offset;
+            offset = AlignUp(offset + (m_capacity + heapPadding) * m_elemSize);
+        }
+        m_poppedOffset = offset;
+        m_fileSize = offset + m_poppedCapacity * m_handleSize;
+    }
+
+    /// whether header is written by same version and layout as *expected*, and agrees with *fileSize*
+    bool IsCompatible(const IndexedPQSnapshotHeader& expected, size_t heapPadding, uint64_t fileSize) const {
+        if (0 != memcmp(m_magic, MAGIC, sizeof(MAGIC)) || m_version != VERSION || m_byteOrderMark != BYTE_ORDER_MARK
+            || m_elemSize != expected.m_elemSize || m_handleSize != expected.m_handleSize || m_arity != expected.m_arity
+            || m_generationBits != expected.m_generationBits || m_isInlineElem != expected.m_isInlineElem
+            || m_compareId != expected.m_compareId) {
+            return false;
+        }
+        if (m_elemCnt > m_capacity || m_elemConstructedCnt > m_capacity || m_poppedCnt > m_poppedCapacity
+            || 0 == m_capacity || 0 == m_poppedCapacity) {
+            return false;
+        }
+        IndexedPQSnapshotHeader layout(*this);
+        layout.Layout(heapPadding);
+        return layout.m_elemOffset == m_elemOffset && layout.m_indexOffset == m_indexOffset
+            && layout.m_heapOffset == m_heapOffset && layout.m_heapElemOffset == m_heapElemOffset
+            && layout.m_poppedOffset == m_poppedOffset && layout.m_fileSize == m_fileSize && m_fileSize == fileSize;
+    }
+};
+
+/// file helpers of snapshots, all failures are reported by return value
+struct IndexedPQSnapshotFile {
+    /// write *bytes* from *p* to *fd*, zeros are written if *p* is null
+    static bool WriteAll(int fd, const void* p, size_t bytes) {
+        static const char zeros[4096] = {};
+        while (bytes > 0) {
+            size_t chunk = nullptr == p ? std::min(bytes, sizeof(zeros)) : bytes;
+            ssize_t written = ::write(fd, nullptr == p ? zeros : p, chunk);
+            if (written <= 0) {
+                return false;
+            }
+            bytes -= written;
+            if (nullptr != p) { p = (const char*)p + written; }
+        }
+        return true;
+    }
+    /// write zeros up to *offset* of file, whose current size is *curOffset*
+    static bool PadTo(int fd, uint64_t& curOffset, uint64_t offset) {
+        if (!WriteAll(fd, nullptr, offset - curOffset)) {
+            return false;
+        }
+        curOffset = offset;
+        return true;
+    }
+    /// map whole file of *path*, shared read only if *isWritable* is false, otherwise private copy-on-write
+    static void* Map(const std::string& path, bool isWritable, size_t& bytes) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat st;
+        void* p = MAP_FAILED;
+        if (0 == ::fstat(fd, &st) && (size_t)st.st_size >= sizeof(IndexedPQSnapshotHeader)) {
+            bytes = st.st_size;
+            p = ::mmap(nullptr, bytes, isWritable ? PROT_READ | PROT_WRITE : PROT_READ,
+                       isWritable ? MAP_PRIVATE : MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        return MAP_FAILED == p ? nullptr : p;
+    }
+    static void Unmap(void* p, size_t bytes) {
+        if (nullptr != p) {
+            ::munmap(p, bytes);
+        }
+    }
+};
+
+#endif //__INDEXEDPQ_INDEXED_PQ_SNAPSHOT_H__
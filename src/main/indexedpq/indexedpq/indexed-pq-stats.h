@@ -0,0 +1,109 @@
+#ifndef __INDEXEDPQ_INDEXED_PQ_STATS_H__
+#define __INDEXEDPQ_INDEXED_PQ_STATS_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ *@brief     operation counters of one IndexedPriorityQueue, copied out by *GetStats*. Snapshots of many queues can be
+ *           summed by *+=*, and *ForEachCounter* visits every counter by a stable metric name for export.
+ */
+struct IndexedPQStatsSnapshot {
+    static constexpr size_t SIFT_DEPTH_BUCKETS = 32;    /// the last bucket also counts deeper sifts
+
+    uint64_t    m_pushCnt = 0;              /// *Push* and *Emplace* calls
+    uint64_t    m_rejectCnt = 0;            /// elements rejected by a full fixed queue, in *Push* or *IsNotNeedPushWhenSeekFixedTopN*
+    uint64_t    m_replaceCnt = 0;           /// top elements replaced, by *ReplaceTopElem* or *Push* to a full fixed queue
+    uint64_t    m_updateUpCnt = 0;          /// *Update* moving element towards the top
+    uint64_t    m_updateDownCnt = 0;        /// *Update* moving element away from the top
+    uint64_t    m_popCnt = 0;               /// *Pop* and *PopWithNoRecycle* calls
+    uint64_t    m_removeCnt = 0;            /// elements removed by *Remove*
+    uint64_t    m_compareCnt = 0;           /// comparator calls, a vectorized children group counts ARITY-1
+    uint64_t    m_growCnt = 0;              /// capacity growths of the queue
+    uint64_t    m_extendArrayCnt = 0;       /// reallocations of any array, including popped handles and dirty positions
+    uint64_t    m_extendArrayBytes = 0;     /// bytes allocated by these reallocations
+    uint64_t    m_siftDepthHist[SIFT_DEPTH_BUCKETS] = {};   /// sifts counted by levels moved
+
+    IndexedPQStatsSnapshot& operator+=(const IndexedPQStatsSnapshot& other) {
+        m_pushCnt += other.m_pushCnt;
+        m_rejectCnt += other.m_rejectCnt;
+        m_replaceCnt += other.m_replaceCnt;
+        m_updateUpCnt += other.m_updateUpCnt;
+        m_updateDownCnt += other.m_updateDownCnt;
+        m_popCnt += other.m_popCnt;
+        m_removeCnt += other.m_removeCnt;
+        m_compareCnt += other.m_compareCnt;
+        m_growCnt += other.m_growCnt;
+        m_extendArrayCnt += other.m_extendArrayCnt;
+        m_extendArrayBytes += other.m_extendArrayBytes;
+        for (size_t i = 0; i < SIFT_DEPTH_BUCKETS; ++i) {
+            m_siftDepthHist[i] += other.m_siftDepthHist[i];
+        }
+        return *this;
+    }
+
+    /// visit every counter as *func(const std::string& name, uint64_t value)*, histogram buckets are named
+    /// sift_depth_0, sift_depth_1, ... and the last one counts deeper sifts too.
+    template<class Func>
+    void ForEachCounter(Func func) const {
+        func("push", m_pushCnt);
+        func("reject", m_rejectCnt);
+        func("replace", m_replaceCnt);
+        func("update_up", m_updateUpCnt);
+        func("update_down", m_updateDownCnt);
+        func("pop", m_popCnt);
+        func("remove", m_removeCnt);
+        func("compare", m_compareCnt);
+        func("grow", m_growCnt);
+        func("extend_array", m_extendArrayCnt);
+        func("extend_array_bytes", m_extendArrayBytes);
+        for (size_t i = 0; i < SIFT_DEPTH_BUCKETS; ++i) {
+            func("sift_depth_" + std::to_string(i), m_siftDepthHist[i]);
+        }
+    }
+};
+
+/// default stats of IndexedPriorityQueue, every hook is empty and inlined away, and the snapshot is always zero.
+struct IndexedPQNoStats {
+    static constexpr bool ENABLED = false;
+
+    inline void OnPush() {}
+    inline void OnReject() {}
+    inline void OnReplace() {}
+    inline void OnUpdate(bool /*isUpward*/) {}
+    inline void OnPop() {}
+    inline void OnRemove() {}
+    inline void OnCompare(size_t /*count*/ = 1) {}
+    inline void OnGrow() {}
+    inline void OnExtendArray(size_t /*bytes*/) {}
+    inline void OnSift(size_t /*depth*/) {}
+    inline void GetSnapshot(IndexedPQStatsSnapshot& /*snapshot*/) const {}
+    inline void Reset() {}
+};
+
+/// counting stats, plain counters because a queue is used by one thread at a time.
+struct IndexedPQCountingStats {
+    static constexpr bool ENABLED = true;
+
+    inline void OnPush() { ++m_snapshot.m_pushCnt; }
+    inline void OnReject() { ++m_snapshot.m_rejectCnt; }
+    inline void OnReplace() { ++m_snapshot.m_replaceCnt; }
+    inline void OnUpdate(bool isUpward) { ++(isUpward ? m_snapshot.m_updateUpCnt : m_snapshot.m_updateDownCnt); }
+    inline void OnPop() { ++m_snapshot.m_popCnt; }
+    inline void OnRemove() { ++m_snapshot.m_removeCnt; }
+    inline void OnCompare(size_t count = 1) { m_snapshot.m_compareCnt += count; }
+    inline void OnGrow() { ++m_snapshot.m_growCnt; }
+    inline void OnExtendArray(size_t bytes) { ++m_snapshot.m_extendArrayCnt; m_snapshot.m_extendArrayBytes += bytes; }
+    inline void OnSift(size_t depth) {
+        size_t bucket = depth < IndexedPQStatsSnapshot::SIFT_DEPTH_BUCKETS ? depth : IndexedPQStatsSnapshot::SIFT_DEPTH_BUCKETS - 1;
+        ++m_snapshot.m_siftDepthHist[bucket];
+    }
+    inline void GetSnapshot(IndexedPQStatsSnapshot& snapshot) const { snapshot = m_snapshot; }
+    inline void Reset() { m_snapshot = IndexedPQStatsSnapshot(); }
+
+private:
+    IndexedPQStatsSnapshot  m_snapshot;
+};
+
+#endif //__INDEXEDPQ_INDEXED_PQ_STATS_H__
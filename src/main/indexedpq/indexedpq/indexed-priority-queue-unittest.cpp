@@ -5,6 +5,8 @@
 #include <ctime>
 #include <vector>
 #include <map>
+#include <limits>
+#include <memory_resource>
 
 using namespace std;
 CPPUNIT_TEST_SUITE_REGISTRATION(IndexedPriorityQueueTest);
@@ -109,36 +111,6 @@ void IndexedPriorityQueueTest::NormalTest()
 }
 
 
-class FakeItem {
-public:
-    bool operator!=(const FakeItem & ref) {
-        return !(*this == ref);
-    }
-    bool operator==(const FakeItem & ref) {
-        if (this != &ref) {
-            return (m_id == ref.m_id ) && (m_score == ref.m_score) && (m_flag == ref.m_flag );
-        }
-        return true;
-    }
-
-    std::string ToString() {
-        char buf[64];
-        snprintf(buf,64,"%-20lu%-20lu%-20lu",m_score,m_id,m_flag);
-        return buf;
-    }
-public:
-    uint64_t   m_id;
-    uint64_t   m_score;
-    uint64_t   m_flag; ///used to remove duplicate
-};
-
-class FakeItemMgr {
-public:
-    static void sGenFlags(size_t count, vector<uint64_t >& flags );
-    static void sGenScores(size_t count, vector<uint64_t >& scores);
-    static void sGenItems(size_t itemCount,std::size_t flagCount, std::vector<FakeItem>& itemsVec);
-};
-
 void FakeItemMgr::sGenFlags (size_t count, vector<uint64_t >& flags ) {
     flags .resize(count);
     flags .clear();
@@ -163,7 +135,6 @@ void FakeItemMgr::sGenScores(size_t count, vector<uint64_t >& scores) {
 
 void FakeItemMgr::sGenItems(size_t itemCount,std::size_t flagCount, std::vector<FakeItem>& itemsVec) {
     itemsVec.resize(itemCount);
-    itemsVec.clear();
     vector<uint64_t > flags, scores;
     sGenFlags (flagCount,flags);
     sGenScores(itemCount, scores);
@@ -206,16 +177,6 @@ void IndexedPriorityQueueTest::TopNRemoveDuplicateTest() {
     }
 }
 
-class FakeItemComparator {
-public:
-    bool operator() (const FakeItem & lhs, const FakeItem & rhs) {
-        if (lhs.m_score != rhs.m_score) {
-            return lhs.m_score > rhs.m_score;
-        }
-        else return lhs.m_id < rhs.m_id;
-    }
-};
-
 void IndexedPriorityQueueTest::InternalTopNRemoveDuplicateTest( std::ostream& os,
                                                                 size_t itemCount,
                                                                 size_t flagCount,
@@ -326,3 +287,1139 @@ void IndexedPriorityQueueTest::InternalTopNRemoveDuplicateTest( std::ostream& os
        <<"," << bruteForceTime << "," << pqTime << "," << nTimes << endl;
 }
 
+
+template<class Policy>
+void IndexedPriorityQueueTest::InternalPolicyTest(size_t count) {
+    typedef IndexedPriorityQueue<uint64_t, std::less<uint64_t>, Policy > Queue;
+    Queue pq(8);
+    vector<uint64_t> arr;
+    vector<typename Queue::HANDLE_TYPE> hts;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t value = RandomUtil<int64_t>::RandomInt64(0,1e6);
+        hts.push_back(pq.Push(value));
+        arr.push_back(value);
+        CPPUNIT_ASSERT(pq.IsHeap());
+    }
+    CPPUNIT_ASSERT_EQUAL(arr.size(), pq.GetCount());
+    for (size_t i = 0; i < count; ++i) {
+        size_t j = RandomUtil<int64_t>::RandomInt64(0,count-1);
+        uint64_t value = RandomUtil<int64_t>::RandomInt64(0,1e6);
+        pq.Update(hts[j], value);
+        arr[j] = value;
+        CPPUNIT_ASSERT(pq.IsHeap());
+        CPPUNIT_ASSERT_EQUAL(value, pq.Elem(hts[j]));
+    }
+    sort(arr.begin(), arr.end());
+    for (vector<uint64_t>::reverse_iterator rit = arr.rbegin(); rit != arr.rend(); ++rit) {
+        CPPUNIT_ASSERT_EQUAL(*rit, pq.TopElem());
+        pq.Pop();
+        CPPUNIT_ASSERT(pq.IsHeap());
+    }
+    CPPUNIT_ASSERT(pq.IsEmpty());
+
+    /// children groups must start at cache line aligned offsets when group size is power of 2
+    size_t groupBytes = Queue::ARITY * sizeof(typename Queue::HANDLE_TYPE);
+    if ((groupBytes & (groupBytes - 1)) == 0) {
+        uintptr_t firstChild = (uintptr_t)(pq.GetElementsArray() + 1);
+        CPPUNIT_ASSERT_EQUAL((uintptr_t)0, firstChild % std::min(groupBytes, Queue::CACHE_LINE_SIZE));
+    }
+}
+
+void IndexedPriorityQueueTest::ArityTest() {
+    InternalPolicyTest<IndexedPQArityPolicy<2> >(3000);
+    InternalPolicyTest<IndexedPQArityPolicy<3> >(3000);
+    InternalPolicyTest<IndexedPQArityPolicy<4> >(3000);
+    InternalPolicyTest<IndexedPQArityPolicy<8> >(3000);
+    InternalPolicyTest<IndexedPQArityPolicy<16> >(3000);
+}
+
+template<size_t Arity>
+struct InlineElemPolicy : public IndexedPQArityPolicy<Arity> {
+    static constexpr bool INLINE_ELEM = true;
+};
+
+void IndexedPriorityQueueTest::InlineElemTest() {
+    InternalPolicyTest<InlineElemPolicy<2> >(3000);
+    InternalPolicyTest<InlineElemPolicy<4> >(3000);
+    InternalPolicyTest<InlineElemPolicy<8> >(3000);
+
+    /// elements are still reachable by handle after popping and reverse sorting
+    IndexedPriorityQueue<uint32_t, less<uint32_t>, InlineElemPolicy<4> > pq(4, 4, true);
+    for (uint32_t i = 100; i > 0; --i) {
+        pq.Push(i);
+        CPPUNIT_ASSERT(pq.IsHeap());
+    }
+    CPPUNIT_ASSERT_EQUAL((uint32_t)4, pq.TopElem());
+    CPPUNIT_ASSERT(pq.IsNotNeedPushWhenSeekFixedTopN(5));
+    CPPUNIT_ASSERT(!pq.IsNotNeedPushWhenSeekFixedTopN(3));
+    size_t ht = pq.Pop();
+    CPPUNIT_ASSERT_EQUAL((uint32_t)4, pq.Elem(ht));
+    ht = pq.Push(0);
+    CPPUNIT_ASSERT_EQUAL((uint32_t)0, pq.Elem(ht));
+    pq.Update(ht, 10);
+    CPPUNIT_ASSERT(pq.IsHeap());
+    CPPUNIT_ASSERT_EQUAL((uint32_t)10, pq.TopElem());
+    size_t* sorted = pq.ReverseSort();
+    uint32_t expected[] = {1, 2, 3, 10};
+    for (size_t i = 0; i < pq.GetCount(); ++i) {
+        CPPUNIT_ASSERT_EQUAL(expected[i], pq.Elem(sorted[i]));
+    }
+}
+
+template<class Policy>
+void IndexedPriorityQueueTest::InternalPolicyPerformanceTest(std::ostream& os, size_t count) {
+    typedef IndexedPriorityQueue<uint64_t, std::less<uint64_t>, Policy > Queue;
+    vector<uint64_t> values(count), updates(count);
+    for (size_t i = 0; i < count; ++i) {
+        values[i] = RandomUtil<int64_t>::RandomInt64(0,1e12);
+        updates[i] = RandomUtil<int64_t>::RandomInt64(0,1e12);
+    }
+    Queue pq(count);
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    for (size_t i = 0; i < count; ++i) {
+        pq.Push(values[i]);
+    }
+    int64_t tPush = TimeUtil::CurrentTimeInMicroSeconds();
+    for (size_t i = 0; i < count; ++i) {
+        pq.Update(i, updates[i]);
+    }
+    int64_t tUpdate = TimeUtil::CurrentTimeInMicroSeconds();
+    uint64_t last = pq.TopElem();
+    while (!pq.IsEmpty()) {
+        CPPUNIT_ASSERT(last >= pq.TopElem());
+        last = pq.TopElem();
+        pq.Pop();
+    }
+    int64_t tPop = TimeUtil::CurrentTimeInMicroSeconds();
+    cout << "-------------arity:[" << Queue::ARITY << "],inline:[" << Queue::INLINE_ELEM << "],count:[" << count << "],push:[" << (tPush - tBegin)
+         << "]us,update:[" << (tUpdate - tPush) << "]us,pop:[" << (tPop - tUpdate) << "]us." << endl;
+    os << Queue::ARITY << "," << Queue::INLINE_ELEM << "," << count << "," << (tPush - tBegin) << "," << (tUpdate - tPush) << "," << (tPop - tUpdate) << endl;
+}
+
+/// compare d-ary and inline elements layouts with the binary one, set env INDEXEDPQ_ARITY_BENCH_MAX_COUNT(e.g. 100000000) to run larger sizes
+void IndexedPriorityQueueTest::ArityPerformanceTest() {
+    size_t maxCount = 1e5;
+    const char* pMaxCount = getenv("INDEXEDPQ_ARITY_BENCH_MAX_COUNT");
+    if (nullptr != pMaxCount) {
+        maxCount = strtoull(pMaxCount, nullptr, 10);
+    }
+    std::ofstream  os("arity_result.txt");
+    assert(os);
+    for (size_t count = 1e3; count <= maxCount; count *= 10) {
+        InternalPolicyPerformanceTest<IndexedPQArityPolicy<2> >(os, count);
+        InternalPolicyPerformanceTest<IndexedPQArityPolicy<4> >(os, count);
+        InternalPolicyPerformanceTest<IndexedPQArityPolicy<8> >(os, count);
+        InternalPolicyPerformanceTest<InlineElemPolicy<2> >(os, count);
+        InternalPolicyPerformanceTest<InlineElemPolicy<4> >(os, count);
+        InternalPolicyPerformanceTest<InlineElemPolicy<8> >(os, count);
+    }
+}
+
+template<class Policy>
+void IndexedPriorityQueueTest::InternalBuildTest(size_t count) {
+    typedef IndexedPriorityQueue<uint64_t, std::less<uint64_t>, Policy > Queue;
+    vector<uint64_t> arr;
+    for (size_t i = 0; i < count; ++i) {
+        arr.push_back(RandomUtil<int64_t>::RandomInt64(0,1e6));
+    }
+    Queue pq(4);
+    pq.Push(1);
+    pq.Push(2);
+    pq.Pop();
+    pq.Build(arr.begin(), arr.end());
+    CPPUNIT_ASSERT(pq.IsHeap());
+    CPPUNIT_ASSERT_EQUAL(count, pq.GetCount());
+    for (size_t i = 0; i < count; ++i) {
+        CPPUNIT_ASSERT_EQUAL(arr[i], pq.Elem(i));
+    }
+    pq.Update(count / 2, 2e6);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)2e6, pq.TopElem());
+    CPPUNIT_ASSERT_EQUAL(count / 2, (size_t)pq.Top());
+    pq.Update(count / 2, arr[count / 2]);
+
+    Queue pq2(arr.begin(), arr.end());
+    CPPUNIT_ASSERT(pq2.IsHeap());
+    vector<uint64_t> sorted(arr);
+    sort(sorted.begin(), sorted.end());
+    for (vector<uint64_t>::reverse_iterator rit = sorted.rbegin(); rit != sorted.rend(); ++rit) {
+        CPPUNIT_ASSERT_EQUAL(*rit, pq.TopElem());
+        CPPUNIT_ASSERT_EQUAL(*rit, pq2.TopElem());
+        pq.Pop();
+        pq2.Pop();
+    }
+
+    /// fixed IndexedPQ keeps the smallest *topN* elements
+    size_t topN = count / 3 + 1;
+    Queue pq3(topN, topN, true);
+    pq3.Build(arr.begin(), arr.end());
+    CPPUNIT_ASSERT(pq3.IsHeap());
+    CPPUNIT_ASSERT_EQUAL(topN, pq3.GetCount());
+    for (vector<uint64_t>::reverse_iterator rit = sorted.rend() - topN; rit != sorted.rend(); ++rit) {
+        CPPUNIT_ASSERT_EQUAL(*rit, pq3.TopElem());
+        pq3.Pop();
+    }
+}
+
+void IndexedPriorityQueueTest::BuildTest() {
+    InternalBuildTest<IndexedPQDefaultPolicy>(1);
+    InternalBuildTest<IndexedPQDefaultPolicy>(2);
+    InternalBuildTest<IndexedPQDefaultPolicy>(5000);
+    InternalBuildTest<IndexedPQArityPolicy<4> >(5000);
+    InternalBuildTest<InlineElemPolicy<8> >(5000);
+
+    size_t count = 1e6;
+    vector<uint64_t> arr;
+    for (size_t i = 0; i < count; ++i) {
+        arr.push_back(RandomUtil<int64_t>::RandomInt64(0,1e12));
+    }
+    /// ascending elements make every *Push* sift up to the root
+    sort(arr.begin(), arr.end());
+    IndexedPriorityQueue<uint64_t> pq(count), pq2(count);
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    for (size_t i = 0; i < count; ++i) {
+        pq.Push(arr[i]);
+    }
+    int64_t tPush = TimeUtil::CurrentTimeInMicroSeconds();
+    pq2.Build(arr.begin(), arr.end());
+    int64_t tBuild = TimeUtil::CurrentTimeInMicroSeconds();
+    cout << "-------------count:[" << count << "],push one by one:[" << (tPush - tBegin) / 1000
+         << "]ms,build:[" << (tBuild - tPush) / 1000 << "]ms." << endl;
+    CPPUNIT_ASSERT_EQUAL(pq.TopElem(), pq2.TopElem());
+}
+
+template<class Policy>
+void IndexedPriorityQueueTest::InternalBatchTest(size_t count, size_t batchSize) {
+    typedef IndexedPriorityQueue<uint64_t, std::less<uint64_t>, Policy > Queue;
+    Queue pq;
+    vector<uint64_t> arr;
+    vector<typename Queue::HANDLE_TYPE> hts;
+    for (size_t i = 0; i < count; ++i) {
+        arr.push_back(RandomUtil<int64_t>::RandomInt64(0,1e6));
+    }
+    hts.resize(count);
+    pq.PushBatch(arr.begin(), arr.end(), hts.data());
+    CPPUNIT_ASSERT(pq.IsHeap());
+    for (size_t i = 0; i < count; ++i) {
+        CPPUNIT_ASSERT_EQUAL(arr[i], pq.Elem(hts[i]));
+    }
+
+    for (size_t round = 0; round < 10; ++round) {
+        pq.BeginBatch();
+        CPPUNIT_ASSERT(pq.IsInBatch());
+        for (size_t i = 0; i < batchSize; ++i) {
+            if (i % 5 == 0) {
+                uint64_t value = RandomUtil<int64_t>::RandomInt64(0,1e6);
+                hts.push_back(pq.Push(value));
+                arr.push_back(value);
+            }
+            else {
+                size_t j = RandomUtil<int64_t>::RandomInt64(0,arr.size()-1);
+                arr[j] = RandomUtil<int64_t>::RandomInt64(0,1e6);
+                pq.Update(hts[j], arr[j]);
+            }
+        }
+        pq.CommitBatch();
+        CPPUNIT_ASSERT(!pq.IsInBatch());
+        CPPUNIT_ASSERT(pq.IsHeap());
+    }
+
+    vector<uint64_t> sorted(arr);
+    sort(sorted.begin(), sorted.end());
+    for (vector<uint64_t>::reverse_iterator rit = sorted.rbegin(); rit != sorted.rend(); ++rit) {
+        CPPUNIT_ASSERT_EQUAL(*rit, pq.TopElem());
+        pq.Pop();
+    }
+}
+
+void IndexedPriorityQueueTest::BatchTest() {
+    InternalBatchTest<IndexedPQDefaultPolicy>(1, 1);
+    InternalBatchTest<IndexedPQDefaultPolicy>(5000, 3);
+    InternalBatchTest<IndexedPQDefaultPolicy>(5000, 100);
+    InternalBatchTest<IndexedPQDefaultPolicy>(5000, 6000);
+    InternalBatchTest<IndexedPQArityPolicy<4> >(5000, 50);
+    InternalBatchTest<InlineElemPolicy<8> >(5000, 2000);
+
+    /// pushing to a full fixed IndexedPQ in batch commits pending changes
+    size_t topN = 100;
+    IndexedPriorityQueue<uint64_t> fixedPq(topN, topN, true);
+    vector<uint64_t> arr;
+    for (size_t i = 0; i < 1000; ++i) {
+        arr.push_back(RandomUtil<int64_t>::RandomInt64(0,1e6));
+    }
+    fixedPq.PushBatch(arr.begin(), arr.end());
+    CPPUNIT_ASSERT(fixedPq.IsHeap());
+    sort(arr.begin(), arr.end());
+    for (size_t i = topN; i > 0; --i) {
+        CPPUNIT_ASSERT_EQUAL(arr[i - 1], fixedPq.TopElem());
+        fixedPq.Pop();
+    }
+
+    /// performance of updates one by one and in batch
+    size_t count = 2e5, updateCount = 5e4;
+    vector<uint64_t> values, newValues;
+    vector<size_t> hts;
+    for (size_t i = 0; i < count; ++i) {
+        values.push_back(RandomUtil<int64_t>::RandomInt64(0,1e12));
+    }
+    for (size_t i = 0; i < updateCount; ++i) {
+        hts.push_back(RandomUtil<int64_t>::RandomInt64(0,count-1));
+        newValues.push_back(RandomUtil<int64_t>::RandomInt64(0,1e12));
+    }
+    IndexedPriorityQueue<uint64_t> pq(values.begin(), values.end()), pq2(values.begin(), values.end());
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    for (size_t i = 0; i < updateCount; ++i) {
+        pq.Update(hts[i], newValues[i]);
+    }
+    int64_t tUpdate = TimeUtil::CurrentTimeInMicroSeconds();
+    pq2.UpdateBatch(hts.data(), newValues.data(), updateCount);
+    int64_t tBatch = TimeUtil::CurrentTimeInMicroSeconds();
+    cout << "-------------count:[" << count << "],updateCount:[" << updateCount << "],update one by one:["
+         << (tUpdate - tBegin) / 1000 << "]ms,update batch:[" << (tBatch - tUpdate) / 1000 << "]ms." << endl;
+    CPPUNIT_ASSERT(pq2.IsHeap());
+    CPPUNIT_ASSERT_EQUAL(pq.TopElem(), pq2.TopElem());
+}
+
+/// memory resource counting bytes allocated from upstream
+class CountingMemoryResource : public std::pmr::memory_resource {
+public:
+    size_t m_allocCount = 0;
+    size_t m_allocBytes = 0;
+private:
+    void* do_allocate(size_t bytes, size_t align) override {
+        ++m_allocCount;
+        m_allocBytes += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, align);
+    }
+    void do_deallocate(void* p, size_t bytes, size_t align) override {
+        m_allocBytes -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+struct PmrPolicy : public IndexedPQArityPolicy<4> {
+    typedef std::pmr::polymorphic_allocator<char> ALLOCATOR_TYPE;
+};
+
+struct HugePagePolicy : public IndexedPQDefaultPolicy {
+    static constexpr size_t HUGE_PAGE_THRESHOLD = 1024 * 1024;
+};
+
+void IndexedPriorityQueueTest::AllocatorTest() {
+    /// all arrays come from memory resource, including growth, and are returned on destruction
+    CountingMemoryResource resource;
+    {
+        IndexedPriorityQueue<uint64_t, std::less<uint64_t>, PmrPolicy> pq(4, 2, false, std::less<uint64_t>(), &resource);
+        CPPUNIT_ASSERT(pq.GetAllocator().resource() == &resource);
+        size_t allocCount = resource.m_allocCount;
+        CPPUNIT_ASSERT(allocCount > 0);
+        vector<uint64_t> arr;
+        for (size_t i = 0; i < 3000; ++i) {
+            arr.push_back(RandomUtil<int64_t>::RandomInt64(0,1e9));
+            pq.Push(arr.back());
+        }
+        CPPUNIT_ASSERT(resource.m_allocCount > allocCount);
+        CPPUNIT_ASSERT(pq.IsHeap());
+        CPPUNIT_ASSERT_EQUAL((size_t)0, (size_t)(pq.GetElementsArray() - PmrPolicy::ARITY + 1) % IndexedPriorityQueue<uint64_t>::CACHE_LINE_SIZE);
+        sort(arr.begin(), arr.end());
+        for (size_t i = arr.size(); i > 0; --i) {
+            CPPUNIT_ASSERT_EQUAL(arr[i - 1], pq.TopElem());
+            pq.Pop();
+        }
+    }
+    CPPUNIT_ASSERT_EQUAL((size_t)0, resource.m_allocBytes);
+
+    /// big arrays are aligned to huge page
+    IndexedPriorityQueue<uint64_t, std::less<uint64_t>, HugePagePolicy> hugePq(1024 * 1024);
+    CPPUNIT_ASSERT_EQUAL((size_t)0, (size_t)(hugePq.GetElementsArray() - HugePagePolicy::ARITY + 1) % (2 * 1024 * 1024));
+    for (size_t i = 0; i < 1000; ++i) {
+        hugePq.Push(i);
+    }
+    CPPUNIT_ASSERT_EQUAL((uint64_t)999, hugePq.TopElem());
+
+    /// performance of many short lived queues with global heap and a monotonic arena
+    size_t queueCount = 1e5, elemCount = 64;
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    uint64_t sum = 0;
+    for (size_t i = 0; i < queueCount; ++i) {
+        IndexedPriorityQueue<uint64_t, std::less<uint64_t>, IndexedPQArityPolicy<4> > pq(16);
+        for (size_t j = 0; j < elemCount; ++j) { pq.Push(j ^ i); }
+        sum += pq.TopElem();
+    }
+    int64_t tHeap = TimeUtil::CurrentTimeInMicroSeconds();
+    std::vector<char> arenaBuffer(64 * 1024);
+    for (size_t i = 0; i < queueCount; ++i) {
+        std::pmr::monotonic_buffer_resource arena(arenaBuffer.data(), arenaBuffer.size());
+        IndexedPriorityQueue<uint64_t, std::less<uint64_t>, PmrPolicy> pq(16, 32, false, std::less<uint64_t>(), &arena);
+        for (size_t j = 0; j < elemCount; ++j) { pq.Push(j ^ i); }
+        sum -= pq.TopElem();
+    }
+    int64_t tArena = TimeUtil::CurrentTimeInMicroSeconds();
+    cout << "-------------queueCount:[" << queueCount << "],elemCount:[" << elemCount << "],global heap:["
+         << (tHeap - tBegin) / 1000 << "]ms,monotonic arena:[" << (tArena - tHeap) / 1000 << "]ms." << endl;
+    CPPUNIT_ASSERT_EQUAL((uint64_t)0, sum);
+}
+
+/// payload without default constructor, which counts its copies and alive instances
+class CountedPayload {
+public:
+    static size_t s_copyCount;
+    static size_t s_aliveCount;
+    CountedPayload(uint64_t score, const string& text) : m_score(score), m_text(text) { ++s_aliveCount; }
+    CountedPayload(const CountedPayload& ref) : m_score(ref.m_score), m_text(ref.m_text) { ++s_copyCount; ++s_aliveCount; }
+    CountedPayload(CountedPayload&& ref) noexcept : m_score(ref.m_score), m_text(std::move(ref.m_text)) { ++s_aliveCount; }
+    CountedPayload& operator=(const CountedPayload& ref) { m_score = ref.m_score; m_text = ref.m_text; ++s_copyCount; return *this; }
+    CountedPayload& operator=(CountedPayload&& ref) noexcept { m_score = ref.m_score; m_text = std::move(ref.m_text); return *this; }
+    ~CountedPayload() { --s_aliveCount; }
+    bool operator<(const CountedPayload& ref) const { return m_score < ref.m_score; }
+public:
+    uint64_t  m_score;
+    string    m_text;
+};
+size_t CountedPayload::s_copyCount = 0;
+size_t CountedPayload::s_aliveCount = 0;
+
+void IndexedPriorityQueueTest::MoveSemanticsTest() {
+    size_t count = 2000;
+    vector<uint64_t> scores;
+    for (size_t i = 0; i < count; ++i) {
+        scores.push_back(RandomUtil<int64_t>::RandomInt64(0,1e9));
+    }
+    CountedPayload::s_copyCount = 0;
+    CountedPayload::s_aliveCount = 0;
+    {
+        /// growth moves payloads, rvalue *Push*, *Update*, *Emplace* and *ReplaceTopElem* never copy them
+        IndexedPriorityQueue<CountedPayload> pq(2);
+        CPPUNIT_ASSERT_EQUAL((size_t)0, CountedPayload::s_aliveCount);
+        vector<size_t> hts;
+        for (size_t i = 0; i < count; ++i) {
+            string text(100, 'a' + i % 26);
+            if (i % 2 == 0) {
+                hts.push_back(pq.Push(CountedPayload(scores[i], text)));
+            }
+            else {
+                hts.push_back(pq.Emplace(scores[i], text));
+            }
+        }
+        for (size_t i = 0; i < count; i += 3) {
+            CountedPayload removed(0, "");
+            scores[i] = RandomUtil<int64_t>::RandomInt64(0,1e9);
+            pq.Update(hts[i], CountedPayload(scores[i], string(100, 'z')), &removed);
+            CPPUNIT_ASSERT_EQUAL((size_t)100, removed.m_text.size());
+        }
+        CPPUNIT_ASSERT(pq.IsHeap());
+        CPPUNIT_ASSERT_EQUAL((size_t)0, CountedPayload::s_copyCount);
+        CPPUNIT_ASSERT_EQUAL(count, CountedPayload::s_aliveCount);
+        sort(scores.begin(), scores.end());
+        for (size_t i = count; i > 0; --i) {
+            CPPUNIT_ASSERT_EQUAL(scores[i - 1], pq.TopElem().m_score);
+            CPPUNIT_ASSERT_EQUAL((size_t)100, pq.TopElem().m_text.size());
+            pq.Pop();
+        }
+        pq.Emplace(7, "seven");
+        pq.ReplaceTopElem(CountedPayload(8, "eight"));
+        CPPUNIT_ASSERT(pq.TopElem().m_text == "eight");
+        CPPUNIT_ASSERT_EQUAL((size_t)0, CountedPayload::s_copyCount);
+    }
+    CPPUNIT_ASSERT_EQUAL((size_t)0, CountedPayload::s_aliveCount);
+
+    /// fixed queue moves replaced top out to *pRemovedElem*
+    IndexedPriorityQueue<string> fixedPq(3, 3, true);
+    fixedPq.Push(string("b"));
+    fixedPq.Push(string("d"));
+    fixedPq.Push(string("c"));
+    string removed;
+    CPPUNIT_ASSERT(fixedPq.IsValid(fixedPq.Push(string("a"), &removed)));
+    CPPUNIT_ASSERT(removed == "d");
+    CPPUNIT_ASSERT(!fixedPq.IsValid(fixedPq.Emplace(5, 'z')));
+    CPPUNIT_ASSERT(fixedPq.TopElem() == "c");
+
+    /// new element referring to the old one itself is kept while the old one is moved out
+    IndexedPriorityQueue<string> aliasPq;
+    size_t ht = aliasPq.Push(string("self"));
+    aliasPq.Push(string("other"));
+    string old;
+    aliasPq.Update(ht, aliasPq.Elem(ht), &old);
+    CPPUNIT_ASSERT(old == "self");
+    CPPUNIT_ASSERT(aliasPq.Elem(ht) == "self");
+    aliasPq.Update(ht, old, &old);
+    CPPUNIT_ASSERT(old == "self");
+    CPPUNIT_ASSERT(aliasPq.Elem(ht) == "self");
+}
+
+struct CompactHandlePolicy : public IndexedPQArityPolicy<4> {
+    typedef uint32_t HANDLE_TYPE;
+};
+
+void IndexedPriorityQueueTest::HandleTypeTest() {
+    InternalPolicyTest<IndexedPQHandlePolicy<uint32_t> >(3000);
+    InternalPolicyTest<IndexedPQHandlePolicy<uint16_t> >(3000);
+    InternalPolicyTest<CompactHandlePolicy>(3000);
+    InternalBuildTest<CompactHandlePolicy>(5000);
+    InternalBatchTest<CompactHandlePolicy>(5000, 100);
+    CPPUNIT_ASSERT_EQUAL((size_t)4, sizeof(IndexedPriorityQueue<uint64_t, std::less<uint64_t>, CompactHandlePolicy>::HANDLE_TYPE));
+    CPPUNIT_ASSERT_EQUAL((size_t)std::string::npos, (size_t)IndexedPriorityQueue<uint64_t>::INVALID_HANDLE);
+
+    /// elements count is limited by handle type, max value is the invalid handle
+    typedef IndexedPriorityQueue<uint64_t, std::less<uint64_t>, IndexedPQHandlePolicy<uint8_t> > TinyQueue;
+    CPPUNIT_ASSERT_EQUAL((size_t)255, TinyQueue::MAX_COUNT);
+    TinyQueue tinyPq(2);
+    for (size_t i = 0; i < TinyQueue::MAX_COUNT; ++i) {
+        CPPUNIT_ASSERT(tinyPq.IsValid(tinyPq.Push(i)));
+    }
+    uint64_t removed = 0;
+    CPPUNIT_ASSERT_EQUAL(TinyQueue::INVALID_HANDLE, tinyPq.Push(1000, &removed));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1000, removed);
+    CPPUNIT_ASSERT_EQUAL(TinyQueue::INVALID_HANDLE, tinyPq.Emplace(1000));
+    CPPUNIT_ASSERT_EQUAL(TinyQueue::MAX_COUNT, tinyPq.GetCount());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)254, tinyPq.TopElem());
+    TinyQueue::HANDLE_TYPE ht = tinyPq.Pop();
+    CPPUNIT_ASSERT_EQUAL(ht, tinyPq.Push(1000));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1000, tinyPq.TopElem());
+    CPPUNIT_ASSERT(tinyPq.IsHeap());
+
+    /// fixed TopN with uint16_t handles
+    IndexedPriorityQueue<uint64_t, std::less<uint64_t>, IndexedPQHandlePolicy<uint16_t> > topNPq(100, 32, true);
+    vector<uint64_t> arr;
+    for (size_t i = 0; i < 10000; ++i) {
+        arr.push_back(RandomUtil<int64_t>::RandomInt64(0,1e9));
+        topNPq.Push(arr.back());
+    }
+    sort(arr.begin(), arr.end());
+    for (size_t i = 100; i > 0; --i) {
+        CPPUNIT_ASSERT_EQUAL(arr[i - 1], topNPq.TopElem());
+        topNPq.Pop();
+    }
+}
+
+template<class Policy>
+void IndexedPriorityQueueTest::InternalExtractTopKTest(size_t count) {
+    typedef IndexedPriorityQueue<uint64_t, std::greater<uint64_t>, Policy > Queue;
+    vector<uint64_t> arr;
+    for (size_t i = 0; i < count; ++i) {
+        arr.push_back(RandomUtil<int64_t>::RandomInt64(0,1e4));
+    }
+    Queue pq(arr.begin(), arr.end());
+    sort(arr.begin(), arr.end());
+    vector<typename Queue::HANDLE_TYPE> hts(count + 10);
+    size_t ks[] = {0, 1, 2, 10, count / 2, count, count + 10};
+    for (size_t k : ks) {
+        size_t realK = pq.ExtractTopK(k, hts.data());
+        CPPUNIT_ASSERT_EQUAL(std::min(k, count), realK);
+        for (size_t i = 0; i < realK; ++i) {
+            CPPUNIT_ASSERT_EQUAL(arr[i], pq.Elem(hts[i]));
+        }
+        CPPUNIT_ASSERT_EQUAL(count, pq.GetCount());
+        CPPUNIT_ASSERT(pq.IsHeap());
+    }
+    if (count > 0) {
+        CPPUNIT_ASSERT_EQUAL(pq.Top(), hts[0]);
+    }
+
+    /// sorted handles by *ReverseSort* are consistent with handle to heap index mapping
+    typename Queue::HANDLE_TYPE* sorted = pq.ReverseSort();
+    for (size_t i = 0; i < count; ++i) {
+        CPPUNIT_ASSERT_EQUAL(arr[count - 1 - i], pq.Elem(sorted[i]));
+        CPPUNIT_ASSERT_EQUAL(arr[count - 1 - i], pq.ElemAtHeap(i));
+    }
+    pq.Build(arr.rbegin(), arr.rend());
+    CPPUNIT_ASSERT(pq.IsHeap());
+}
+
+void IndexedPriorityQueueTest::ExtractTopKTest() {
+    InternalExtractTopKTest<IndexedPQDefaultPolicy>(0);
+    InternalExtractTopKTest<IndexedPQDefaultPolicy>(1);
+    InternalExtractTopKTest<IndexedPQDefaultPolicy>(1000);
+    InternalExtractTopKTest<IndexedPQArityPolicy<3> >(1000);
+    InternalExtractTopKTest<IndexedPQArityPolicy<8> >(1000);
+    InternalExtractTopKTest<InlineElemPolicy<4> >(1000);
+
+    /// performance of best 10 of 10K elements, and full sort
+    size_t count = 1e4, k = 10, times = 1000;
+    vector<uint64_t> arr;
+    for (size_t i = 0; i < count; ++i) {
+        arr.push_back(RandomUtil<int64_t>::RandomInt64(0,1e12));
+    }
+    IndexedPriorityQueue<uint64_t> pq(arr.begin(), arr.end());
+    vector<size_t> hts(count);
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    for (size_t i = 0; i < times; ++i) {
+        pq.ExtractTopK(k, hts.data());
+    }
+    int64_t tTopK = TimeUtil::CurrentTimeInMicroSeconds();
+    for (size_t i = 0; i < times; ++i) {
+        IndexedPriorityQueue<uint64_t> copyPq(arr.begin(), arr.end());
+        for (size_t j = 0; j < k; ++j) { copyPq.Pop(); }
+    }
+    int64_t tCopyPop = TimeUtil::CurrentTimeInMicroSeconds();
+    for (size_t i = 0; i < times / 10; ++i) {
+        IndexedPriorityQueue<uint64_t> copyPq(arr.begin(), arr.end());
+        copyPq.ReverseSort();
+    }
+    int64_t tSort = TimeUtil::CurrentTimeInMicroSeconds();
+    cout << "-------------count:[" << count << "],k:[" << k << "],times:[" << times << "],ExtractTopK:["
+         << (tTopK - tBegin) << "]us,build copy and pop:[" << (tCopyPop - tTopK) << "]us,build copy and ReverseSort("
+         << times / 10 << " times):[" << (tSort - tCopyPop) << "]us." << endl;
+}
+
+template<size_t GenerationBits, class Handle = size_t, size_t Arity = 2>
+struct GenerationPolicy : public IndexedPQArityPolicy<Arity> {
+    typedef Handle HANDLE_TYPE;
+    static constexpr size_t GENERATION_BITS = GenerationBits;
+};
+
+template<class Policy>
+void IndexedPriorityQueueTest::InternalRemoveTest(size_t opCount) {
+    typedef IndexedPriorityQueue<uint64_t, std::less<uint64_t>, Policy > Queue;
+    typedef typename Queue::HANDLE_TYPE HANDLE_TYPE;
+    Queue pq(4);
+    map<HANDLE_TYPE, uint64_t> ht2Values;
+    for (size_t i = 0; i < opCount; ++i) {
+        int64_t op = RandomUtil<int64_t>::RandomInt64(0, 9);
+        uint64_t value = RandomUtil<int64_t>::RandomInt64(0, 1e6);
+        if (op < 4 || ht2Values.empty()) {
+            HANDLE_TYPE ht = pq.Push(value);
+            CPPUNIT_ASSERT(ht2Values.find(ht) == ht2Values.end());
+            ht2Values[ht] = value;
+        }
+        else {
+            auto it = ht2Values.begin();
+            std::advance(it, RandomUtil<int64_t>::RandomInt64(0, ht2Values.size() - 1));
+            if (op < 7) {
+                uint64_t removed = 0;
+                CPPUNIT_ASSERT(pq.Remove(it->first, &removed));
+                CPPUNIT_ASSERT_EQUAL(it->second, removed);
+                CPPUNIT_ASSERT(!pq.Contains(it->first));
+                ht2Values.erase(it);
+            }
+            else if (op < 9) {
+                CPPUNIT_ASSERT_EQUAL(it->first, pq.Update(it->first, value));
+                it->second = value;
+            }
+            else {
+                CPPUNIT_ASSERT_EQUAL(std::max_element(ht2Values.begin(), ht2Values.end(),
+                    [](const pair<const HANDLE_TYPE, uint64_t>& a, const pair<const HANDLE_TYPE, uint64_t>& b) {
+                        return a.second < b.second; })->second, pq.TopElem());
+                HANDLE_TYPE ht = pq.Pop();
+                CPPUNIT_ASSERT(!pq.Contains(ht));
+                ht2Values.erase(ht);
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL(ht2Values.size(), pq.GetCount());
+        if (i % 64 == 0) {
+            CPPUNIT_ASSERT(pq.IsHeap());
+            for (auto& kv : ht2Values) {
+                CPPUNIT_ASSERT(pq.Contains(kv.first));
+                CPPUNIT_ASSERT_EQUAL(kv.second, pq.Elem(kv.first));
+            }
+        }
+    }
+    CPPUNIT_ASSERT(!pq.Contains(Queue::INVALID_HANDLE));
+    CPPUNIT_ASSERT(!pq.Remove(Queue::INVALID_HANDLE));
+}
+
+void IndexedPriorityQueueTest::RemoveTest() {
+    InternalRemoveTest<IndexedPQDefaultPolicy>(20000);
+    InternalRemoveTest<IndexedPQArityPolicy<4> >(20000);
+    InternalRemoveTest<InlineElemPolicy<4> >(20000);
+    InternalRemoveTest<GenerationPolicy<8, uint32_t> >(20000);
+    InternalRemoveTest<GenerationPolicy<16, size_t, 8> >(20000);
+
+    /// stale handles are detected by generation after their slots are recycled
+    typedef IndexedPriorityQueue<uint64_t, std::less<uint64_t>, GenerationPolicy<8, uint32_t> > Queue;
+    CPPUNIT_ASSERT_EQUAL((size_t)0xFFFFFF, Queue::MAX_COUNT);
+    Queue pq;
+    Queue::HANDLE_TYPE ht = pq.Push(10);
+    pq.Push(20);
+    CPPUNIT_ASSERT(pq.Remove(ht));
+    Queue::HANDLE_TYPE newHt = pq.Push(30);
+    CPPUNIT_ASSERT(newHt != ht);
+    CPPUNIT_ASSERT_EQUAL(ht & Queue::SLOT_MASK, newHt & Queue::SLOT_MASK);
+    CPPUNIT_ASSERT(!pq.Contains(ht));
+    CPPUNIT_ASSERT(pq.Contains(newHt));
+    CPPUNIT_ASSERT_EQUAL(Queue::INVALID_HANDLE, pq.Update(ht, 40));
+    CPPUNIT_ASSERT(!pq.Remove(ht));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)30, pq.Elem(newHt));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)30, pq.TopElem());
+    Queue::HANDLE_TYPE poppedHt = pq.Pop();
+    CPPUNIT_ASSERT_EQUAL(newHt, poppedHt);
+    CPPUNIT_ASSERT(!pq.Contains(newHt));
+    CPPUNIT_ASSERT_EQUAL(Queue::INVALID_HANDLE, pq.Update(newHt, 40));
+
+    /// performance of *Remove* and the pattern of *Update* to sentinel and *Pop*
+    size_t count = 2e5, removeCount = 5e4;
+    vector<uint64_t> values;
+    vector<size_t> hts;
+    for (size_t i = 0; i < count; ++i) {
+        values.push_back(RandomUtil<int64_t>::RandomInt64(0,1e12));
+    }
+    for (size_t i = 0; i < count; ++i) { hts.push_back(i); }
+    std::shuffle(hts.begin(), hts.end(), std::mt19937(count));
+    IndexedPriorityQueue<uint64_t> pq1(values.begin(), values.end()), pq2(values.begin(), values.end());
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    for (size_t i = 0; i < removeCount; ++i) {
+        pq1.Update(hts[i], std::numeric_limits<uint64_t>::max());
+        pq1.Pop();
+    }
+    int64_t tUpdatePop = TimeUtil::CurrentTimeInMicroSeconds();
+    for (size_t i = 0; i < removeCount; ++i) {
+        pq2.Remove(hts[i]);
+    }
+    int64_t tRemove = TimeUtil::CurrentTimeInMicroSeconds();
+    cout << "-------------count:[" << count << "],removeCount:[" << removeCount << "],update and pop:["
+         << (tUpdatePop - tBegin) / 1000 << "]ms,remove:[" << (tRemove - tUpdatePop) / 1000 << "]ms." << endl;
+    CPPUNIT_ASSERT(pq2.IsHeap());
+    CPPUNIT_ASSERT_EQUAL(pq1.TopElem(), pq2.TopElem());
+}
+
+void IndexedPriorityQueueTest::StatsTest() {
+    /// default stats take no space
+    static_assert(std::is_empty<IndexedPQNoStats>::value, "no stats should be empty");
+    CPPUNIT_ASSERT_EQUAL(sizeof(IndexedPriorityQueue<uint64_t>) + sizeof(IndexedPQStatsSnapshot),
+                         sizeof(IndexedPriorityQueue<uint64_t, std::less<uint64_t>, IndexedPQStatsPolicy>));
+    IndexedPriorityQueue<uint64_t> noStatsPq;
+    noStatsPq.Push(1);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)0, noStatsPq.GetStats().m_pushCnt);
+
+    IndexedPriorityQueue<uint64_t, std::less<uint64_t>, IndexedPQStatsPolicy> pq(4, 4);
+    vector<size_t> hts;
+    for (uint64_t i = 0; i < 10; ++i) {
+        hts.push_back(pq.Push(i * 10));
+    }
+    IndexedPQStatsSnapshot stats = pq.GetStats();
+    CPPUNIT_ASSERT_EQUAL((uint64_t)10, stats.m_pushCnt);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)2, stats.m_growCnt);
+    /// elements, index and heap arrays are extended by every growth
+    CPPUNIT_ASSERT_EQUAL((uint64_t)6, stats.m_extendArrayCnt);
+    CPPUNIT_ASSERT(stats.m_extendArrayBytes > 0);
+    /// ascending pushes to MaxTop heap sift every element upwards
+    uint64_t siftCnt = 0;
+    for (size_t i = 0; i < IndexedPQStatsSnapshot::SIFT_DEPTH_BUCKETS; ++i) { siftCnt += stats.m_siftDepthHist[i]; }
+    CPPUNIT_ASSERT_EQUAL((uint64_t)10, siftCnt);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, stats.m_siftDepthHist[0]);
+    CPPUNIT_ASSERT(stats.m_compareCnt >= 9);
+
+    pq.Update(hts[0], 1000);
+    pq.Update(hts[9], 0);
+    pq.Update(hts[5], 55);
+    pq.Pop();
+    pq.Remove(hts[3]);
+    stats = pq.GetStats();
+    CPPUNIT_ASSERT_EQUAL((uint64_t)2, stats.m_updateUpCnt);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, stats.m_updateDownCnt);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, stats.m_popCnt);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, stats.m_removeCnt);
+
+    pq.ResetStats();
+    stats = pq.GetStats();
+    size_t counterCnt = 0;
+    uint64_t counterSum = 0;
+    stats.ForEachCounter([&](const std::string& name, uint64_t value) { ++counterCnt; counterSum += value; });
+    CPPUNIT_ASSERT_EQUAL((size_t)11 + IndexedPQStatsSnapshot::SIFT_DEPTH_BUCKETS, counterCnt);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)0, counterSum);
+
+    /// fixed TopN counts replacements and rejections
+    IndexedPriorityQueue<uint64_t, std::less<uint64_t>, IndexedPQStatsPolicy> topN(3, 1, true);
+    for (uint64_t v : {50, 40, 30, 20, 60, 10}) {
+        if (!topN.IsNotNeedPushWhenSeekFixedTopN(v)) {
+            topN.Push(v);
+        }
+    }
+    topN.Push(70);
+    topN.ReplaceTopElem(5);
+    stats = topN.GetStats();
+    CPPUNIT_ASSERT_EQUAL((uint64_t)6, stats.m_pushCnt);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)2, stats.m_rejectCnt);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)3, stats.m_replaceCnt);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)0, stats.m_growCnt);
+
+    /// Build and Merge extend arrays once to the final count
+    vector<uint64_t> values(1000);
+    for (size_t i = 0; i < values.size(); ++i) { values[i] = i; }
+    IndexedPriorityQueue<uint64_t, std::less<uint64_t>, IndexedPQStatsPolicy> builtPq(4, 4);
+    builtPq.Build(values.begin(), values.end());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, builtPq.GetStats().m_growCnt);
+    IndexedPriorityQueue<uint64_t, std::less<uint64_t>, IndexedPQStatsPolicy> mergedPq(4, 4);
+    mergedPq.Push(2000);
+    CPPUNIT_ASSERT_EQUAL((size_t)1000, mergedPq.Merge(builtPq));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, mergedPq.GetStats().m_growCnt);
+    CPPUNIT_ASSERT_EQUAL((size_t)1001, mergedPq.GetCount());
+    CPPUNIT_ASSERT(mergedPq.IsHeap());
+
+    IndexedPQStatsSnapshot total = stats;
+    total += stats;
+    CPPUNIT_ASSERT_EQUAL((uint64_t)12, total.m_pushCnt);
+    CPPUNIT_ASSERT_EQUAL(stats.m_compareCnt * 2, total.m_compareCnt);
+}
+
+template<class Policy>
+void IndexedPriorityQueueTest::InternalSnapshotTest(size_t count) {
+    typedef IndexedPriorityQueue<uint64_t, std::less<uint64_t>, Policy> Queue;
+    typedef typename Queue::HANDLE_TYPE HANDLE_TYPE;
+    std::string path = "indexedpq_snapshot_test.ipq";
+    Queue pq(count / 4);
+    vector<HANDLE_TYPE> hts;
+    for (size_t i = 0; i < count; ++i) {
+        hts.push_back(pq.Push(RandomUtil<int64_t>::RandomInt64(0,1e12)));
+    }
+    /// popped and removed handles are kept in the free list of the snapshot
+    for (size_t i = 0; i < count / 10; ++i) {
+        pq.Remove(hts[i * 7 % count]);
+        pq.Pop();
+    }
+    vector<HANDLE_TYPE> liveHts;
+    for (size_t i = 0; i < count; ++i) {
+        if (pq.Contains(hts[i])) { liveHts.push_back(hts[i]); }
+    }
+    CPPUNIT_ASSERT(pq.SaveSnapshot(path));
+
+    for (IndexedPQSnapshotMode mode : {IndexedPQSnapshotMode::COPY, IndexedPQSnapshotMode::MMAP_READ_ONLY,
+                                       IndexedPQSnapshotMode::MMAP_COPY_ON_WRITE}) {
+        Queue loaded(8);
+        loaded.Push(1);
+        CPPUNIT_ASSERT(loaded.LoadSnapshot(path, mode));
+        CPPUNIT_ASSERT_EQUAL(mode == IndexedPQSnapshotMode::MMAP_READ_ONLY, loaded.IsReadOnly());
+        CPPUNIT_ASSERT_EQUAL(pq.GetCount(), loaded.GetCount());
+        CPPUNIT_ASSERT(loaded.IsHeap());
+        CPPUNIT_ASSERT_EQUAL(pq.Top(), loaded.Top());
+        for (size_t i = 0; i < liveHts.size(); ++i) {
+            CPPUNIT_ASSERT(loaded.Contains(liveHts[i]));
+            CPPUNIT_ASSERT_EQUAL(pq.Elem(liveHts[i]), loaded.Elem(liveHts[i]));
+        }
+        size_t k = std::min<size_t>(100, pq.GetCount());
+        vector<HANDLE_TYPE> topHts(k), loadedTopHts(k);
+        pq.ExtractTopK(k, topHts.data());
+        loaded.ExtractTopK(k, loadedTopHts.data());
+        CPPUNIT_ASSERT(topHts == loadedTopHts);
+        if (mode == IndexedPQSnapshotMode::MMAP_READ_ONLY) {
+            continue;
+        }
+        /// writable queue recycles the same handles as the original one, and grows out of the mapping
+        Queue copied(count);
+        CPPUNIT_ASSERT(copied.LoadSnapshot(path, IndexedPQSnapshotMode::COPY));
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t value = RandomUtil<int64_t>::RandomInt64(0,1e12);
+            CPPUNIT_ASSERT_EQUAL(copied.Push(value), loaded.Push(value));
+        }
+        for (size_t i = 0; i < liveHts.size(); i += 3) {
+            CPPUNIT_ASSERT(loaded.Update(liveHts[i], i) != Queue::INVALID_HANDLE);
+            copied.Update(liveHts[i], i);
+        }
+        CPPUNIT_ASSERT(loaded.IsHeap());
+        while (!copied.IsEmpty()) {
+            CPPUNIT_ASSERT_EQUAL(copied.TopElem(), loaded.TopElem());
+            CPPUNIT_ASSERT_EQUAL(copied.Pop(), loaded.Pop());
+        }
+        CPPUNIT_ASSERT(loaded.IsEmpty());
+    }
+
+    /// copy-on-write changes are not written back
+    Queue reloaded;
+    CPPUNIT_ASSERT(reloaded.LoadSnapshot(path, IndexedPQSnapshotMode::MMAP_READ_ONLY));
+    CPPUNIT_ASSERT_EQUAL(pq.GetCount(), reloaded.GetCount());
+    CPPUNIT_ASSERT_EQUAL(pq.TopElem(), reloaded.TopElem());
+    ::unlink(path.c_str());
+}
+
+void IndexedPriorityQueueTest::SnapshotTest() {
+    InternalSnapshotTest<IndexedPQDefaultPolicy>(10000);
+    InternalSnapshotTest<InlineElemPolicy<4> >(10000);
+    InternalSnapshotTest<GenerationPolicy<8, uint32_t> >(10000);
+
+    /// snapshot of another layout or a missing file is rejected and the queue is untouched
+    std::string path = "indexedpq_snapshot_test.ipq";
+    IndexedPriorityQueue<uint64_t> pq;
+    pq.Push(10);
+    CPPUNIT_ASSERT(pq.SaveSnapshot(path));
+    IndexedPriorityQueue<uint32_t> otherPq;
+    otherPq.Push(20);
+    CPPUNIT_ASSERT(!otherPq.LoadSnapshot(path));
+    IndexedPriorityQueue<uint64_t, std::less<uint64_t>, IndexedPQArityPolicy<4> > otherArityPq;
+    CPPUNIT_ASSERT(!otherArityPq.LoadSnapshot(path));
+    IndexedPriorityQueue<uint64_t, std::greater<uint64_t> > otherComparePq;
+    CPPUNIT_ASSERT(!otherComparePq.LoadSnapshot(path));
+    /// heap direction of IndexedPQComparator is its state
+    IndexedPriorityQueue<uint64_t, IndexedPQComparator<uint64_t> > maxPq(32, 32, false, IndexedPQComparator<uint64_t>(true));
+    maxPq.Push(10);
+    CPPUNIT_ASSERT(maxPq.SaveSnapshot(path));
+    IndexedPriorityQueue<uint64_t, IndexedPQComparator<uint64_t> > minPq(32, 32, false, IndexedPQComparator<uint64_t>(false));
+    CPPUNIT_ASSERT(!minPq.LoadSnapshot(path));
+    IndexedPriorityQueue<uint64_t, IndexedPQComparator<uint64_t> > otherMaxPq(32, 32, false, IndexedPQComparator<uint64_t>(true));
+    CPPUNIT_ASSERT(otherMaxPq.LoadSnapshot(path));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)10, otherMaxPq.TopElem());
+    CPPUNIT_ASSERT_EQUAL((uint32_t)20, otherPq.TopElem());
+    ::unlink(path.c_str());
+    CPPUNIT_ASSERT(!pq.LoadSnapshot(path));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)10, pq.TopElem());
+
+    /// restart cost of building versus loading snapshot
+    size_t count = 1e6;
+    vector<uint64_t> values;
+    for (size_t i = 0; i < count; ++i) {
+        values.push_back(RandomUtil<int64_t>::RandomInt64(0,1e12));
+    }
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    IndexedPriorityQueue<uint64_t> bigPq(count);
+    for (size_t i = 0; i < count; ++i) {
+        bigPq.Push(values[i]);
+    }
+    int64_t tPush = TimeUtil::CurrentTimeInMicroSeconds();
+    CPPUNIT_ASSERT(bigPq.SaveSnapshot(path));
+    int64_t tSave = TimeUtil::CurrentTimeInMicroSeconds();
+    IndexedPriorityQueue<uint64_t> mappedPq;
+    CPPUNIT_ASSERT(mappedPq.LoadSnapshot(path, IndexedPQSnapshotMode::MMAP_COPY_ON_WRITE));
+    int64_t tMap = TimeUtil::CurrentTimeInMicroSeconds();
+    IndexedPriorityQueue<uint64_t> copiedPq;
+    CPPUNIT_ASSERT(copiedPq.LoadSnapshot(path, IndexedPQSnapshotMode::COPY));
+    int64_t tCopy = TimeUtil::CurrentTimeInMicroSeconds();
+    CPPUNIT_ASSERT_EQUAL(bigPq.TopElem(), mappedPq.TopElem());
+    CPPUNIT_ASSERT_EQUAL(bigPq.TopElem(), copiedPq.TopElem());
+    ::unlink(path.c_str());
+    cout << endl << "-------------count:[" << count << "],push one by one:[" << (tPush - tBegin) / 1000 << "]ms,save:["
+         << (tSave - tPush) / 1000 << "]ms,mmap load:[" << (tMap - tSave) << "]us,copy load:[" << (tCopy - tMap) / 1000
+         << "]ms." << endl;
+}
+
+template<class Policy>
+void IndexedPriorityQueueTest::InternalMergeTest(size_t count, size_t otherCount) {
+    typedef IndexedPriorityQueue<uint64_t, std::less<uint64_t>, Policy > Queue;
+    typedef typename Queue::HANDLE_TYPE HANDLE_TYPE;
+    /// other has holes of removed elements, whose slots must be remapped to INVALID_HANDLE
+    Queue pq(4), other(4);
+    vector<HANDLE_TYPE> hts, otherHts;
+    for (size_t i = 0; i < count; ++i) {
+        hts.push_back(pq.Push(RandomUtil<int64_t>::RandomInt64(0, 1e6)));
+    }
+    for (size_t i = 0; i < otherCount; ++i) {
+        otherHts.push_back(other.Push(RandomUtil<int64_t>::RandomInt64(0, 1e6)));
+    }
+    vector<uint64_t> values;
+    for (size_t i = 0; i < count; ++i) { values.push_back(pq.Elem(hts[i])); }
+    for (size_t i = 0; i < otherCount; i += 3) {
+        CPPUNIT_ASSERT(other.Remove(otherHts[i]));
+    }
+    vector<HANDLE_TYPE> remap;
+    size_t otherLeftCount = other.GetCount();
+    CPPUNIT_ASSERT_EQUAL(otherLeftCount, pq.Merge(other, &remap));
+    CPPUNIT_ASSERT_EQUAL(count + otherLeftCount, pq.GetCount());
+    CPPUNIT_ASSERT(pq.IsHeap());
+    CPPUNIT_ASSERT_EQUAL(otherLeftCount, other.GetCount());
+    for (size_t i = 0; i < count; ++i) {
+        CPPUNIT_ASSERT_EQUAL(values[i], pq.Elem(hts[i]));
+    }
+    for (size_t i = 0; i < otherCount; ++i) {
+        HANDLE_TYPE newHt = remap[otherHts[i] & Queue::SLOT_MASK];
+        if (i % 3 == 0) {
+            CPPUNIT_ASSERT_EQUAL(Queue::INVALID_HANDLE, newHt);
+        }
+        else {
+            CPPUNIT_ASSERT(pq.Contains(newHt));
+            CPPUNIT_ASSERT_EQUAL(other.Elem(otherHts[i]), pq.Elem(newHt));
+        }
+    }
+
+    /// fixed queue keeps the best of both, the top is the worst kept one
+    size_t topN = std::max<size_t>(count / 2, 1);
+    Queue fixedPq(topN, 32, true), fixedOther(topN, 32, true);
+    vector<uint64_t> allValues;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t value = RandomUtil<int64_t>::RandomInt64(0, 1e6);
+        allValues.push_back(value);
+        fixedPq.Push(value);
+    }
+    vector<uint64_t> otherValues;
+    for (size_t i = 0; i < otherCount; ++i) {
+        uint64_t value = RandomUtil<int64_t>::RandomInt64(0, 1e6);
+        otherValues.push_back(value);
+        fixedOther.Push(value);
+    }
+    std::sort(otherValues.begin(), otherValues.end());
+    otherValues.resize(std::min(topN, otherCount));
+    allValues.insert(allValues.end(), otherValues.begin(), otherValues.end());
+    std::sort(allValues.begin(), allValues.end());
+    allValues.resize(std::min(topN, allValues.size()));
+    vector<HANDLE_TYPE> fixedOtherHts(fixedOther.GetElementsArray(), fixedOther.GetElementsArray() + fixedOther.GetCount());
+    vector<uint64_t> fixedOtherValues;
+    for (HANDLE_TYPE ht : fixedOtherHts) { fixedOtherValues.push_back(fixedOther.Elem(ht)); }
+    size_t mergedCount = fixedPq.Merge(std::move(fixedOther), &remap);
+    CPPUNIT_ASSERT(fixedOther.IsEmpty());
+    CPPUNIT_ASSERT(fixedPq.IsHeap());
+    CPPUNIT_ASSERT_EQUAL(allValues.size(), fixedPq.GetCount());
+    vector<uint64_t> keptValues;
+    for (size_t i = 0; i < fixedPq.GetCount(); ++i) { keptValues.push_back(fixedPq.ElemAtHeap(i)); }
+    std::sort(keptValues.begin(), keptValues.end());
+    CPPUNIT_ASSERT(allValues == keptValues);
+    size_t remappedCount = 0;
+    for (size_t i = 0; i < fixedOtherHts.size(); ++i) {
+        HANDLE_TYPE newHt = remap[fixedOtherHts[i] & Queue::SLOT_MASK];
+        if (newHt != Queue::INVALID_HANDLE) {
+            ++remappedCount;
+            CPPUNIT_ASSERT_EQUAL(fixedOtherValues[i], fixedPq.Elem(newHt));
+        }
+    }
+    CPPUNIT_ASSERT_EQUAL(mergedCount, remappedCount);
+}
+
+void IndexedPriorityQueueTest::MergeTest() {
+    InternalMergeTest<IndexedPQDefaultPolicy>(1000, 300);
+    InternalMergeTest<IndexedPQDefaultPolicy>(10, 3000);
+    InternalMergeTest<IndexedPQDefaultPolicy>(0, 100);
+    InternalMergeTest<IndexedPQDefaultPolicy>(100, 0);
+    InternalMergeTest<InlineElemPolicy<4> >(1000, 1000);
+    InternalMergeTest<GenerationPolicy<8, uint32_t> >(1000, 1000);
+
+    /// fixed queue in a batch of caller stays in the batch
+    IndexedPriorityQueue<uint64_t> pq(4, 32, true), other(4, 32, true);
+    pq.BeginBatch();
+    pq.Push(50);
+    pq.Push(40);
+    for (uint64_t value : {30, 60, 10, 20}) { other.Push(value); }
+    CPPUNIT_ASSERT_EQUAL((size_t)3, pq.Merge(other));
+    CPPUNIT_ASSERT(pq.IsInBatch());
+    pq.CommitBatch();
+    CPPUNIT_ASSERT_EQUAL((uint64_t)40, pq.TopElem());
+
+    /// merging shards by bulk append and heapify, against popping one and pushing into another
+    size_t count = 1e5, shardCount = 16;
+    vector<IndexedPriorityQueue<uint64_t> > shards(shardCount);
+    for (size_t i = 0; i < count; ++i) {
+        shards[i % shardCount].Push(RandomUtil<int64_t>::RandomInt64(0, 1e12));
+    }
+    IndexedPriorityQueue<uint64_t> pushPq, mergePq;
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    for (size_t i = 0; i < shardCount; ++i) {
+        IndexedPriorityQueue<uint64_t>& shard = shards[i];
+        for (size_t j = 0; j < shard.GetCount(); ++j) {
+            pushPq.Push(shard.ElemAtHeap(j));
+        }
+    }
+    int64_t tPush = TimeUtil::CurrentTimeInMicroSeconds();
+    for (size_t i = 0; i < shardCount; ++i) {
+        mergePq.Merge(shards[i]);
+    }
+    int64_t tMerge = TimeUtil::CurrentTimeInMicroSeconds();
+    cout << "-------------count:[" << count << "],shardCount:[" << shardCount << "],push:["
+         << (tPush - tBegin) / 1000 << "]ms,merge:[" << (tMerge - tPush) / 1000 << "]ms." << endl;
+    CPPUNIT_ASSERT(mergePq.IsHeap());
+    CPPUNIT_ASSERT_EQUAL(pushPq.GetCount(), mergePq.GetCount());
+    CPPUNIT_ASSERT_EQUAL(pushPq.TopElem(), mergePq.TopElem());
+}
+
+template<class Policy>
+void IndexedPriorityQueueTest::InternalCompactTest(size_t count, size_t maxMoves) {
+    typedef IndexedPriorityQueue<uint64_t, std::less<uint64_t>, Policy > Queue;
+    typedef typename Queue::HANDLE_TYPE HANDLE_TYPE;
+    Queue pq(4);
+    map<HANDLE_TYPE, uint64_t> ht2Values;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t value = RandomUtil<int64_t>::RandomInt64(0, 1e6);
+        ht2Values[pq.Push(value)] = value;
+    }
+    /// leave holes by both *Pop* and *Remove*
+    for (size_t i = 0; i < count / 4; ++i) {
+        ht2Values.erase(pq.Pop());
+    }
+    vector<HANDLE_TYPE> hts;
+    for (auto& ht2Value : ht2Values) { hts.push_back(ht2Value.first); }
+    std::shuffle(hts.begin(), hts.end(), std::mt19937(count));
+    for (size_t i = 0; i < hts.size() / 2; ++i) {
+        CPPUNIT_ASSERT(pq.Remove(hts[i]));
+        ht2Values.erase(hts[i]);
+    }
+
+    auto onMove = [&ht2Values](HANDLE_TYPE oldHt, HANDLE_TYPE newHt) {
+        CPPUNIT_ASSERT(ht2Values.find(newHt) == ht2Values.end());
+        auto it = ht2Values.find(oldHt);
+        CPPUNIT_ASSERT(it != ht2Values.end());
+        ht2Values[newHt] = it->second;
+        ht2Values.erase(it);
+    };
+    /// the IndexedPQ is changed between steps of compaction
+    size_t steps = 0;
+    while (!pq.Compact(maxMoves, onMove)) {
+        ++steps;
+        if (steps % 2 == 0) {
+            uint64_t value = RandomUtil<int64_t>::RandomInt64(0, 1e6);
+            ht2Values[pq.Push(value)] = value;
+        }
+        else {
+            ht2Values.erase(pq.Pop());
+        }
+    }
+    CPPUNIT_ASSERT(pq.IsHeap());
+    CPPUNIT_ASSERT_EQUAL(ht2Values.size(), pq.GetCount());
+    for (auto& ht2Value : ht2Values) {
+        CPPUNIT_ASSERT((ht2Value.first & Queue::SLOT_MASK) < pq.GetCount());
+        CPPUNIT_ASSERT(pq.Contains(ht2Value.first));
+        CPPUNIT_ASSERT_EQUAL(ht2Value.second, pq.Elem(ht2Value.first));
+    }
+
+    pq.ShrinkToFit();
+    CPPUNIT_ASSERT_EQUAL(std::max<size_t>(pq.GetCount(), 1), pq.GetCapacity());
+    for (auto& ht2Value : ht2Values) {
+        CPPUNIT_ASSERT_EQUAL(ht2Value.second, pq.Elem(ht2Value.first));
+    }
+    /// the IndexedPQ works as before
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t value = RandomUtil<int64_t>::RandomInt64(0, 1e6);
+        HANDLE_TYPE ht = pq.Push(value);
+        CPPUNIT_ASSERT(ht2Values.find(ht) == ht2Values.end());
+        ht2Values[ht] = value;
+    }
+    CPPUNIT_ASSERT(pq.IsHeap());
+    while (!pq.IsEmpty()) {
+        uint64_t value = pq.TopElem();
+        HANDLE_TYPE ht = pq.Pop();
+        CPPUNIT_ASSERT_EQUAL(ht2Values[ht], value);
+        ht2Values.erase(ht);
+    }
+    CPPUNIT_ASSERT(ht2Values.empty());
+}
+
+void IndexedPriorityQueueTest::CompactTest() {
+    InternalCompactTest<IndexedPQDefaultPolicy>(10000, 7);
+    InternalCompactTest<IndexedPQDefaultPolicy>(10000, 100000);
+    InternalCompactTest<IndexedPQDefaultPolicy>(1, 1);
+    InternalCompactTest<InlineElemPolicy<4> >(10000, 50);
+    InternalCompactTest<GenerationPolicy<8, uint32_t> >(10000, 50);
+
+    /// growth factor
+    IndexedPriorityQueue<uint64_t> pq(10);
+    CPPUNIT_ASSERT_EQUAL(2.0, pq.GetGrowthFactor());
+    pq.SetGrowthFactor(1.5);
+    for (uint64_t i = 0; i < 11; ++i) { pq.Push(i); }
+    CPPUNIT_ASSERT_EQUAL((size_t)15, pq.GetCapacity());
+    pq.SetGrowthFactor(0.5);
+    CPPUNIT_ASSERT_EQUAL(IndexedPriorityQueue<uint64_t>::MIN_GROWTH_FACTOR, pq.GetGrowthFactor());
+
+    /// capacity of fixed IndexedPQ is kept
+    IndexedPriorityQueue<uint64_t> fixedPq(100, 32, true);
+    for (uint64_t i = 0; i < 10; ++i) { fixedPq.Push(i); }
+    fixedPq.Pop();
+    fixedPq.Compact([](size_t, size_t) {});
+    fixedPq.ShrinkToFit();
+    CPPUNIT_ASSERT_EQUAL((size_t)100, fixedPq.GetCapacity());
+    CPPUNIT_ASSERT_EQUAL((size_t)9, fixedPq.GetCount());
+
+    /// a long-lived queue after a peak of elements
+    size_t peakCount = 1e6, keepCount = 1e4;
+    IndexedPriorityQueue<uint64_t> peakPq;
+    vector<size_t> hts;
+    for (size_t i = 0; i < peakCount; ++i) {
+        hts.push_back(peakPq.Push(RandomUtil<int64_t>::RandomInt64(0, 1e12)));
+    }
+    std::shuffle(hts.begin(), hts.end(), std::mt19937(peakCount));
+    for (size_t i = keepCount; i < peakCount; ++i) {
+        peakPq.Remove(hts[i]);
+    }
+    size_t moveCount = 0;
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    peakPq.Compact([&moveCount](size_t, size_t) { ++moveCount; });
+    peakPq.ShrinkToFit();
+    int64_t tEnd = TimeUtil::CurrentTimeInMicroSeconds();
+    cout << "-------------peakCount:[" << peakCount << "],keepCount:[" << keepCount << "],moves:[" << moveCount
+         << "],compact and shrink:[" << (tEnd - tBegin) / 1000 << "]ms." << endl;
+    CPPUNIT_ASSERT(moveCount <= keepCount);
+    CPPUNIT_ASSERT_EQUAL(keepCount, peakPq.GetCapacity());
+    CPPUNIT_ASSERT(peakPq.IsHeap());
+}
@@ -5,6 +5,8 @@
 #include <cppunit/extensions/HelperMacros.h>
 #include <random>
 #include <functional>
+#include <string>
+#include <vector>
 #include <sys/time.h>
 
 template<typename T>
@@ -35,10 +37,64 @@ public:
     }
 };
 
+class FakeItem {
+public:
+    bool operator!=(const FakeItem & ref) {
+        return !(*this == ref);
+    }
+    bool operator==(const FakeItem & ref) {
+        if (this != &ref) {
+            return (m_id == ref.m_id ) && (m_score == ref.m_score) && (m_flag == ref.m_flag );
+        }
+        return true;
+    }
+
+    std::string ToString() {
+        char buf[64];
+        snprintf(buf,64,"%-20lu%-20lu%-20lu",m_score,m_id,m_flag);
+        return buf;
+    }
+public:
+    uint64_t   m_id;
+    uint64_t   m_score;
+    uint64_t   m_flag; ///used to remove duplicate
+};
+
+class FakeItemMgr {
+public:
+    static void sGenFlags(size_t count, vector<uint64_t >& flags );
+    static void sGenScores(size_t count, vector<uint64_t >& scores);
+    static void sGenItems(size_t itemCount,std::size_t flagCount, std::vector<FakeItem>& itemsVec);
+};
+
+class FakeItemComparator {
+public:
+    bool operator() (const FakeItem & lhs, const FakeItem & rhs) {
+        if (lhs.m_score != rhs.m_score) {
+            return lhs.m_score > rhs.m_score;
+        }
+        else return lhs.m_id < rhs.m_id;
+    }
+};
+
 class IndexedPriorityQueueTest : public CppUnit::TestFixture {
     CPPUNIT_TEST_SUITE(IndexedPriorityQueueTest);
     CPPUNIT_TEST(NormalTest);
     CPPUNIT_TEST(TopNRemoveDuplicateTest);
+    CPPUNIT_TEST(ArityTest);
+    CPPUNIT_TEST(InlineElemTest);
+    CPPUNIT_TEST(ArityPerformanceTest);
+    CPPUNIT_TEST(BuildTest);
+    CPPUNIT_TEST(BatchTest);
+    CPPUNIT_TEST(AllocatorTest);
+    CPPUNIT_TEST(MoveSemanticsTest);
+    CPPUNIT_TEST(HandleTypeTest);
+    CPPUNIT_TEST(ExtractTopKTest);
+    CPPUNIT_TEST(RemoveTest);
+    CPPUNIT_TEST(StatsTest);
+    CPPUNIT_TEST(SnapshotTest);
+    CPPUNIT_TEST(MergeTest);
+    CPPUNIT_TEST(CompactTest);
     CPPUNIT_TEST_SUITE_END();
 public:
     IndexedPriorityQueueTest() {}
@@ -49,9 +105,41 @@ public:
 
     void NormalTest();
     void TopNRemoveDuplicateTest();
+    void ArityTest();
+    void InlineElemTest();
+    void ArityPerformanceTest();
+    void BuildTest();
+    void BatchTest();
+    void AllocatorTest();
+    void MoveSemanticsTest();
+    void HandleTypeTest();
+    void ExtractTopKTest();
+    void RemoveTest();
+    void StatsTest();
+    void SnapshotTest();
+    void MergeTest();
+    void CompactTest();
 
 private:
     void InternalTopNRemoveDuplicateTest(std::ostream& os, size_t docCount , size_t fingerCount , size_t topN, size_t runTimes);
+    template<class Policy>
+    void InternalPolicyTest(size_t count);
+    template<class Policy>
+    void InternalPolicyPerformanceTest(std::ostream& os, size_t count);
+    template<class Policy>
+    void InternalBuildTest(size_t count);
+    template<class Policy>
+    void InternalBatchTest(size_t count, size_t batchSize);
+    template<class Policy>
+    void InternalExtractTopKTest(size_t count);
+    template<class Policy>
+    void InternalRemoveTest(size_t opCount);
+    template<class Policy>
+    void InternalSnapshotTest(size_t count);
+    template<class Policy>
+    void InternalMergeTest(size_t count, size_t otherCount);
+    template<class Policy>
+    void InternalCompactTest(size_t count, size_t maxMoves);
 };
 
 
@@ -1,10 +1,20 @@
 #ifndef __INDEXEDPQ_INDEXED_PRIORITY_QUEUE_H__
 #define __INDEXEDPQ_INDEXED_PRIORITY_QUEUE_H__
 
+#include <algorithm>
 #include <cassert>
 #include <functional>
 #include <string>
 #include <cstring>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+#include "indexedpq/indexed-pq-memory.h"
+#include "indexedpq/indexed-pq-simd.h"
+#include "indexedpq/indexed-pq-snapshot.h"
+#include "indexedpq/indexed-pq-stats.h"
 
 using namespace std;
 
@@ -21,10 +31,88 @@ public:
     IndexedPQComparator(bool isMaxHeap ) { m_isMaxHeap = isMaxHeap; }
 public:
     bool operator()(const T&a, const T&b) { return m_isMaxHeap ? ( a < b) : (a > b); }
+    bool IsMaxHeap() const { return m_isMaxHeap; }
 private:
     bool m_isMaxHeap;
 };
 
+/// identity of comparator written in snapshots, so a snapshot is rejected by a queue ordering elements another way.
+/// It is the hash of comparator type name by default, overload it for comparators whose order depends on their state.
+template<class CompareFunc>
+inline uint64_t IndexedPQCompareId(const CompareFunc&) {
+    return IndexedPQSnapshotHeader::HashName(typeid(CompareFunc).name());
+}
+/// MaxTop and MinTop IndexedPQComparator are of the same type
+template<class T>
+inline uint64_t IndexedPQCompareId(const IndexedPQComparator<T>& compareFunc) {
+    return IndexedPQSnapshotHeader::HashName(typeid(IndexedPQComparator<T>).name()) ^ (compareFunc.IsMaxHeap() ? 1 : 2);
+}
+
+
+/// engine behind the handle API, see IndexedPQEngineSelector in indexed-pq-engine.h
+enum class IndexedPQEngine {
+    DARY_HEAP,          /// IndexedPriorityQueue, array based d-ary heap
+    PAIRING_HEAP,       /// IndexedPairingHeap, O(1) amortized update towards the top
+    RADIX_HEAP,         /// IndexedRadixHeap, monotone MinTop heap of unsigned integer keys
+};
+
+/**
+ *@brief     default policy of IndexedPriorityQueue, which decides the heap layout. To customize it, derive from it and
+ *           hide the members to be changed, e.g. struct MyPolicy : public IndexedPQDefaultPolicy { static constexpr size_t ARITY = 4; };
+ */
+struct IndexedPQDefaultPolicy {
+    /// children count of every heap node, 2 means the classical binary heap. Children of one node are stored
+    /// contiguously and the group is aligned to cache line, so 4 or 8 makes one sift level touch only one cache line.
+    static constexpr size_t ARITY = 2;
+    /// whether to keep a copy of every element inline in heap order, beside the handles array. Sift loops then compare
+    /// elements in one contiguous array without indirection through handles, only for small trivially copyable types.
+    static constexpr bool INLINE_ELEM = false;
+    /// whether to select the best child of a full children group with vector kernels, only takes effect when
+    /// *INLINE_ELEM* is true, element is uint32_t/uint64_t/float/double and comparator is std::less, std::greater or
+    /// IndexedPQComparator. It pays off for wide groups of 32 bits elements(ARITY 8 or 16), but the scalar loop is
+    /// usually faster for small groups of 64 bits elements, so it is off by default.
+    static constexpr bool SIMD_CHILD_SELECT = false;
+    /// byte allocator of all arrays, std::pmr::polymorphic_allocator<char> makes queues live in a memory resource such
+    /// as a per-request std::pmr::monotonic_buffer_resource. It is passed by constructor if it is stateful.
+    typedef std::allocator<char> ALLOCATOR_TYPE;
+    /// arrays not smaller than this bytes are aligned to huge page and advised to use transparent huge pages.
+    static constexpr size_t HUGE_PAGE_THRESHOLD = 32 * 1024 * 1024;
+    /// unsigned integer type of handles and heap indexes, uint32_t halves the index memory of size_t, and uint16_t
+    /// suits tiny TopN. Elements count is limited to max value of the type, which is reserved as the invalid handle.
+    typedef size_t HANDLE_TYPE;
+    /// high bits of handle used as generation of its slot, which is bumped when handle is recycled by *Pop* or
+    /// *Remove*, so *Contains*, *Update* and *Remove* detect stale handles. 0 disables generations.
+    static constexpr size_t GENERATION_BITS = 0;
+    /// engine chosen by IndexedPQEngineSelector, IndexedPriorityQueue itself ignores it.
+    static constexpr IndexedPQEngine ENGINE = IndexedPQEngine::DARY_HEAP;
+    /// operation counters read by *GetStats*, IndexedPQNoStats compiles all hooks out and IndexedPQCountingStats
+    /// counts pushes, rejections, replacements, updates, comparator calls, growths and sift depths.
+    typedef IndexedPQNoStats STATS_TYPE;
+};
+
+/// convenient policy used to only change the arity of heap
+template<size_t Arity>
+struct IndexedPQArityPolicy : public IndexedPQDefaultPolicy {
+    static constexpr size_t ARITY = Arity;
+};
+
+/// convenient policy used to only change the handle type
+template<class Handle>
+struct IndexedPQHandlePolicy : public IndexedPQDefaultPolicy {
+    typedef Handle HANDLE_TYPE;
+};
+
+/// convenient policy used to only enable counting stats
+struct IndexedPQStatsPolicy : public IndexedPQDefaultPolicy {
+    typedef IndexedPQCountingStats STATS_TYPE;
+};
+
+/// convenient policy used to only change the engine
+template<IndexedPQEngine Engine>
+struct IndexedPQEnginePolicy : public IndexedPQDefaultPolicy {
+    static constexpr IndexedPQEngine ENGINE = Engine;
+};
+
 
 /**
  *@brief     Class defined for mutable indexed priority queue which support Specifial *update* operation to change the element
@@ -32,53 +120,161 @@ private:
  *@author    dingbinthu@163.com
  *@date      12/21/20, 20:51 PM
  */
-template <class T, class CompareFunc = std::less<T> >
+template <class T, class CompareFunc = std::less<T>, class Policy = IndexedPQDefaultPolicy >
 class IndexedPriorityQueue
 {
 public:
     typedef T             VALUE_TYPE;           /// element type which stored in the IndexedPQ
     typedef CompareFunc   VALUE_COMPARE;        /// element compare method
-    typedef size_t        HANDLE_TYPE;          /// index type for the elements in the IndexedPQ elements array.
+    typedef Policy        POLICY_TYPE;          /// heap layout policy
+    typedef typename Policy::ALLOCATOR_TYPE ALLOCATOR_TYPE;   /// allocator of all arrays
+    typedef typename Policy::HANDLE_TYPE HANDLE_TYPE;   /// index type for the elements in the IndexedPQ elements array.
+    typedef typename Policy::STATS_TYPE STATS_TYPE;     /// operation counters
+
+    /// returned by *Push* and *Update* if no element is pushed or updated, equal to string::npos for size_t handle.
+    static constexpr HANDLE_TYPE INVALID_HANDLE = HANDLE_TYPE(-1);
+    static constexpr size_t GENERATION_BITS = Policy::GENERATION_BITS;      /// generation bits of handle
+    static constexpr size_t SLOT_BITS = sizeof(HANDLE_TYPE) * 8 - GENERATION_BITS; /// slot bits of handle
+    static constexpr HANDLE_TYPE SLOT_MASK = HANDLE_TYPE(-1) >> GENERATION_BITS;    /// slot of handle is *ht & SLOT_MASK*
+    /// max elements count, limited by slot bits of handle type
+    static constexpr size_t MAX_COUNT = SLOT_MASK;
+
+    static constexpr size_t ARITY = Policy::ARITY;               /// children count of every heap node
+    static constexpr double DEFAULT_GROWTH_FACTOR = 2.0;         /// arrays are doubled when full by default
+    static constexpr double MIN_GROWTH_FACTOR = 1.125;           /// lower bound of *SetGrowthFactor*
+    static constexpr size_t CACHE_LINE_SIZE = 64;                /// alignment of heap array
+    static constexpr size_t HEAP_ARRAY_PADDING = ARITY - 1;      /// preserved slots ahead of heap array to align children groups
+    static constexpr bool   INLINE_ELEM = Policy::INLINE_ELEM;   /// whether elements copies are kept inline in heap order
+    static constexpr bool   SIMD_CHILD_SELECT = Policy::SIMD_CHILD_SELECT && INLINE_ELEM   /// whether vector kernels are used
+                                            && IndexedPQCompareTraits<T, CompareFunc>::IS_KNOWN
+                                            && IndexedPQSimd::IsSupported<T, ARITY>();
+    static_assert(ARITY >= 2, "arity of IndexedPriorityQueue must not be less than 2");
+    static_assert(std::is_integral<HANDLE_TYPE>::value && std::is_unsigned<HANDLE_TYPE>::value, "handle type must be unsigned integer");
+    static_assert(sizeof(HANDLE_TYPE) <= sizeof(size_t), "handle type must not be wider than size_t");
+    static_assert(GENERATION_BITS < sizeof(HANDLE_TYPE) * 8, "generation bits must leave slot bits");
+    static_assert(!INLINE_ELEM || std::is_trivially_copyable<T>::value, "inline elements must be trivially copyable");
 
 
 public:
     IndexedPriorityQueue(size_t nSize                = 32,
                          size_t nPoppedSizeHint      = 32,
                          bool isFixed                = false,
-                         VALUE_COMPARE compareFunc   = VALUE_COMPARE() );
+                         VALUE_COMPARE compareFunc   = VALUE_COMPARE(),
+                         const ALLOCATOR_TYPE& allocator = ALLOCATOR_TYPE() );
+    /// build from elements in [first,last) with *Build* method, handle of the i-th element is i.
+    template<class ForwardIt, class = typename std::iterator_traits<ForwardIt>::iterator_category>
+    IndexedPriorityQueue(ForwardIt first, ForwardIt last, VALUE_COMPARE compareFunc = VALUE_COMPARE(),
+                         const ALLOCATOR_TYPE& allocator = ALLOCATOR_TYPE())
+        : IndexedPriorityQueue(std::distance(first, last), 32, false, compareFunc, allocator) { Build(first, last); }
     ~IndexedPriorityQueue();
 
     inline size_t      GetCount() { return m_elemCnt; }
+    /// allocator of all arrays
+    inline ALLOCATOR_TYPE GetAllocator() const { return ALLOCATOR_TYPE(m_memory.GetAllocator()); }
     inline bool        IsEmpty() { return m_elemCnt == 0; }
+    /// preserved space size, also the bound of fixed IndexedPQ
+    inline size_t      GetCapacity() { return m_Size; }
+    /// factor by which arrays grow when full, not less than *MIN_GROWTH_FACTOR*. A smaller one wastes less memory of
+    /// large queues and copies arrays more often.
+    inline double      GetGrowthFactor() { return m_growthFactor; }
+    inline void        SetGrowthFactor(double growthFactor) { m_growthFactor = std::max(growthFactor, MIN_GROWTH_FACTOR); }
+    /// snapshot of operation counters since construction or *ResetStats*, all zero unless *STATS_TYPE* counts.
+    /// *Reset* keeps the counters.
+    inline IndexedPQStatsSnapshot GetStats() const { IndexedPQStatsSnapshot snapshot; m_stats.GetSnapshot(snapshot); return snapshot; }
+    inline void        ResetStats() { m_stats.Reset(); }
 
     /// whether IndexPQ is full
     inline bool IsFull() { return m_isFixed && (m_elemCnt == m_Size); }
     /// whether current handle type is valid
-    inline bool IsValid(HANDLE_TYPE ht) { return ht < m_elemCnt; }
+    inline bool IsValid(HANDLE_TYPE ht) { return ht != INVALID_HANDLE && Slot(ht) < m_elemCnt; }
     /// obtain factual element by specified handle-type,
     /// because often some elements were deleted, so here handle-type *ht* may be larger than m_elemCnt value.
-    inline const T& Elem(HANDLE_TYPE ht) { assert(ht < m_Size); return m_elemArr[ht]; }
+    inline const T& Elem(HANDLE_TYPE ht) { assert(Slot(ht) < m_elemConstructedCnt); return m_elemArr[Slot(ht)]; }
+    /// whether element of handle *ht* is in the IndexedPQ. Handles recycled by *Pop* or *Remove* are detected only if
+    /// *GENERATION_BITS* is not 0, before the generation wraps around. *Reset* and *Build* restart generations.
+    inline bool Contains(HANDLE_TYPE ht) {
+        size_t slot = Slot(ht);
+        if (ht == INVALID_HANDLE || slot >= m_elemConstructedCnt) {
+            return false;
+        }
+        size_t nIndex = m_elemIndex2HeapIndexArr[slot];
+        return nIndex < m_elemCnt && m_heapArr[nIndex] == ht;
+    }
 
     /// return factual element value from its heap index, which in [0,m_elemCnt)
     /// this interface will often be used to iterator all elements in the IndexedPQ unsorted.
-    inline const T& ElemAtHeap(size_t index) { assert(index < m_elemCnt); return m_elemArr[m_heapArr[index] ]; }
+    inline const T& ElemAtHeap(size_t index) { assert(index < m_elemCnt); return HeapElem(index); }
     /// used to iterator all elements in the IndexedPq unsorted with *ElemAtHeap* method
     inline HANDLE_TYPE* GetElementsArray() { return m_heapArr; }
 
 
     /// whether is not need push current new element when seek fixed topN elements.
     inline bool IsNotNeedPushWhenSeekFixedTopN(const T & elem) {
-        return m_isFixed && m_elemCnt == m_Size && m_valueCmpFunc(m_elemArr[m_heapArr[0] ], elem);  }
+        bool isNotNeed = m_isFixed && m_elemCnt == m_Size && Compare(HeapElem(0), elem);
+        if (isNotNeed) { m_stats.OnReject(); }
+        return isNotNeed;
+    }
 
     /// return value of top element
-    inline const T& TopElem() { assert(m_elemCnt > 0); return m_elemArr[m_heapArr[0] ]; }
+    inline const T& TopElem() { assert(m_elemCnt > 0 && !IsHeapPending()); return HeapElem(0); }
 
     /// return ht of top element
-    inline HANDLE_TYPE Top() { assert(m_elemCnt > 0); return m_heapArr[0]; }
+    inline HANDLE_TYPE Top() { assert(m_elemCnt > 0 && !IsHeapPending()); return m_heapArr[0]; }
 
     /// Reset status of IndexedPQ
-    void  Reset() { m_poppedHandleTypeElemCount = 0; m_elemCnt = 0; }
+    void  Reset() { m_poppedHandleTypeElemCount = 0; m_elemCnt = 0; m_isInBatch = false; m_dirtyIndexElemCount = 0; }
 
+    /**
+     *@brief     reset the IndexedPQ and load elements in [first,last) with bottom-up heapify in O(N), instead of N times
+     *           *Push* in O(NlogN). Handle of the i-th element is i, so callers can fill their side maps in one pass.
+     *           If the IndexedPQ is fixed and there are more elements than its size, the first *m_Size* elements are
+     *           heapified and the rest are pushed one by one, which may replace handles of the previous ones.
+     *@param     first,last --- forward iterators range of elements.
+     */
+    template<class ForwardIt>
+    void Build(ForwardIt first, ForwardIt last);
+
+    /**
+     *@brief     begin a batch, in which *Push* and *Update* only store elements and record dirty heap positions without
+     *           sifting. Heap feature is restored by *CommitBatch*, so *Pop*, *Top*, *TopElem* and *ReplaceTopElem*
+     *           must not be called when *IsHeapPending*. *Push* to a full fixed IndexedPQ commits the pending changes
+     *           firstly, because it needs the top element.
+     */
+    void BeginBatch() { assert(!m_isInBatch); m_isInBatch = true; m_dirtyIndexElemCount = 0; m_isDirtyOverflow = false; }
+    /// restore heap feature and end the batch. Dirty positions and their ancestors are sifted down bottom-up if they are
+    /// few, otherwise the whole heap is rebuilt in O(N).
+    void CommitBatch() { assert(m_isInBatch); ApplyBatch(); m_isInBatch = false; }
+    /// whether in a batch
+    inline bool IsInBatch() { return m_isInBatch; }
+    /// whether heap feature is broken by changes in batch, which are not committed.
+    inline bool IsHeapPending() { return m_isInBatch && (m_dirtyIndexElemCount > 0 || m_isDirtyOverflow); }
+
+    /// push elements in [first,last) in one batch, handles are output to *pHts* in input order if it is not null.
+    template<class InputIt>
+    void PushBatch(InputIt first, InputIt last, HANDLE_TYPE* pHts = nullptr) {
+        BeginBatch();
+        for (; first != last; ++first) {
+            HANDLE_TYPE ht = Push(*first);
+            if (nullptr != pHts) { *pHts++ = ht; }
+        }
+        CommitBatch();
+    }
+    /// update elements of handles *pHts[0,count)* to *pNewElems[0,count)* in one batch.
+    void UpdateBatch(const HANDLE_TYPE* pHts, const T* pNewElems, size_t count) {
+        BeginBatch();
+        for (size_t i = 0; i < count; ++i) {
+            Update(pHts[i], pNewElems[i]);
+        }
+        CommitBatch();
+    }
+
+
+    /**
+     *@brief     remove element of handle *ht* from any heap position in O(logN), its handle is recycled as *Pop* does.
+     *@param     pRemovedElem --- removed element if it is not null.
+     *@return    false if *ht* is not in the IndexedPQ, see *Contains*.
+     */
+    bool Remove(HANDLE_TYPE ht, T* pRemovedElem = nullptr);
 
     /// pop element with no-recycle for removed element position in future
     void PopWithNoRecycle();
@@ -93,44 +289,244 @@ public:
      *@param     newElem --- new element will be updated into IndexedPriorityQueue.
      *@param     pRemovedElem --- element substituted if it is not null, which often used for resource release.
      *                            if no new element was replaced, it will be equal to *newElem*
-     *@return    handle type of newly pushed element. it will return string:npos if meets invalid case.
+     *@return    handle type of newly pushed element. it will return INVALID_HANDLE if meets invalid case.
      */
-    HANDLE_TYPE Update(HANDLE_TYPE ht, const T& newElem, T *pRemovedElem = nullptr );
+    HANDLE_TYPE Update(HANDLE_TYPE ht, const T& newElem, T *pRemovedElem = nullptr ) {
+        return UpdateElem(ht, newElem, pRemovedElem);
+    }
+    /// same as above, *newElem* is moved into IndexedPriorityQueue, and old element is moved to *pRemovedElem*.
+    HANDLE_TYPE Update(HANDLE_TYPE ht, T&& newElem, T *pRemovedElem = nullptr ) {
+        return UpdateElem(ht, std::move(newElem), pRemovedElem);
+    }
 
     /**
      *@brief
      *@param     elem --- new element to be pushed to IndexedPriorityQueue.
      *@param     pRemovedElem --- element to be replaced if it is not null, which often used for resource release.
      *                               if *elem* is not inserted into PQ factually, *pRemovedElem* will be equal to *elem*.
-     *@return    handle type for newly pushed element. It will return string::npos if factually no newly element pushed.
+     *@return    handle type for newly pushed element. It will return INVALID_HANDLE if factually no newly element pushed,
+     *           because the fixed IndexedPQ is full of better elements or *MAX_COUNT* is reached.
      */
-    HANDLE_TYPE Push(const T & elem, T * pRemovedElem = nullptr );
+    HANDLE_TYPE Push(const T & elem, T * pRemovedElem = nullptr ) { return PushElem(elem, pRemovedElem); }
+    /// same as above, *elem* is moved into IndexedPriorityQueue, and replaced element is moved to *pRemovedElem*.
+    HANDLE_TYPE Push(T && elem, T * pRemovedElem = nullptr ) { return PushElem(std::move(elem), pRemovedElem); }
+
+    /// construct element from *args* in place and push it. For a full fixed IndexedPQ, element is constructed
+    /// temporarily to be compared with the top one.
+    template<class... Args>
+    HANDLE_TYPE Emplace(Args&&... args);
 
 
     /// replace top element of the heap
-    HANDLE_TYPE ReplaceTopElem(const T & newElem) {
-            assert(m_elemCnt > 0);
-            m_elemArr[m_heapArr[0] ] = newElem;
-            return AdjustDownward(0);
-    }
+    HANDLE_TYPE ReplaceTopElem(const T & newElem) { return ReplaceTopElemImpl(newElem); }
+    HANDLE_TYPE ReplaceTopElem(T && newElem) { return ReplaceTopElemImpl(std::move(newElem)); }
 
-    /// sort the priority queue reversely
+    /// sort the priority queue reversely, handles are sorted in place by their elements, so heap feature is broken
+    /// until the IndexedPQ is rebuilt. Use *ExtractTopK* to keep the heap.
     HANDLE_TYPE* ReverseSort() {
-        size_t cnt = m_elemCnt;
-        while(m_elemCnt > 1) { PopWithNoRecycle(); }
-        m_elemCnt = cnt;
+        assert(!IsHeapPending());
+        std::sort(m_heapArr, m_heapArr + m_elemCnt, [this](HANDLE_TYPE a, HANDLE_TYPE b) {
+            return Compare(m_elemArr[Slot(a)], m_elemArr[Slot(b)]);
+        });
+        for (size_t i = 0; i < m_elemCnt; ++i) {
+            m_elemIndex2HeapIndexArr[Slot(m_heapArr[i])] = i;
+            if constexpr (INLINE_ELEM) { m_heapElemArr[i] = m_elemArr[Slot(m_heapArr[i])]; }
+        }
         return m_heapArr;
     }
 
+    /**
+     *@brief     output handles of the first *k* elements in *Pop* order without changing the IndexedPQ. The frontier of
+     *           enumerated heap positions is kept in an auxiliary heap, whose size is at most k*(ARITY-1)+1, so it
+     *           takes O(k*log(k)) instead of popping.
+     *@param     pHts --- output handles array, which has room of *k* handles at least.
+     *@return    count of output handles, min(k, GetCount()).
+     */
+    size_t ExtractTopK(size_t k, HANDLE_TYPE* pHts);
+
+    /**
+     *@brief     merge all elements of *other* into this IndexedPQ. Space is grown once, and if *other* is not smaller,
+     *           elements are appended in one batch and the heap is rebuilt bottom-up in O(N) instead of O(NlogN) sifts.
+     *           A fixed IndexedPQ keeps its bound: elements of *other* are offered best first, free slots are filled in
+     *           one batch, then they replace the top until the first rejection, after which no element can enter.
+     *           As *Push* does, an element replacing the top takes over the handle of the evicted element.
+     *@param     pRemap --- if not null, resized to the slots count of *other* and filled with the new handle of
+     *                      element of handle *ht* of *other* at index *ht & SLOT_MASK*, INVALID_HANDLE if it is not
+     *                      merged or not in *other*.
+     *@return    count of merged elements.
+     */
+    size_t Merge(const IndexedPriorityQueue& other, std::vector<HANDLE_TYPE>* pRemap = nullptr) {
+        return MergeFrom(other, pRemap);
+    }
+    /// same as above, elements are moved from *other*, which is reset afterwards.
+    size_t Merge(IndexedPriorityQueue&& other, std::vector<HANDLE_TYPE>* pRemap = nullptr) {
+        size_t mergedCnt = MergeFrom(other, pRemap);
+        other.Reset();
+        return mergedCnt;
+    }
+
+    /**
+     *@brief     renumber handles densely step by step, so that slots left by *Pop* and *Remove* can be released by
+     *           *ShrinkToFit*. Every step moves the element of the highest slot into a recycled slot below it, and
+     *           reports it by *onMove(oldHt, newHt)*, after which *oldHt* is invalid. Heap order is not changed, and the
+     *           IndexedPQ may be used between calls. Generations of released slots restart, as after *Reset*.
+     *           Slots of elements popped by *PopWithNoRecycle* are not recycled, so they are never filled.
+     *@param     maxMoves --- bound of moves of this call, which bounds the pause of a long-lived IndexedPQ.
+     *@return    whether handles are dense, i.e. slot of every handle is less than *GetCount()*.
+     */
+    template<class MoveCallback>
+    bool Compact(size_t maxMoves, MoveCallback&& onMove);
+    /// compact handles at once, see above
+    template<class MoveCallback>
+    void Compact(MoveCallback&& onMove) { Compact(MAX_COUNT, std::forward<MoveCallback>(onMove)); }
+
+    /**
+     *@brief     release memory beyond current elements. Arrays indexed by handle keep the highest slot in use, so
+     *           *Compact* firstly to release all slots left by *Pop* and *Remove*. Capacity of a fixed IndexedPQ is its
+     *           bound and is kept, only its popped handles and batch arrays shrink.
+     */
+    void ShrinkToFit();
+
+
+    /**
+     *@brief     save the queue to a versioned binary file at *path*, arrays are dumped as they are in memory, so only
+     *           trivially copyable elements are supported. File is written to *path*.tmp and renamed, so an existing
+     *           snapshot at *path* is replaced atomically.
+     *@return    false if the file can not be written.
+     */
+    bool SaveSnapshot(const std::string& path);
+    /**
+     *@brief     replace content of the queue by snapshot at *path* saved by a queue of the same type, without parsing
+     *           any element. Handles, generations and popped handles are restored, so handles kept by callers stay
+     *           valid. In mmap modes arrays are used in place of the mapping until they grow, and the mapping is
+     *           released by the next *LoadSnapshot* or destructor. A queue opened by *MMAP_READ_ONLY* must only be
+     *           read, any change faults, see *IsReadOnly*.
+     *@return    false and the queue is untouched, if the file can not be mapped or its header does not match.
+     */
+    bool LoadSnapshot(const std::string& path, IndexedPQSnapshotMode mode = IndexedPQSnapshotMode::MMAP_COPY_ON_WRITE);
+    /// whether arrays are a read only mapping of a snapshot
+    inline bool IsReadOnly() { return m_isReadOnly; }
 
     /// Check whether this data structure meets heap feature
     bool IsHeap();
 private:
+    /// parent heap index of *nIndex*, which must be larger than 0
+    static size_t ParentIndex(size_t nIndex) { return (nIndex - 1) / ARITY; }
+    /// first child heap index of *nIndex*, other children follow it contiguously
+    static size_t FirstChildIndex(size_t nIndex) { return nIndex * ARITY + 1; }
+    /// compare elements by *m_valueCmpFunc*, counted by stats
+    inline bool Compare(const T& a, const T& b) { m_stats.OnCompare(); return m_valueCmpFunc(a, b); }
+    /// element at heap index *nIndex*, read from inline copies if *INLINE_ELEM*
+    inline const T& HeapElem(size_t nIndex) {
+        if constexpr (INLINE_ELEM) { return m_heapElemArr[nIndex]; }
+        else { return m_elemArr[Slot(m_heapArr[nIndex])]; }
+    }
+
+    /// return heap index of the best child in [nFirst, nLast), which will be moved upwards firstly.
+    size_t SelectBestChild(size_t nFirst, size_t nLast) {
+        if constexpr (SIMD_CHILD_SELECT) {
+            if (nLast == nFirst + ARITY) {
+                bool isMaxHeap = IndexedPQCompareTraits<T, CompareFunc>::IsMaxHeap(m_valueCmpFunc);
+                m_stats.OnCompare(ARITY - 1);
+                return nFirst + IndexedPQSimd::SelectBest<T, ARITY>(m_heapElemArr + nFirst, isMaxHeap);
+            }
+        }
+        size_t nBest = nFirst;
+        for (size_t nChild = nFirst + 1; nChild < nLast; ++nChild) {
+            if (Compare(HeapElem(nBest), HeapElem(nChild))) {
+                nBest = nChild;
+            }
+        }
+        return nBest;
+    }
+
+    template<class U>
+    HANDLE_TYPE PushElem(U&& elem, T* pRemovedElem);
+    template<class U>
+    HANDLE_TYPE UpdateElem(HANDLE_TYPE ht, U&& newElem, T* pRemovedElem);
+    template<class U>
+    HANDLE_TYPE ReplaceTopElemImpl(U&& newElem) {
+        assert(m_elemCnt > 0 && !IsHeapPending());
+        m_stats.OnReplace();
+        m_elemArr[Slot(m_heapArr[0])] = std::forward<U>(newElem);
+        if constexpr (INLINE_ELEM) { m_heapElemArr[0] = m_elemArr[Slot(m_heapArr[0])]; }
+        return AdjustDownward(0);
+    }
+
+    /// merge elements of *other*, which are moved if it is not const
+    template<class Queue>
+    size_t MergeFrom(Queue& other, std::vector<HANDLE_TYPE>* pRemap);
+
+    /// slot of handle *ht* in elements array and handle to heap index array
+    static inline size_t Slot(HANDLE_TYPE ht) {
+        if constexpr (GENERATION_BITS > 0) { return ht & SLOT_MASK; }
+        else { return ht; }
+    }
+    /// recycle handle *ht* of removed element for reuse in future, with its generation bumped
+    void RecycleHandle(HANDLE_TYPE ht) {
+        if (m_poppedHandleTypeElemCount == m_poppedHandleTypeSize) {
+            m_poppedHandleTypeSize = ExtendArray(m_poppedHandleTypeArr,m_poppedHandleTypeSize);
+        }
+        if constexpr (GENERATION_BITS > 0) { ht = HANDLE_TYPE(ht + (HANDLE_TYPE(1) << SLOT_BITS)); }
+        m_poppedHandleTypeArr[m_poppedHandleTypeElemCount++] = ht;
+    }
+    /// handle for a new element, recycled from popped ones firstly. Popped handles of slots released by *Compact*
+    /// are dropped, all slots in use are below *m_elemCnt* if there is no other popped handle.
+    HANDLE_TYPE AcquireHandle() {
+        while (m_poppedHandleTypeElemCount > 0) {
+            HANDLE_TYPE ht = m_poppedHandleTypeArr[--m_poppedHandleTypeElemCount];
+            if (Slot(ht) < m_elemConstructedCnt) {
+                return ht;
+            }
+        }
+        return m_elemCnt;
+    }
+    /// whether *slot* keeps an element in the IndexedPQ
+    inline bool IsSlotInUse(size_t slot) {
+        size_t nIndex = m_elemIndex2HeapIndexArr[slot];
+        return nIndex < m_elemCnt && Slot(m_heapArr[nIndex]) == slot;
+    }
+    /// destroy constructed slots at the end which are not in use
+    void TrimSlots() {
+        while (m_elemConstructedCnt > m_elemCnt && !IsSlotInUse(m_elemConstructedCnt - 1)) {
+            m_elemArr[--m_elemConstructedCnt].~VALUE_TYPE();
+        }
+    }
+    /// store element to slot of handle *ht*. Slots are constructed lazily in handle order, a new handle is never
+    /// larger than the constructed count because handles are recycled before new ones are issued.
+    template<class U>
+    void StoreElem(HANDLE_TYPE ht, U&& elem) {
+        size_t slot = Slot(ht);
+        if (slot < m_elemConstructedCnt) {
+            m_elemArr[slot] = std::forward<U>(elem);
+        }
+        else {
+            assert(slot == m_elemConstructedCnt);
+            ::new ((void*)(m_elemArr + slot)) T(std::forward<U>(elem));
+            ++m_elemConstructedCnt;
+        }
+    }
+    /// link element stored in slot of handle *newHt* to the bottom of heap and sift it
+    HANDLE_TYPE LinkNewElem(HANDLE_TYPE newHt) {
+        if constexpr (INLINE_ELEM) { m_heapElemArr[m_elemCnt] = m_elemArr[Slot(newHt)]; }
+        m_elemIndex2HeapIndexArr[Slot(newHt)] = m_elemCnt;
+        m_heapArr[m_elemCnt] = newHt;
+        ++m_elemCnt;
+        if (m_isInBatch) {
+            AddDirtyIndex(m_elemCnt - 1);
+            return newHt;
+        }
+        return AdjustUpward(m_elemCnt - 1);
+    }
+
+    /// the element being sifted is kept by value if inline, because its heap slot will be overwritten while sifting.
+    typedef typename std::conditional<INLINE_ELEM, T, const T&>::type CUR_ELEM_TYPE;
+
     /// adjust upwards on the IndexedPriorityQueue, return the newly position index for current *nIndex* element
-    /// return std::string::npos if it meets invalid case
+    /// return INVALID_HANDLE if it meets invalid case
     HANDLE_TYPE  AdjustUpward(size_t nIndex);
     /// adjust downwards on the IndexedPriorityQueue, return the newly position index for current *nIndex* element
-    /// return std::string::npos if it meets invalid case
+    /// return INVALID_HANDLE if it meets invalid case
     HANDLE_TYPE  AdjustDownward(size_t nIndex);
 
     /// copy element in heap by their index in heap array.
@@ -138,7 +534,8 @@ private:
         if (from != to) {
             assert( from < m_elemCnt && to < m_elemCnt );
             m_heapArr[to] = m_heapArr[from];
-            m_elemIndex2HeapIndexArr[ m_heapArr[from] ] = to;
+            m_elemIndex2HeapIndexArr[ Slot(m_heapArr[from]) ] = to;
+            if constexpr (INLINE_ELEM) { m_heapElemArr[to] = m_heapElemArr[from]; }
         }
     }
 
@@ -147,80 +544,231 @@ private:
         if (i != j) {
             assert( i < m_elemCnt && j < m_elemCnt);
             HANDLE_TYPE iht = m_heapArr[i], jht = m_heapArr[j];
-            assert(m_elemIndex2HeapIndexArr[iht] == i);
-            assert(m_elemIndex2HeapIndexArr[jht] == j);
-            m_elemIndex2HeapIndexArr[iht] = j;
-            m_elemIndex2HeapIndexArr[jht] = i;
+            assert(m_elemIndex2HeapIndexArr[Slot(iht)] == i);
+            assert(m_elemIndex2HeapIndexArr[Slot(jht)] == j);
+            m_elemIndex2HeapIndexArr[Slot(iht)] = j;
+            m_elemIndex2HeapIndexArr[Slot(jht)] = i;
             std::swap(m_heapArr[i], m_heapArr[j]);
+            if constexpr (INLINE_ELEM) { std::swap(m_heapElemArr[i], m_heapElemArr[j]); }
         }
     }
 
 public:
+    /// extend array to *newArraySz*, which is grown by growth factor if it is 0. The array is truncated if
+    /// *newArraySz* is less than *arraySz*.
     template<class Type>
-    size_t ExtendArray(Type* & pArray, size_t arraySz) {
+    size_t ExtendArray(Type* & pArray, size_t arraySz, size_t newArraySz = 0) {
+        static_assert(std::is_trivially_copyable<Type>::value, "only arrays of trivially copyable type can be extended by memcpy");
         assert(nullptr != pArray && 0 != arraySz);
-        size_t newArraySz = arraySz * 2;
-        Type* pNewArray = new Type[newArraySz];
-        memcpy(pNewArray, pArray, arraySz * sizeof(Type));
-        delete [] pArray;
+        newArraySz = 0 == newArraySz ? std::max<size_t>(arraySz * m_growthFactor, arraySz + 1) : newArraySz;
+        Type* pNewArray = m_memory.template AllocArray<Type>(newArraySz);
+        m_stats.OnExtendArray(newArraySz * sizeof(Type));
+        memcpy(pNewArray, pArray, std::min(arraySz, newArraySz) * sizeof(Type));
+        m_memory.FreeArray(pArray, arraySz);
         pArray = pNewArray;
         return newArraySz;
     }
 private:
+    /// header of snapshot with type and layout fields of this queue, counts and offsets are not filled
+    IndexedPQSnapshotHeader MakeSnapshotHeader() {
+        IndexedPQSnapshotHeader header;
+        memset((void*)&header, 0, sizeof(header));
+        memcpy(header.m_magic, IndexedPQSnapshotHeader::MAGIC, sizeof(header.m_magic));
+        header.m_version = IndexedPQSnapshotHeader::VERSION;
+        header.m_byteOrderMark = IndexedPQSnapshotHeader::BYTE_ORDER_MARK;
+        header.m_elemSize = sizeof(T);
+        header.m_handleSize = sizeof(HANDLE_TYPE);
+        header.m_arity = ARITY;
+        header.m_generationBits = GENERATION_BITS;
+        header.m_isInlineElem = INLINE_ELEM;
+        header.m_compareId = IndexedPQCompareId(m_valueCmpFunc);
+        return header;
+    }
+    /// free elements, index, heap and popped handles arrays
+    void FreeArrays() {
+        if (nullptr != m_elemArr) { FreeElemArray(); m_elemArr = nullptr; }
+        if (nullptr != m_elemIndex2HeapIndexArr) { m_memory.FreeArray(m_elemIndex2HeapIndexArr, m_Size); m_elemIndex2HeapIndexArr = nullptr; }
+        if (nullptr != m_heapArr) { FreeHeapArray(m_heapArr, m_Size); m_heapArr = nullptr; }
+        if constexpr (INLINE_ELEM) { FreeHeapArray(m_heapElemArr, m_Size); m_heapElemArr = nullptr; }
+        if (nullptr != m_poppedHandleTypeArr) { m_memory.FreeArray(m_poppedHandleTypeArr, m_poppedHandleTypeSize);  m_poppedHandleTypeArr = nullptr;}
+    }
+    /// rebuild heap feature of all elements bottom-up
+    void Heapify() {
+        if (m_elemCnt > 1) {
+            for (size_t i = ParentIndex(m_elemCnt - 1) + 1; i > 0; --i) {
+                AdjustDownward(i - 1);
+            }
+        }
+    }
+    /// record heap position changed in batch, stop recording if there are too many ones to rebuild the whole heap
+    void AddDirtyIndex(size_t nIndex) {
+        if (m_isDirtyOverflow) {
+            return;
+        }
+        if (m_dirtyIndexElemCount >= m_elemCnt) {
+            m_isDirtyOverflow = true;
+            return;
+        }
+        if (m_dirtyIndexElemCount == m_dirtyIndexSize) {
+            m_dirtyIndexSize = ExtendArray(m_dirtyIndexArr, m_dirtyIndexSize);
+        }
+        m_dirtyIndexArr[m_dirtyIndexElemCount++] = nIndex;
+    }
+    /// restore heap feature of changes in batch
+    void ApplyBatch();
+    /// extend all arrays indexed by handle or heap index by growth factor, return false if *MAX_COUNT* is reached
+    bool Grow() {
+        if (m_Size >= MAX_COUNT) {
+            return false;
+        }
+        size_t newSize = (double)m_Size * m_growthFactor >= (double)MAX_COUNT
+                         ? MAX_COUNT : std::max<size_t>(m_Size * m_growthFactor, m_Size + 1);
+        m_stats.OnGrow();
+        ResizeArrays(newSize);
+        return true;
+    }
+    /// extend all arrays at once to hold *count* elements, clamped to *MAX_COUNT*, instead of *Grow* step by step
+    void GrowTo(size_t count) {
+        if (count <= m_Size || m_Size >= MAX_COUNT) {
+            return;
+        }
+        m_stats.OnGrow();
+        ResizeArrays(std::min<size_t>(count, MAX_COUNT));
+    }
+    /// reallocate all arrays indexed by handle or heap index to *newSize*, which keeps all constructed slots
+    void ResizeArrays(size_t newSize) {
+        assert(newSize >= m_elemConstructedCnt && newSize >= m_elemCnt);
+        ExtendElemArray(newSize);
+        ExtendArray(m_elemIndex2HeapIndexArr,m_Size,newSize);
+        ExtendHeapArray(m_heapArr,m_Size,newSize);
+        if constexpr (INLINE_ELEM) { ExtendHeapArray(m_heapElemArr,m_Size,newSize); }
+        m_Size = newSize;
+    }
+    /// allocate uninitialized elements array, slots are constructed by *StoreElem*
+    VALUE_TYPE* AllocElemArray(size_t arraySz) {
+        return static_cast<VALUE_TYPE*>(m_memory.Allocate(arraySz * sizeof(VALUE_TYPE), alignof(VALUE_TYPE)));
+    }
+    /// destroy constructed elements and free elements array
+    void FreeElemArray() {
+        for (size_t i = 0; i < m_elemConstructedCnt; ++i) {
+            m_elemArr[i].~VALUE_TYPE();
+        }
+        m_memory.Deallocate(m_elemArr);
+    }
+    /// extend elements array, constructed elements are relocated by memcpy if trivially copyable, otherwise moved
+    void ExtendElemArray(size_t newArraySz) {
+        VALUE_TYPE* pNewArray = AllocElemArray(newArraySz);
+        m_stats.OnExtendArray(newArraySz * sizeof(VALUE_TYPE));
+        if constexpr (std::is_trivially_copyable<VALUE_TYPE>::value) {
+            memcpy((void*)pNewArray, (const void*)m_elemArr, m_elemConstructedCnt * sizeof(VALUE_TYPE));
+        }
+        else {
+            for (size_t i = 0; i < m_elemConstructedCnt; ++i) {
+                ::new ((void*)(pNewArray + i)) VALUE_TYPE(std::move_if_noexcept(m_elemArr[i]));
+                m_elemArr[i].~VALUE_TYPE();
+            }
+        }
+        m_memory.Deallocate(m_elemArr);
+        m_elemArr = pNewArray;
+    }
+    /// allocate array in heap order with *HEAP_ARRAY_PADDING* slots ahead, so heap index *FirstChildIndex(i)* lies
+    /// at a physical offset multiple of *ARITY* from the cache line aligned base.
+    template<class Type>
+    Type* AllocHeapArray(size_t arraySz) {
+        return m_memory.template AllocArray<Type>(arraySz, CACHE_LINE_SIZE, HEAP_ARRAY_PADDING);
+    }
+    template<class Type>
+    void FreeHeapArray(Type* pArray, size_t arraySz) {
+        m_memory.FreeArray(pArray, arraySz, HEAP_ARRAY_PADDING);
+    }
+    template<class Type>
+    size_t ExtendHeapArray(Type* & pArray, size_t arraySz, size_t newArraySz) {
+        assert(nullptr != pArray && 0 != arraySz);
+        Type* pNewArray = AllocHeapArray<Type>(newArraySz);
+        m_stats.OnExtendArray(newArraySz * sizeof(Type));
+        memcpy(pNewArray, pArray, std::min(arraySz, newArraySz) * sizeof(Type));
+        FreeHeapArray(pArray, arraySz);
+        pArray = pNewArray;
+        return newArraySz;
+    }
+private:
+    IndexedPQMemory<ALLOCATOR_TYPE> m_memory;       /// allocates all arrays by *ALLOCATOR_TYPE*
     VALUE_TYPE*           m_elemArr;                /// elements array for factual elements
+    size_t                m_elemConstructedCnt;     /// slots [0, m_elemConstructedCnt) of m_elemArr are constructed
     HANDLE_TYPE*          m_heapArr;                /// indexes array for elements array which represents priority-queue/heap.
-    size_t*               m_elemIndex2HeapIndexArr;      /// use *m_elemArr* index to seek heap element index
+    VALUE_TYPE*           m_heapElemArr;            /// elements copies in heap order, only allocated if *INLINE_ELEM*
+    HANDLE_TYPE*          m_elemIndex2HeapIndexArr;      /// use *m_elemArr* index to seek heap element index
     bool                  m_isFixed;                /// size will not change if true.
+    bool                  m_isReadOnly;             /// arrays are a read only snapshot mapping
     size_t                m_Size;                   /// preserved space size, also used for the fixed size value when fixed-indexedPQ.
     size_t                m_elemCnt;                /// element count for the indexedPQ
+    double                m_growthFactor;           /// factor by which arrays grow when full
 
     VALUE_COMPARE         m_valueCmpFunc;           /// value compare method
+    [[no_unique_address]] STATS_TYPE m_stats;       /// operation counters, takes no space if empty
 
     HANDLE_TYPE *         m_poppedHandleTypeArr;       /// popped handle-types array for reused in feature.
     size_t                m_poppedHandleTypeSize;      /// preserved popped handle-type elements size.
     size_t                m_poppedHandleTypeElemCount; /// count of popped handle elements
+
+    bool                  m_isInBatch;                 /// whether sifting is deferred to *CommitBatch*
+    bool                  m_isDirtyOverflow;           /// too many dirty positions in batch, rebuild the whole heap
+    size_t*               m_dirtyIndexArr;             /// heap positions changed in batch
+    size_t                m_dirtyIndexSize;            /// preserved dirty positions size
+    size_t                m_dirtyIndexElemCount;       /// count of dirty positions
 };
 
-template <class T, class CompareFunc>
-IndexedPriorityQueue<T, CompareFunc>::
+template <class T, class CompareFunc, class Policy>
+IndexedPriorityQueue<T, CompareFunc, Policy>::
 IndexedPriorityQueue(size_t nSize                /* = 32    */,
                      size_t nPoppedSizeHint      /* = 32    */,
                      bool isFixed                /* = false */,
-                     VALUE_COMPARE compareFunc   /* = VALUE_COMPARE()*/ ) {
+                     VALUE_COMPARE compareFunc   /* = VALUE_COMPARE()*/,
+                     const ALLOCATOR_TYPE& allocator /* = ALLOCATOR_TYPE() */ )
+    : m_memory(allocator, Policy::HUGE_PAGE_THRESHOLD) {
 
-    nSize = std::max<size_t>(nSize,1);
+    nSize = std::min<size_t>(std::max<size_t>(nSize,1), MAX_COUNT);
     nPoppedSizeHint = std::max<size_t>(nPoppedSizeHint,1);
     assert(nSize >0); assert(nPoppedSizeHint >0);
 
-    m_elemArr = new VALUE_TYPE [nSize];
-    m_elemIndex2HeapIndexArr = new size_t [nSize];
-    m_heapArr = new HANDLE_TYPE [nSize];
-    m_poppedHandleTypeArr = new HANDLE_TYPE [nPoppedSizeHint];
+    m_elemArr = AllocElemArray(nSize);
+    m_elemConstructedCnt = 0;
+    m_elemIndex2HeapIndexArr = m_memory.template AllocArray<HANDLE_TYPE>(nSize);
+    m_heapArr = AllocHeapArray<HANDLE_TYPE>(nSize);
+    m_heapElemArr = nullptr;
+    if constexpr (INLINE_ELEM) { m_heapElemArr = AllocHeapArray<VALUE_TYPE>(nSize); }
+    m_poppedHandleTypeArr = m_memory.template AllocArray<HANDLE_TYPE>(nPoppedSizeHint);
+    m_dirtyIndexArr = m_memory.template AllocArray<size_t>(nPoppedSizeHint);
 
     m_Size = nSize;
     m_elemCnt = 0;
+    m_growthFactor = DEFAULT_GROWTH_FACTOR;
     m_poppedHandleTypeSize = nPoppedSizeHint;
     m_poppedHandleTypeElemCount = 0;
     m_isFixed = isFixed ;
+    m_isReadOnly = false;
+    m_isInBatch = false;
+    m_isDirtyOverflow = false;
+    m_dirtyIndexSize = nPoppedSizeHint;
+    m_dirtyIndexElemCount = 0;
     m_valueCmpFunc = compareFunc;
 }
 
-template <class T, class CompareFunc>
-IndexedPriorityQueue<T, CompareFunc>::~IndexedPriorityQueue()
+template <class T, class CompareFunc, class Policy>
+IndexedPriorityQueue<T, CompareFunc, Policy>::~IndexedPriorityQueue()
 {
-    if (nullptr != m_elemArr) { delete [] m_elemArr; m_elemArr = nullptr; }
-    if (nullptr != m_elemIndex2HeapIndexArr) { delete [] m_elemIndex2HeapIndexArr; m_elemIndex2HeapIndexArr = nullptr; }
-    if (nullptr != m_heapArr) { delete [] m_heapArr; m_heapArr = nullptr; }
-    if (nullptr != m_poppedHandleTypeArr) { delete []m_poppedHandleTypeArr;  m_poppedHandleTypeArr = nullptr;}
+    FreeArrays();
+    if (nullptr != m_dirtyIndexArr) { m_memory.FreeArray(m_dirtyIndexArr, m_dirtyIndexSize);  m_dirtyIndexArr = nullptr;}
     m_poppedHandleTypeSize = 0;
     m_elemCnt = 0;
 }
 
 
-template <class T, class CompareFunc>
-void IndexedPriorityQueue<T, CompareFunc>::PopWithNoRecycle()
+template <class T, class CompareFunc, class Policy>
+void IndexedPriorityQueue<T, CompareFunc, Policy>::PopWithNoRecycle()
 {
-    assert(m_elemCnt > 0);
+    assert(m_elemCnt > 0 && !IsHeapPending());
+    m_stats.OnPop();
     if (m_elemCnt == 0) {
         return;
     }
@@ -238,172 +786,538 @@ void IndexedPriorityQueue<T, CompareFunc>::PopWithNoRecycle()
 }
 
 
-template <class T, class CompareFunc>
-typename IndexedPriorityQueue<T, CompareFunc>::HANDLE_TYPE
-IndexedPriorityQueue<T, CompareFunc>::Pop()
+template <class T, class CompareFunc, class Policy>
+typename IndexedPriorityQueue<T, CompareFunc, Policy>::HANDLE_TYPE
+IndexedPriorityQueue<T, CompareFunc, Policy>::Pop()
 {
-    assert(m_elemCnt > 0);
+    assert(m_elemCnt > 0 && !IsHeapPending());
+    m_stats.OnPop();
     if (m_elemCnt == 0) {
-        return std::string::npos;
+        return INVALID_HANDLE;
     }
     else if (m_elemCnt == 1)
     {
         --m_elemCnt;
-        if (m_poppedHandleTypeElemCount == m_poppedHandleTypeSize) {
-            m_poppedHandleTypeSize = ExtendArray(m_poppedHandleTypeArr,m_poppedHandleTypeSize);
-        }
-        m_poppedHandleTypeArr[m_poppedHandleTypeElemCount++] = m_heapArr[0];
+        RecycleHandle(m_heapArr[0]);
         return m_heapArr[0];
     }
     else
     {
         SwapHeapElem(0,m_elemCnt-1);
-        if (m_poppedHandleTypeElemCount == m_poppedHandleTypeSize) {
-            m_poppedHandleTypeSize = ExtendArray(m_poppedHandleTypeArr,m_poppedHandleTypeSize);
-        }
-        m_poppedHandleTypeArr[m_poppedHandleTypeElemCount++] = m_heapArr[m_elemCnt-1];
+        RecycleHandle(m_heapArr[m_elemCnt-1]);
         --m_elemCnt;
         AdjustDownward(0);
         return m_heapArr[m_elemCnt];
     }
 }
 
-template <class T, class CompareFunc>
-typename IndexedPriorityQueue<T, CompareFunc>::HANDLE_TYPE
-IndexedPriorityQueue<T, CompareFunc>::Push(const T &elem, T * pRemovedElem /* == nullptr */) {
+template <class T, class CompareFunc, class Policy>
+bool IndexedPriorityQueue<T, CompareFunc, Policy>::Remove(HANDLE_TYPE ht, T* pRemovedElem /* = nullptr */)
+{
+    if (!Contains(ht)) {
+        return false;
+    }
+    m_stats.OnRemove();
+    size_t nIndex = m_elemIndex2HeapIndexArr[Slot(ht)];
+    if (nullptr != pRemovedElem) {
+        *pRemovedElem = std::move(m_elemArr[Slot(ht)]);
+    }
+    /// move the last element to the hole, which may go upwards or downwards
+    SwapHeapElem(nIndex, m_elemCnt - 1);
+    --m_elemCnt;
+    RecycleHandle(ht);
+    if (nIndex < m_elemCnt) {
+        if (m_isInBatch) {
+            AddDirtyIndex(nIndex);
+        }
+        else if (nIndex > 0 && Compare(HeapElem(ParentIndex(nIndex)), HeapElem(nIndex))) {
+            AdjustUpward(nIndex);
+        }
+        else {
+            AdjustDownward(nIndex);
+        }
+    }
+    return true;
+}
+
+template <class T, class CompareFunc, class Policy>
+template <class U>
+typename IndexedPriorityQueue<T, CompareFunc, Policy>::HANDLE_TYPE
+IndexedPriorityQueue<T, CompareFunc, Policy>::PushElem(U&& elem, T * pRemovedElem) {
+    m_stats.OnPush();
     if (m_elemCnt == m_Size) {
         if (m_isFixed) {
-            if (m_valueCmpFunc(elem, m_elemArr[m_heapArr[0] ])) {
+            if (m_isInBatch) {
+                ApplyBatch();
+            }
+            if (Compare(elem, HeapElem(0))) {
                 if (nullptr != pRemovedElem) {
-                    *pRemovedElem = TopElem();
+                    /// top element is overwritten at once, so it can be moved out
+                    *pRemovedElem = std::move(m_elemArr[Slot(m_heapArr[0])]);
                 }
-                return ReplaceTopElem(elem);
+                return ReplaceTopElemImpl(std::forward<U>(elem));
             }
             else {
                 if (nullptr != pRemovedElem) {
-                    *pRemovedElem = elem;
+                    *pRemovedElem = std::forward<U>(elem);
                 }
-                return std::string::npos;
+                m_stats.OnReject();
+                return INVALID_HANDLE;
             }
         }
-        else
+        else if (!Grow())
         {
-            size_t newSize = ExtendArray(m_elemArr,m_Size);
-            ExtendArray(m_elemIndex2HeapIndexArr,m_Size);
-            ExtendArray(m_heapArr,m_Size);
-            m_Size = newSize;
+            if (nullptr != pRemovedElem) {
+                *pRemovedElem = std::forward<U>(elem);
+            }
+            return INVALID_HANDLE;
         }
     }
 
-    HANDLE_TYPE  newHt;
-    if (m_poppedHandleTypeElemCount > 0) {
-        newHt = m_poppedHandleTypeArr[--m_poppedHandleTypeElemCount];
+    HANDLE_TYPE  newHt = AcquireHandle();
+    StoreElem(newHt, std::forward<U>(elem));
+    return LinkNewElem(newHt);
+}
+
+template <class T, class CompareFunc, class Policy>
+template <class... Args>
+typename IndexedPriorityQueue<T, CompareFunc, Policy>::HANDLE_TYPE
+IndexedPriorityQueue<T, CompareFunc, Policy>::Emplace(Args&&... args) {
+    if (m_elemCnt == m_Size) {
+        if (m_isFixed) {
+            return PushElem(T(std::forward<Args>(args)...), nullptr);
+        }
+        if (!Grow()) {
+            m_stats.OnPush();
+            return INVALID_HANDLE;
+        }
+    }
+    m_stats.OnPush();
+    HANDLE_TYPE  newHt = AcquireHandle();
+    size_t slot = Slot(newHt);
+    if (slot < m_elemConstructedCnt) {
+        m_elemArr[slot] = T(std::forward<Args>(args)...);
     }
     else {
-        newHt = m_elemCnt;
+        ::new ((void*)(m_elemArr + slot)) T(std::forward<Args>(args)...);
+        ++m_elemConstructedCnt;
     }
-    m_elemArr[newHt] = elem;
-    m_elemIndex2HeapIndexArr[newHt] = m_elemCnt;
-    m_heapArr[m_elemCnt] = newHt;
-    ++m_elemCnt;
-    return AdjustUpward(m_elemCnt - 1);
+    return LinkNewElem(newHt);
 }
 
-template <class T, class CompareFunc>
-typename IndexedPriorityQueue<T, CompareFunc>::HANDLE_TYPE
-IndexedPriorityQueue<T, CompareFunc>::Update(HANDLE_TYPE ht, const T& newElem , T *pRemovedElem /*= nullptr */) {
-    if (nullptr != pRemovedElem ) {
-        *pRemovedElem = m_elemArr[ht];
+template <class T, class CompareFunc, class Policy>
+template <class U>
+typename IndexedPriorityQueue<T, CompareFunc, Policy>::HANDLE_TYPE
+IndexedPriorityQueue<T, CompareFunc, Policy>::UpdateElem(HANDLE_TYPE ht, U&& newElem , T *pRemovedElem) {
+    if constexpr (GENERATION_BITS > 0) {
+        if (!Contains(ht)) {
+            return INVALID_HANDLE;
+        }
     }
-    if (m_valueCmpFunc(newElem,m_elemArr[ht])) {
-        m_elemArr[ht] = newElem;
-        return AdjustDownward(m_elemIndex2HeapIndexArr[ht]);
+    size_t slot = Slot(ht);
+    size_t nIndex = m_elemIndex2HeapIndexArr[slot];
+    bool isDownward = Compare(newElem,m_elemArr[slot]);
+    m_stats.OnUpdate(!isDownward);
+    if (nullptr != pRemovedElem ) {
+        /// *newElem* may refer to the old element itself or to *pRemovedElem*, so it is taken before the move out
+        T newValue(std::forward<U>(newElem));
+        *pRemovedElem = std::move(m_elemArr[slot]);
+        m_elemArr[slot] = std::move(newValue);
     }
     else {
-        m_elemArr[ht] = newElem;
-        return AdjustUpward(m_elemIndex2HeapIndexArr[ht]);
+        m_elemArr[slot] = std::forward<U>(newElem);
+    }
+    if constexpr (INLINE_ELEM) { m_heapElemArr[nIndex] = m_elemArr[slot]; }
+    if (m_isInBatch) {
+        AddDirtyIndex(nIndex);
+        return ht;
     }
+    return isDownward ? AdjustDownward(nIndex) : AdjustUpward(nIndex);
 }
 
 
-template <class T, class CompareFunc>
-typename IndexedPriorityQueue<T, CompareFunc>::HANDLE_TYPE
-IndexedPriorityQueue<T, CompareFunc>::AdjustUpward(size_t nIndex)
+template <class T, class CompareFunc, class Policy>
+typename IndexedPriorityQueue<T, CompareFunc, Policy>::HANDLE_TYPE
+IndexedPriorityQueue<T, CompareFunc, Policy>::AdjustUpward(size_t nIndex)
 {
     assert(nIndex < m_elemCnt);
-    if (nIndex >= m_elemCnt) return std::string::npos;
+    if (nIndex >= m_elemCnt) return INVALID_HANDLE;
 
     HANDLE_TYPE  curHt = m_heapArr[nIndex];
-    T& curElem = m_elemArr[curHt];
+    CUR_ELEM_TYPE curElem = HeapElem(nIndex);
+    size_t depth = 0;
     while (nIndex > 0) {
-        size_t nUp = (nIndex - 1) / 2;
-        if (!m_valueCmpFunc(m_elemArr[m_heapArr[nUp] ], curElem)) {
+        size_t nUp = ParentIndex(nIndex);
+        if (!Compare(HeapElem(nUp), curElem)) {
             break;
         }
         else {
             CopyHeapElem(nUp,nIndex);
             nIndex = nUp;
+            ++depth;
         }
     }
+    m_stats.OnSift(depth);
     m_heapArr[nIndex] = curHt;
-    m_elemIndex2HeapIndexArr[curHt] = nIndex;
+    m_elemIndex2HeapIndexArr[Slot(curHt)] = nIndex;
+    if constexpr (INLINE_ELEM) { m_heapElemArr[nIndex] = curElem; }
     return curHt;
 }
 
 
-template <class T, class CompareFunc>
-typename IndexedPriorityQueue<T, CompareFunc>::HANDLE_TYPE
-IndexedPriorityQueue<T, CompareFunc>::AdjustDownward(size_t nIndex)
+template <class T, class CompareFunc, class Policy>
+typename IndexedPriorityQueue<T, CompareFunc, Policy>::HANDLE_TYPE
+IndexedPriorityQueue<T, CompareFunc, Policy>::AdjustDownward(size_t nIndex)
 {
     assert(nIndex < m_elemCnt);
-    if (nIndex >= m_elemCnt) return std::string::npos;
+    if (nIndex >= m_elemCnt) return INVALID_HANDLE;
 
     HANDLE_TYPE  curHt = m_heapArr[nIndex];
-    T& curElem = m_elemArr[curHt];
+    CUR_ELEM_TYPE curElem = HeapElem(nIndex);
+    size_t depth = 0;
     while (true) {
-        size_t nDown = 1 + nIndex * 2;
-        if (nDown >= m_elemCnt) {
+        size_t nFirst = FirstChildIndex(nIndex);
+        if (nFirst >= m_elemCnt) {
             break;
         }
-        size_t nDownRight = nDown + 1;
-        if (nDownRight < m_elemCnt && m_valueCmpFunc(m_elemArr[m_heapArr[nDown] ], m_elemArr[m_heapArr[nDownRight] ])) {
-            nDown = nDownRight;
-        }
-        if (!m_valueCmpFunc(curElem, m_elemArr[m_heapArr[nDown] ])) {
+        size_t nDown = SelectBestChild(nFirst, std::min<size_t>(nFirst + ARITY, m_elemCnt));
+        if (!Compare(curElem, HeapElem(nDown))) {
             break;
         }
         else {
             CopyHeapElem(nDown,nIndex);
             nIndex = nDown;
+            ++depth;
         }
     }
+    m_stats.OnSift(depth);
     m_heapArr[nIndex] = curHt;
-    m_elemIndex2HeapIndexArr[curHt] = nIndex;
+    m_elemIndex2HeapIndexArr[Slot(curHt)] = nIndex;
+    if constexpr (INLINE_ELEM) { m_heapElemArr[nIndex] = curElem; }
     return curHt;
 }
 
 
-template <class T, class CompareFunc>
+template <class T, class CompareFunc, class Policy>
 bool
-IndexedPriorityQueue<T, CompareFunc>::IsHeap() {
-    for (size_t i = 0; i < m_elemCnt; ++i) {
-        size_t nDown = 1+i*2;
-        if (nDown >= m_elemCnt) {
-            break;
+IndexedPriorityQueue<T, CompareFunc, Policy>::IsHeap() {
+    for (size_t i = 1; i < m_elemCnt; ++i) {
+        if (m_valueCmpFunc(HeapElem(ParentIndex(i)), HeapElem(i))) {
+            return false;
         }
-        if (m_valueCmpFunc(m_elemArr[m_heapArr[i]], m_elemArr[m_heapArr[nDown]])) {
+    }
+    return true;
+}
+
+template <class T, class CompareFunc, class Policy>
+template <class ForwardIt>
+void
+IndexedPriorityQueue<T, CompareFunc, Policy>::Build(ForwardIt first, ForwardIt last) {
+    Reset();
+    size_t count = std::distance(first, last);
+    if (!m_isFixed) {
+        GrowTo(count);
+    }
+    size_t heapifyCount = std::min(count, m_Size);
+
+    for (size_t i = 0; i < heapifyCount; ++i, ++first) {
+        StoreElem(i, *first);
+        if constexpr (INLINE_ELEM) { m_heapElemArr[i] = m_elemArr[i]; }
+        m_heapArr[i] = i;
+        m_elemIndex2HeapIndexArr[i] = i;
+    }
+    m_elemCnt = heapifyCount;
+    Heapify();
+    for (; first != last; ++first) {
+        Push(*first);
+    }
+}
+
+template <class T, class CompareFunc, class Policy>
+void
+IndexedPriorityQueue<T, CompareFunc, Policy>::ApplyBatch() {
+    size_t depth = 1;
+    for (size_t n = m_elemCnt; n > 1; n /= ARITY) { ++depth; }
+    if (m_isDirtyOverflow || m_dirtyIndexElemCount * depth >= m_elemCnt) {
+        Heapify();
+    }
+    else {
+        /// sifting down dirty positions and all their ancestors in descending order, as bottom-up heapify does, makes
+        /// every processed subtree a heap, while untouched subtrees are heaps already.
+        size_t dirtyCount = m_dirtyIndexElemCount;
+        for (size_t i = 0; i < dirtyCount; ++i) {
+            size_t nIndex = m_dirtyIndexArr[i];
+            while (nIndex > 0) {
+                nIndex = ParentIndex(nIndex);
+                if (m_dirtyIndexElemCount == m_dirtyIndexSize) {
+                    m_dirtyIndexSize = ExtendArray(m_dirtyIndexArr, m_dirtyIndexSize);
+                }
+                m_dirtyIndexArr[m_dirtyIndexElemCount++] = nIndex;
+            }
+        }
+        std::sort(m_dirtyIndexArr, m_dirtyIndexArr + m_dirtyIndexElemCount, std::greater<size_t>());
+        size_t* pEnd = std::unique(m_dirtyIndexArr, m_dirtyIndexArr + m_dirtyIndexElemCount);
+        for (size_t* p = m_dirtyIndexArr; p != pEnd; ++p) {
+            if (*p < m_elemCnt) {
+                AdjustDownward(*p);
+            }
+        }
+    }
+    m_dirtyIndexElemCount = 0;
+    m_isDirtyOverflow = false;
+}
+
+template <class T, class CompareFunc, class Policy>
+size_t
+IndexedPriorityQueue<T, CompareFunc, Policy>::ExtractTopK(size_t k, HANDLE_TYPE* pHts) {
+    assert(!IsHeapPending());
+    k = std::min(k, m_elemCnt);
+    if (k == 0) {
+        return 0;
+    }
+    /// max heap of heap positions by their elements, the next element in Pop order is always in the frontier
+    auto frontierCmp = [this](size_t a, size_t b) { return Compare(HeapElem(a), HeapElem(b)); };
+    std::vector<size_t> frontier;
+    frontier.reserve(k * (ARITY - 1) + 1);
+    frontier.push_back(0);
+    for (size_t i = 0; i < k; ++i) {
+        std::pop_heap(frontier.begin(), frontier.end(), frontierCmp);
+        size_t nIndex = frontier.back();
+        frontier.pop_back();
+        pHts[i] = m_heapArr[nIndex];
+        size_t nFirst = FirstChildIndex(nIndex);
+        size_t nLast = std::min(nFirst + ARITY, m_elemCnt);
+        for (size_t nChild = nFirst; nChild < nLast; ++nChild) {
+            frontier.push_back(nChild);
+            std::push_heap(frontier.begin(), frontier.end(), frontierCmp);
+        }
+    }
+    return k;
+}
+
+template <class T, class CompareFunc, class Policy>
+bool
+IndexedPriorityQueue<T, CompareFunc, Policy>::SaveSnapshot(const std::string& path) {
+    static_assert(std::is_trivially_copyable<T>::value, "only queues of trivially copyable elements can be saved");
+    assert(!IsHeapPending());
+    IndexedPQSnapshotHeader header = MakeSnapshotHeader();
+    header.m_isFixed = m_isFixed;
+    header.m_capacity = m_Size;
+    header.m_elemCnt = m_elemCnt;
+    header.m_elemConstructedCnt = m_elemConstructedCnt;
+    header.m_poppedCnt = m_poppedHandleTypeElemCount;
+    header.m_poppedCapacity = std::max<size_t>(m_poppedHandleTypeElemCount, 1);
+    header.Layout(HEAP_ARRAY_PADDING);
+
+    std::string tmpPath = path + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    /// only meaningful parts of arrays are written, the rest of every section is zero
+    uint64_t curOffset = 0;
+    auto writeSection = [&](uint64_t offset, const void* p, size_t bytes) {
+        if (!IndexedPQSnapshotFile::PadTo(fd, curOffset, offset) || !IndexedPQSnapshotFile::WriteAll(fd, p, bytes)) {
             return false;
         }
-        size_t nDownRight = nDown + 1;
-        if (nDownRight >= m_elemCnt) {
+        curOffset += bytes;
+        return true;
+    };
+    bool isOk = writeSection(0, &header, sizeof(header))
+        && writeSection(header.m_elemOffset, m_elemArr, m_elemConstructedCnt * sizeof(T))
+        && writeSection(header.m_indexOffset, m_elemIndex2HeapIndexArr, m_elemConstructedCnt * sizeof(HANDLE_TYPE))
+        && writeSection(header.m_heapOffset + HEAP_ARRAY_PADDING * sizeof(HANDLE_TYPE), m_heapArr, m_elemCnt * sizeof(HANDLE_TYPE))
+        && (!INLINE_ELEM || writeSection(header.m_heapElemOffset + HEAP_ARRAY_PADDING * sizeof(T), m_heapElemArr, m_elemCnt * sizeof(T)))
+        && writeSection(header.m_poppedOffset, m_poppedHandleTypeArr, m_poppedHandleTypeElemCount * sizeof(HANDLE_TYPE))
+        && IndexedPQSnapshotFile::PadTo(fd, curOffset, header.m_fileSize)
+        && 0 == ::fsync(fd);
+    isOk = 0 == ::close(fd) && isOk;
+    if (!isOk || 0 != ::rename(tmpPath.c_str(), path.c_str())) {
+        ::unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+template <class T, class CompareFunc, class Policy>
+bool
+IndexedPriorityQueue<T, CompareFunc, Policy>::LoadSnapshot(const std::string& path, IndexedPQSnapshotMode mode
+                                                           /* = IndexedPQSnapshotMode::MMAP_COPY_ON_WRITE */) {
+    static_assert(std::is_trivially_copyable<T>::value, "only queues of trivially copyable elements can be loaded");
+    size_t bytes = 0;
+    char* pBase = (char*)IndexedPQSnapshotFile::Map(path, mode == IndexedPQSnapshotMode::MMAP_COPY_ON_WRITE, bytes);
+    if (nullptr == pBase) {
+        return false;
+    }
+    IndexedPQSnapshotHeader header;
+    memcpy((void*)&header, pBase, sizeof(header));
+    if (!header.IsCompatible(MakeSnapshotHeader(), HEAP_ARRAY_PADDING, bytes)) {
+        IndexedPQSnapshotFile::Unmap(pBase, bytes);
+        return false;
+    }
+
+    FreeArrays();
+    m_Size = header.m_capacity;
+    m_elemCnt = header.m_elemCnt;
+    m_elemConstructedCnt = header.m_elemConstructedCnt;
+    m_poppedHandleTypeSize = header.m_poppedCapacity;
+    m_poppedHandleTypeElemCount = header.m_poppedCnt;
+    m_isFixed = header.m_isFixed;
+    m_isReadOnly = mode == IndexedPQSnapshotMode::MMAP_READ_ONLY;
+    m_isInBatch = false;
+    m_isDirtyOverflow = false;
+    m_dirtyIndexElemCount = 0;
+    if (mode == IndexedPQSnapshotMode::COPY) {
+        m_elemArr = AllocElemArray(m_Size);
+        memcpy((void*)m_elemArr, pBase + header.m_elemOffset, m_elemConstructedCnt * sizeof(T));
+        m_elemIndex2HeapIndexArr = m_memory.template AllocArray<HANDLE_TYPE>(m_Size);
+        memcpy(m_elemIndex2HeapIndexArr, pBase + header.m_indexOffset, m_elemConstructedCnt * sizeof(HANDLE_TYPE));
+        m_heapArr = AllocHeapArray<HANDLE_TYPE>(m_Size);
+        memcpy(m_heapArr, pBase + header.m_heapOffset + HEAP_ARRAY_PADDING * sizeof(HANDLE_TYPE), m_elemCnt * sizeof(HANDLE_TYPE));
+        if constexpr (INLINE_ELEM) {
+            m_heapElemArr = AllocHeapArray<VALUE_TYPE>(m_Size);
+            memcpy((void*)m_heapElemArr, pBase + header.m_heapElemOffset + HEAP_ARRAY_PADDING * sizeof(T), m_elemCnt * sizeof(T));
+        }
+        m_poppedHandleTypeArr = m_memory.template AllocArray<HANDLE_TYPE>(m_poppedHandleTypeSize);
+        memcpy(m_poppedHandleTypeArr, pBase + header.m_poppedOffset, m_poppedHandleTypeElemCount * sizeof(HANDLE_TYPE));
+        IndexedPQSnapshotFile::Unmap(pBase, bytes);
+        m_memory.ReleaseMapping();
+    }
+    else {
+        m_memory.AdoptMapping(pBase, bytes);
+        m_elemArr = (VALUE_TYPE*)(pBase + header.m_elemOffset);
+        m_elemIndex2HeapIndexArr = (HANDLE_TYPE*)(pBase + header.m_indexOffset);
+        m_heapArr = (HANDLE_TYPE*)(pBase + header.m_heapOffset) + HEAP_ARRAY_PADDING;
+        if constexpr (INLINE_ELEM) { m_heapElemArr = (VALUE_TYPE*)(pBase + header.m_heapElemOffset) + HEAP_ARRAY_PADDING; }
+        m_poppedHandleTypeArr = (HANDLE_TYPE*)(pBase + header.m_poppedOffset);
+    }
+    return true;
+}
+
+template <class T, class CompareFunc, class Policy>
+template <class Queue>
+size_t
+IndexedPriorityQueue<T, CompareFunc, Policy>::MergeFrom(Queue& other, std::vector<HANDLE_TYPE>* pRemap) {
+    assert((const void*)&other != (const void*)this);
+    typedef typename std::conditional<std::is_const<Queue>::value, const T&, T&&>::type ELEM_REF_TYPE;
+    if (nullptr != pRemap) {
+        pRemap->assign(other.m_elemConstructedCnt, INVALID_HANDLE);
+    }
+    size_t count = other.m_elemCnt;
+    if (0 == count) {
+        return 0;
+    }
+    size_t mergedCnt = 0;
+    auto mergeElem = [&](HANDLE_TYPE otherHt) {
+        HANDLE_TYPE newHt = PushElem(static_cast<ELEM_REF_TYPE>(other.m_elemArr[Slot(otherHt)]), nullptr);
+        if (newHt != INVALID_HANDLE) {
+            ++mergedCnt;
+            if (nullptr != pRemap) { (*pRemap)[Slot(otherHt)] = newHt; }
+        }
+    };
+    bool isOwnBatch = !m_isInBatch;
+    if (!m_isFixed) {
+        GrowTo(m_elemCnt + count);
+        /// sifting up a new element is O(1) expected, so rebuilding the heap in O(N) only pays when *other* is not
+        /// smaller than this IndexedPQ, the batch then decides it by count of dirty positions.
+        isOwnBatch = isOwnBatch && count >= m_elemCnt;
+        if (isOwnBatch) { BeginBatch(); }
+        for (size_t i = 0; i < count; ++i) {
+            mergeElem(other.m_heapArr[i]);
+        }
+        if (isOwnBatch) { CommitBatch(); }
+        return mergedCnt;
+    }
+
+    /// only the best *m_Size* elements of *other* may be kept
+    size_t candidateCnt = std::min(count, m_Size);
+    std::vector<HANDLE_TYPE> otherHts(other.m_heapArr, other.m_heapArr + count);
+    std::partial_sort(otherHts.begin(), otherHts.begin() + candidateCnt, otherHts.end(),
+                      [this, &other](HANDLE_TYPE a, HANDLE_TYPE b) {
+                          return Compare(other.m_elemArr[Slot(a)], other.m_elemArr[Slot(b)]);
+                      });
+    size_t i = 0;
+    if (isOwnBatch) { BeginBatch(); }
+    for (; i < candidateCnt && m_elemCnt < m_Size; ++i) {
+        mergeElem(otherHts[i]);
+    }
+    if (isOwnBatch) { CommitBatch(); }
+    else if (i < candidateCnt) { ApplyBatch(); }
+    for (; i < candidateCnt; ++i) {
+        /// the rest are not better than the rejected one, and the top only gets better
+        if (IsNotNeedPushWhenSeekFixedTopN(other.m_elemArr[Slot(otherHts[i])])) {
             break;
         }
+        mergeElem(otherHts[i]);
+    }
+    return mergedCnt;
+}
 
-        if (m_valueCmpFunc(m_elemArr[m_heapArr[i]], m_elemArr[m_heapArr[nDownRight]])) {
+template <class T, class CompareFunc, class Policy>
+template <class MoveCallback>
+bool
+IndexedPriorityQueue<T, CompareFunc, Policy>::Compact(size_t maxMoves, MoveCallback&& onMove) {
+    assert(!m_isReadOnly);
+    for (size_t moves = 0; ; ++moves) {
+        TrimSlots();
+        if (m_elemConstructedCnt == m_elemCnt) {
+            /// the rest popped handles are of released slots
+            m_poppedHandleTypeElemCount = 0;
+            return true;
+        }
+        if (moves == maxMoves) {
             return false;
         }
+        /// recycled slots below count are taken firstly, so that every element is moved once at most
+        HANDLE_TYPE* pPoppedEnd = m_poppedHandleTypeArr + m_poppedHandleTypeElemCount;
+        if (m_poppedHandleTypeElemCount > 0 && Slot(pPoppedEnd[-1]) >= m_elemCnt) {
+            std::partition(m_poppedHandleTypeArr, pPoppedEnd, [this](HANDLE_TYPE ht) { return Slot(ht) >= m_elemCnt; });
+        }
+        /// any recycled slot is below the last one, which is in use after trimming
+        HANDLE_TYPE holeHt = INVALID_HANDLE;
+        while (m_poppedHandleTypeElemCount > 0 && holeHt == INVALID_HANDLE) {
+            HANDLE_TYPE ht = m_poppedHandleTypeArr[--m_poppedHandleTypeElemCount];
+            if (Slot(ht) < m_elemConstructedCnt) { holeHt = ht; }
+        }
+        if (holeHt == INVALID_HANDLE) {
+            return false;
+        }
+        size_t lastSlot = m_elemConstructedCnt - 1;
+        size_t nIndex = m_elemIndex2HeapIndexArr[lastSlot];
+        HANDLE_TYPE oldHt = m_heapArr[nIndex];
+        m_elemArr[Slot(holeHt)] = std::move(m_elemArr[lastSlot]);
+        m_elemIndex2HeapIndexArr[Slot(holeHt)] = nIndex;
+        m_heapArr[nIndex] = holeHt;
+        onMove(oldHt, holeHt);
+    }
+}
+
+template <class T, class CompareFunc, class Policy>
+void
+IndexedPriorityQueue<T, CompareFunc, Policy>::ShrinkToFit() {
+    assert(!m_isReadOnly);
+    TrimSlots();
+    size_t poppedCount = 0;
+    for (size_t i = 0; i < m_poppedHandleTypeElemCount; ++i) {
+        if (Slot(m_poppedHandleTypeArr[i]) < m_elemConstructedCnt) {
+            m_poppedHandleTypeArr[poppedCount++] = m_poppedHandleTypeArr[i];
+        }
+    }
+    m_poppedHandleTypeElemCount = poppedCount;
+    if (!m_isFixed) {
+        size_t newSize = std::max<size_t>(m_elemConstructedCnt, 1);
+        if (newSize < m_Size) {
+            ResizeArrays(newSize);
+        }
+    }
+    size_t newPoppedSize = std::max<size_t>(m_poppedHandleTypeElemCount, 1);
+    if (newPoppedSize < m_poppedHandleTypeSize) {
+        m_poppedHandleTypeSize = ExtendArray(m_poppedHandleTypeArr, m_poppedHandleTypeSize, newPoppedSize);
+    }
+    size_t newDirtySize = std::max<size_t>(m_dirtyIndexElemCount, 1);
+    if (newDirtySize < m_dirtyIndexSize) {
+        m_dirtyIndexSize = ExtendArray(m_dirtyIndexArr, m_dirtyIndexSize, newDirtySize);
     }
-    return true;
 }
 
 #endif //__INDEXEDPQ_INDEXED_PRIORITY_QUEUE_H__
@@ -0,0 +1,183 @@
+#ifndef __INDEXEDPQ_INDEXED_RADIX_HEAP_H__
+#define __INDEXEDPQ_INDEXED_RADIX_HEAP_H__
+
+#include "indexedpq/indexed-priority-queue.h"
+#include <cassert>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+/**
+ *@brief     indexed monotone radix heap of unsigned integer keys, sharing the handle API of IndexedPriorityQueue
+ *           (Push/Pop/Update/Remove/Top/Elem). It is a MinTop heap, the same order as IndexedPriorityQueue with
+ *           std::greater, and it is monotone: a key pushed or updated must not be smaller than *GetLowerBound*, i.e.
+ *           the last popped key, or the top key once *Top* is called. It holds for Dijkstra and event simulation.
+ *           Key *k* lives in bucket of the highest bit where it differs from the lower bound, so *Update* just
+ *           moves a handle between buckets in O(1), and every key is redistributed at most once per bit by *Pop*.
+ *           Only *HANDLE_TYPE* of *Policy* is used.
+ */
+template <class T, class Policy = IndexedPQDefaultPolicy >
+class IndexedRadixHeap
+{
+public:
+    typedef T                               VALUE_TYPE;
+    typedef std::greater<T>                 VALUE_COMPARE;
+    typedef Policy                          POLICY_TYPE;
+    typedef typename Policy::HANDLE_TYPE    HANDLE_TYPE;
+
+    static constexpr HANDLE_TYPE INVALID_HANDLE = HANDLE_TYPE(-1);
+    static constexpr size_t MAX_COUNT = INVALID_HANDLE;
+    static constexpr size_t BUCKET_COUNT = sizeof(T) * 8 + 1;      /// bucket 0 keeps keys equal to the lower bound
+    static_assert(std::is_integral<T>::value && std::is_unsigned<T>::value, "radix heap key must be unsigned integer");
+
+public:
+    IndexedRadixHeap(size_t nSizeHint = 32, VALUE_COMPARE compareFunc = VALUE_COMPARE())
+        : m_last(0), m_elemCnt(0) {
+        (void)compareFunc;
+        m_nodeVec.reserve(nSizeHint);
+    }
+
+    inline size_t   GetCount() { return m_elemCnt; }
+    inline bool     IsEmpty() { return m_elemCnt == 0; }
+    inline const T& Elem(HANDLE_TYPE ht) { assert(ht < m_nodeVec.size()); return m_nodeVec[ht].m_elem; }
+    /// whether element of handle *ht* is in the heap
+    inline bool     Contains(HANDLE_TYPE ht) { return ht < m_nodeVec.size() && m_nodeVec[ht].m_bucket < BUCKET_COUNT; }
+    /// lower bound of keys to be pushed or updated, the last popped key or the top key returned by *Top*
+    inline T        GetLowerBound() { return m_last; }
+    /// return ht of top element, keys are redistributed lazily if needed
+    inline HANDLE_TYPE Top() { assert(m_elemCnt > 0); Settle(); return m_bucketVecs[0].back(); }
+    /// return value of top element
+    inline const T& TopElem() { return m_nodeVec[Top()].m_elem; }
+
+    /// Reset status of heap, including the lower bound
+    void Reset() {
+        m_nodeVec.clear();
+        m_freeHtVec.clear();
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) { m_bucketVecs[i].clear(); }
+        m_last = 0;
+        m_elemCnt = 0;
+    }
+
+    /// push *elem* not smaller than *GetLowerBound*, return its handle, INVALID_HANDLE if *MAX_COUNT* is reached.
+    HANDLE_TYPE Push(const T& elem) {
+        assert(elem >= m_last);
+        HANDLE_TYPE ht;
+        if (!m_freeHtVec.empty()) {
+            ht = m_freeHtVec.back();
+            m_freeHtVec.pop_back();
+        }
+        else {
+            if (m_nodeVec.size() >= MAX_COUNT) {
+                return INVALID_HANDLE;
+            }
+            ht = m_nodeVec.size();
+            m_nodeVec.push_back(Node());
+        }
+        m_nodeVec[ht].m_elem = elem;
+        Link(ht);
+        ++m_elemCnt;
+        return ht;
+    }
+
+    /// pop the min element and recycle its handle, return handle of popped element
+    HANDLE_TYPE Pop() {
+        HANDLE_TYPE ht = Top();
+        Unlink(ht);
+        m_freeHtVec.push_back(ht);
+        --m_elemCnt;
+        return ht;
+    }
+
+    /**
+     *@brief     update key of handle *ht* to *newElem*, which is not smaller than *GetLowerBound*.
+     *@param     pRemovedElem --- element substituted if it is not null.
+     *@return    *ht*, INVALID_HANDLE if *ht* is not in the heap.
+     */
+    HANDLE_TYPE Update(HANDLE_TYPE ht, const T& newElem, T* pRemovedElem = nullptr) {
+        if (!Contains(ht)) {
+            return INVALID_HANDLE;
+        }
+        assert(newElem >= m_last);
+        if (nullptr != pRemovedElem) { *pRemovedElem = m_nodeVec[ht].m_elem; }
+        m_nodeVec[ht].m_elem = newElem;
+        size_t bucket = BucketOf(newElem);
+        if (bucket != m_nodeVec[ht].m_bucket) {
+            Unlink(ht);
+            Link(ht);
+        }
+        return ht;
+    }
+
+    /// remove element of handle *ht* and recycle the handle, return false if it is not in the heap
+    bool Remove(HANDLE_TYPE ht, T* pRemovedElem = nullptr) {
+        if (!Contains(ht)) {
+            return false;
+        }
+        if (nullptr != pRemovedElem) { *pRemovedElem = m_nodeVec[ht].m_elem; }
+        Unlink(ht);
+        m_freeHtVec.push_back(ht);
+        --m_elemCnt;
+        return true;
+    }
+
+private:
+    struct Node {
+        T           m_elem = 0;
+        size_t      m_bucket = BUCKET_COUNT;    /// BUCKET_COUNT if not in heap
+        size_t      m_pos = 0;                  /// position in its bucket
+    };
+
+    /// bucket of key *elem*, 1 + index of highest bit different from lower bound, 0 if equal
+    inline size_t BucketOf(T elem) {
+        T diff = elem ^ m_last;
+        if (diff == 0) {
+            return 0;
+        }
+        return sizeof(unsigned long long) * 8 - __builtin_clzll((unsigned long long)diff);
+    }
+    void Link(HANDLE_TYPE ht) {
+        Node& node = m_nodeVec[ht];
+        node.m_bucket = BucketOf(node.m_elem);
+        node.m_pos = m_bucketVecs[node.m_bucket].size();
+        m_bucketVecs[node.m_bucket].push_back(ht);
+    }
+    void Unlink(HANDLE_TYPE ht) {
+        Node& node = m_nodeVec[ht];
+        std::vector<HANDLE_TYPE>& bucketVec = m_bucketVecs[node.m_bucket];
+        HANDLE_TYPE lastHt = bucketVec.back();
+        bucketVec[node.m_pos] = lastHt;
+        m_nodeVec[lastHt].m_pos = node.m_pos;
+        bucketVec.pop_back();
+        node.m_bucket = BUCKET_COUNT;
+    }
+    /// make bucket 0 not empty: the min key of the first non-empty bucket becomes the lower bound, and keys of
+    /// that bucket are redistributed into lower buckets.
+    void Settle() {
+        if (!m_bucketVecs[0].empty()) {
+            return;
+        }
+        size_t bucket = 1;
+        while (m_bucketVecs[bucket].empty()) { ++bucket; }
+        std::vector<HANDLE_TYPE>& bucketVec = m_bucketVecs[bucket];
+        T minElem = m_nodeVec[bucketVec[0]].m_elem;
+        for (size_t i = 1; i < bucketVec.size(); ++i) {
+            minElem = std::min(minElem, m_nodeVec[bucketVec[i]].m_elem);
+        }
+        m_last = minElem;
+        m_redistributeVec.swap(bucketVec);
+        for (size_t i = 0; i < m_redistributeVec.size(); ++i) {
+            Link(m_redistributeVec[i]);
+        }
+        m_redistributeVec.clear();
+    }
+
+private:
+    std::vector<Node>           m_nodeVec;                      /// nodes indexed by handle
+    std::vector<HANDLE_TYPE>    m_freeHtVec;                    /// recycled handles
+    std::vector<HANDLE_TYPE>    m_bucketVecs[BUCKET_COUNT];     /// handles of every bucket
+    std::vector<HANDLE_TYPE>    m_redistributeVec;              /// scratch of *Settle*
+    T                           m_last;                         /// lower bound of keys
+    size_t                      m_elemCnt;
+};
+
+#endif //__INDEXEDPQ_INDEXED_RADIX_HEAP_H__
@@ -0,0 +1,117 @@
+#include "indexedpq/merge-topn-unittest.h"
+#include "indexedpq/indexed-priority-queue-unittest.h"
+#include <cppunit/TestAssert.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace std;
+CPPUNIT_TEST_SUITE_REGISTRATION(MergeTopNTest);
+
+void MergeTopNTest::InternalTopNTest(size_t itemCount, size_t shardCount, size_t shardTopN, size_t topN) {
+    typedef IndexedPriorityQueue<FakeItem, FakeItemComparator> Queue;
+    vector<FakeItem> itemsVec;
+    FakeItemMgr::sGenItems(itemCount, itemCount, itemsVec);
+    vector<unique_ptr<Queue> > shards;
+    vector<Queue*> queues;
+    for (size_t i = 0; i < shardCount; ++i) {
+        shards.emplace_back(new Queue(shardTopN, 32, true));
+        queues.push_back(shards.back().get());
+    }
+    for (size_t i = 0; i < itemCount; ++i) {
+        queues[i % shardCount]->Push(itemsVec[i]);
+    }
+
+    /// expected is TopN of what the shards kept
+    vector<FakeItem> keptVec;
+    for (Queue* pQueue : queues) {
+        for (size_t i = 0; i < pQueue->GetCount(); ++i) { keptVec.push_back(pQueue->ElemAtHeap(i)); }
+    }
+    FakeItemComparator itemComparator;
+    std::sort(keptVec.begin(), keptVec.end(), itemComparator);
+    size_t realTopN = std::min(topN, keptVec.size());
+
+    IndexedPQMergeTopN<FakeItem, FakeItemComparator> mergeTopN(topN);
+    vector<FakeItem> topNItemsVec;
+    vector<IndexedPQMergeTopN<FakeItem, FakeItemComparator>::SOURCE_TYPE> sources;
+    mergeTopN.Run(queues, topNItemsVec, &sources);
+    CPPUNIT_ASSERT_EQUAL(realTopN, topNItemsVec.size());
+    CPPUNIT_ASSERT_EQUAL(realTopN, sources.size());
+    for (size_t i = 0; i < realTopN; ++i) {
+        CPPUNIT_ASSERT(keptVec[i] == topNItemsVec[i]);
+        CPPUNIT_ASSERT(topNItemsVec[i] == queues[sources[i].first]->Elem(sources[i].second));
+    }
+
+    /// shards are not changed
+    for (Queue* pQueue : queues) {
+        CPPUNIT_ASSERT(pQueue->IsHeap());
+    }
+    MergeTopN(queues, topN, topNItemsVec, itemComparator);
+    CPPUNIT_ASSERT_EQUAL(realTopN, topNItemsVec.size());
+    for (size_t i = 0; i < realTopN; ++i) {
+        CPPUNIT_ASSERT(keptVec[i] == topNItemsVec[i]);
+    }
+}
+
+void MergeTopNTest::TopNTest() {
+    InternalTopNTest(1e5, 16, 100, 100);
+    InternalTopNTest(1e5, 7, 1000, 100);
+    InternalTopNTest(2e4, 4, 100, 1000);
+    InternalTopNTest(3000, 64, 100, 10000);
+    InternalTopNTest(5000, 1, 200, 1);
+    InternalTopNTest(0, 4, 10, 10);
+    InternalTopNTest(0, 0, 10, 10);
+}
+
+void MergeTopNTest::PerformanceTest() {
+    /// global TopN of shards, by k-way merge against popping all shards into one fixed queue
+    typedef IndexedPriorityQueue<uint64_t, std::greater<uint64_t> > Queue;
+    size_t shardCount = 64, shardTopN = 1e4, topN = 100;
+    vector<unique_ptr<Queue> > shards;
+    vector<Queue*> queues;
+    for (size_t i = 0; i < shardCount; ++i) {
+        shards.emplace_back(new Queue(shardTopN, 32, true));
+        queues.push_back(shards.back().get());
+        for (size_t j = 0; j < shardTopN; ++j) {
+            queues.back()->Push(RandomUtil<int64_t>::RandomInt64(0, 1e12));
+        }
+    }
+
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    Queue pushPq(topN, 32, true);
+    for (Queue* pQueue : queues) {
+        while (!pQueue->IsEmpty()) {
+            uint64_t value = pQueue->TopElem();
+            pQueue->Pop();
+            pushPq.Push(value);
+        }
+    }
+    vector<uint64_t> pushTopNVec;
+    Queue::HANDLE_TYPE* pSortedHts = pushPq.ReverseSort();
+    for (size_t i = 0; i < pushPq.GetCount(); ++i) {
+        pushTopNVec.push_back(pushPq.Elem(pSortedHts[i]));
+    }
+    int64_t tPush = TimeUtil::CurrentTimeInMicroSeconds();
+
+    for (size_t i = 0; i < shardCount; ++i) {
+        for (size_t j = 0; j < shardTopN; ++j) {
+            queues[i]->Push(RandomUtil<int64_t>::RandomInt64(0, 1e12));
+        }
+    }
+    vector<uint64_t> allValues;
+    for (Queue* pQueue : queues) {
+        for (size_t i = 0; i < pQueue->GetCount(); ++i) { allValues.push_back(pQueue->ElemAtHeap(i)); }
+    }
+    int64_t tMergeBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    vector<uint64_t> mergeTopNVec;
+    MergeTopN(queues, topN, mergeTopNVec, std::greater<uint64_t>());
+    int64_t tMerge = TimeUtil::CurrentTimeInMicroSeconds();
+    cout << "-------------shardCount:[" << shardCount << "],shardTopN:[" << shardTopN << "],topN:[" << topN
+         << "],pop and push:[" << (tPush - tBegin) / 1000 << "]ms,merge:[" << (tMerge - tMergeBegin) / 1000
+         << "]ms." << endl;
+
+    CPPUNIT_ASSERT_EQUAL(topN, pushTopNVec.size());
+    std::sort(allValues.begin(), allValues.end(), std::greater<uint64_t>());
+    allValues.resize(topN);
+    CPPUNIT_ASSERT(allValues == mergeTopNVec);
+}
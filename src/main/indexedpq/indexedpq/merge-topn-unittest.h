@@ -0,0 +1,27 @@
+#ifndef __INDEXEDPQ_TEST_MERGE_TOPN_UNITTEST_H__
+#define __INDEXEDPQ_TEST_MERGE_TOPN_UNITTEST_H__
+
+#include "indexedpq/merge-topn.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+class MergeTopNTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(MergeTopNTest);
+    CPPUNIT_TEST(TopNTest);
+    CPPUNIT_TEST(PerformanceTest);
+    CPPUNIT_TEST_SUITE_END();
+public:
+    MergeTopNTest() {}
+    ~MergeTopNTest() {}
+    void setUp() {}
+    void tearDown() {}
+public:
+
+    void TopNTest();
+    void PerformanceTest();
+
+private:
+    void InternalTopNTest(size_t itemCount, size_t shardCount, size_t shardTopN, size_t topN);
+};
+
+
+#endif //__INDEXEDPQ_TEST_MERGE_TOPN_UNITTEST_H__
@@ -0,0 +1,129 @@
+#ifndef __INDEXEDPQ_MERGE_TOPN_H__
+#define __INDEXEDPQ_MERGE_TOPN_H__
+
+#include "indexedpq/indexed-priority-queue.h"
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/**
+ *@brief     k-way merge of the global TopN of several IndexedPQs, e.g. partial TopN of shards, which are not changed.
+ *           Handles of every queue are partitioned once to its best *topN*, which are made a heap, so a queue is only
+ *           ordered as deep as the merge reads it, and the merge stops as soon as *topN* elements are settled. It costs
+ *           O(M + N*logN) for M elements in all queues instead of popping and pushing all of them.
+ *           *CompareFunc(a, b)* is true if *a* ranks before *b*, the same as of fixed TopN IndexedPQ.
+ */
+template <class T, class CompareFunc, class Policy = IndexedPQDefaultPolicy>
+class IndexedPQMergeTopN
+{
+public:
+    typedef IndexedPriorityQueue<T, CompareFunc, Policy>    QUEUE_TYPE;
+    typedef typename QUEUE_TYPE::HANDLE_TYPE                HANDLE_TYPE;
+    /// index of queue in input and handle of element in that queue
+    typedef std::pair<size_t, HANDLE_TYPE>                  SOURCE_TYPE;
+
+public:
+    IndexedPQMergeTopN(size_t topN, CompareFunc compareFunc = CompareFunc())
+        : m_topN(topN), m_valueCmpFunc(compareFunc) {}
+
+    /**
+     *@param     queues --- queues to merge, none of them may be in a pending batch.
+     *@param     result --- global TopN elements in rank order, best first.
+     *@param     pSources --- if not null, source of every element of *result* at the same index.
+     */
+    void Run(const std::vector<QUEUE_TYPE*>& queues, std::vector<T>& result, std::vector<SOURCE_TYPE>* pSources = nullptr);
+
+private:
+    /// unconsumed handles of one queue as a heap, front is the current one which ranks first
+    struct Cursor {
+        QUEUE_TYPE*                 m_pQueue;
+        std::vector<HANDLE_TYPE>    m_hts;
+    };
+
+    /// keep the best *m_topN* handles of *cursor* as a heap, return false if it is empty
+    bool Init(Cursor& cursor);
+    /// consume the current handle of *cursor*, return false if all handles are consumed
+    bool Advance(Cursor& cursor);
+
+private:
+    size_t                  m_topN;
+    CompareFunc             m_valueCmpFunc;
+};
+
+template <class T, class CompareFunc, class Policy>
+bool IndexedPQMergeTopN<T, CompareFunc, Policy>::Init(Cursor& cursor) {
+    QUEUE_TYPE* pQueue = cursor.m_pQueue;
+    auto htCmp = [this, pQueue](HANDLE_TYPE a, HANDLE_TYPE b) {
+        return m_valueCmpFunc(pQueue->Elem(a), pQueue->Elem(b));
+    };
+    /// elements out of the best *m_topN* of their queue can not be in global TopN
+    if (cursor.m_hts.size() > m_topN) {
+        std::nth_element(cursor.m_hts.begin(), cursor.m_hts.begin() + m_topN, cursor.m_hts.end(), htCmp);
+        cursor.m_hts.resize(m_topN);
+    }
+    std::make_heap(cursor.m_hts.begin(), cursor.m_hts.end(),
+                   [&htCmp](HANDLE_TYPE a, HANDLE_TYPE b) { return htCmp(b, a); });
+    return !cursor.m_hts.empty();
+}
+
+template <class T, class CompareFunc, class Policy>
+bool IndexedPQMergeTopN<T, CompareFunc, Policy>::Advance(Cursor& cursor) {
+    QUEUE_TYPE* pQueue = cursor.m_pQueue;
+    std::pop_heap(cursor.m_hts.begin(), cursor.m_hts.end(), [this, pQueue](HANDLE_TYPE a, HANDLE_TYPE b) {
+        return m_valueCmpFunc(pQueue->Elem(b), pQueue->Elem(a));
+    });
+    cursor.m_hts.pop_back();
+    return !cursor.m_hts.empty();
+}
+
+template <class T, class CompareFunc, class Policy>
+void IndexedPQMergeTopN<T, CompareFunc, Policy>::Run(const std::vector<QUEUE_TYPE*>& queues, std::vector<T>& result,
+                                                     std::vector<SOURCE_TYPE>* pSources /* = nullptr */) {
+    result.clear();
+    if (nullptr != pSources) { pSources->clear(); }
+    std::vector<Cursor> cursors(queues.size());
+    std::vector<size_t> heap;
+    for (size_t i = 0; i < queues.size(); ++i) {
+        QUEUE_TYPE* pQueue = queues[i];
+        assert(!pQueue->IsHeapPending());
+        HANDLE_TYPE* pHts = pQueue->GetElementsArray();
+        Cursor& cursor = cursors[i];
+        cursor.m_pQueue = pQueue;
+        cursor.m_hts.assign(pHts, pHts + pQueue->GetCount());
+        if (Init(cursor)) {
+            heap.push_back(i);
+        }
+    }
+
+    /// cursors heap, top is the queue whose current element ranks first
+    auto cursorCmp = [this, &cursors](size_t a, size_t b) {
+        const Cursor& ca = cursors[a];
+        const Cursor& cb = cursors[b];
+        return m_valueCmpFunc(cb.m_pQueue->Elem(cb.m_hts.front()), ca.m_pQueue->Elem(ca.m_hts.front()));
+    };
+    std::make_heap(heap.begin(), heap.end(), cursorCmp);
+    while (!heap.empty() && result.size() < m_topN) {
+        std::pop_heap(heap.begin(), heap.end(), cursorCmp);
+        size_t index = heap.back();
+        Cursor& cursor = cursors[index];
+        HANDLE_TYPE ht = cursor.m_hts.front();
+        result.push_back(cursor.m_pQueue->Elem(ht));
+        if (nullptr != pSources) { pSources->push_back(SOURCE_TYPE(index, ht)); }
+        if (Advance(cursor)) {
+            std::push_heap(heap.begin(), heap.end(), cursorCmp);
+        }
+        else {
+            heap.pop_back();
+        }
+    }
+}
+
+/// global TopN of *queues* in rank order, see IndexedPQMergeTopN
+template <class T, class CompareFunc, class Policy>
+void MergeTopN(const std::vector<IndexedPriorityQueue<T, CompareFunc, Policy>*>& queues, size_t topN,
+               std::vector<T>& result, CompareFunc compareFunc = CompareFunc()) {
+    IndexedPQMergeTopN<T, CompareFunc, Policy>(topN, compareFunc).Run(queues, result);
+}
+
+#endif //__INDEXEDPQ_MERGE_TOPN_H__
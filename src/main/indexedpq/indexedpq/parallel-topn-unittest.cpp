@@ -0,0 +1,102 @@
+#include "indexedpq/parallel-topn-unittest.h"
+#include "indexedpq/indexed-priority-queue-unittest.h"
+#include <cppunit/TestAssert.h>
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+CPPUNIT_TEST_SUITE_REGISTRATION(ParallelTopNTest);
+
+void ParallelTopNTest::SharedThresholdTest() {
+    static_assert(IndexedPQIsAtomicLockFree<uint64_t>::value, "uint64_t threshold should be lock free");
+    static_assert(!IndexedPQIsAtomicLockFree<std::string>::value, "std::string threshold should use mutex");
+
+    /// smaller is better for std::less, so the threshold keeps the minimum published value
+    IndexedPQSharedThreshold<uint64_t, std::less<uint64_t> > threshold((std::less<uint64_t>()));
+    uint64_t value = 0;
+    CPPUNIT_ASSERT(!threshold.Get(value));
+    size_t threadCount = 4, publishCount = 10000;
+    vector<thread> threads;
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&threshold, t, threadCount, publishCount]() {
+            for (size_t i = 0; i < publishCount; ++i) {
+                threshold.Publish(publishCount * threadCount - i * threadCount - t);
+            }
+        });
+    }
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads[t].join();
+    }
+    CPPUNIT_ASSERT(threshold.Get(value));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, value);
+
+    IndexedPQSharedThreshold<FakeItem, FakeItemComparator> itemThreshold((FakeItemComparator()));
+    FakeItem item, bestItem;
+    CPPUNIT_ASSERT(!itemThreshold.Get(item));
+    item.m_id = 1; item.m_score = 10; item.m_flag = 0;
+    itemThreshold.Publish(item);
+    item.m_id = 2; item.m_score = 5;
+    itemThreshold.Publish(item);
+    CPPUNIT_ASSERT(itemThreshold.Get(bestItem));
+    CPPUNIT_ASSERT_EQUAL((uint64_t)10, bestItem.m_score);
+}
+
+void ParallelTopNTest::InternalTopNTest(size_t itemCount, size_t topN, size_t threadCount) {
+    vector<FakeItem> itemsVec, topNItemsVec;
+    FakeItemMgr::sGenItems(itemCount, itemCount, itemsVec);
+    FakeItemComparator itemComparator;
+    ParallelTopN<FakeItem, FakeItemComparator> topNItems(topN, threadCount);
+    topNItems.Run(itemsVec.begin(), itemsVec.end(), topNItemsVec);
+
+    vector<FakeItem> allItemsVec(itemsVec);
+    std::sort(allItemsVec.begin(), allItemsVec.end(), itemComparator);
+    size_t realTopN = std::min(topN, itemCount);
+    CPPUNIT_ASSERT_EQUAL(realTopN, topNItemsVec.size());
+    for (size_t i = 0; i < realTopN; ++i) {
+        CPPUNIT_ASSERT(allItemsVec[i] == topNItemsVec[i]);
+    }
+
+    vector<uint64_t> scoresVec, topNScoresVec;
+    FakeItemMgr::sGenScores(itemCount, scoresVec);
+    ParallelTopN<uint64_t, std::greater<uint64_t> > topNScores(topN, threadCount);
+    topNScores.Run(scoresVec.begin(), scoresVec.end(), topNScoresVec);
+    std::sort(scoresVec.begin(), scoresVec.end(), std::greater<uint64_t>());
+    CPPUNIT_ASSERT_EQUAL(realTopN, topNScoresVec.size());
+    for (size_t i = 0; i < realTopN; ++i) {
+        CPPUNIT_ASSERT_EQUAL(scoresVec[i], topNScoresVec[i]);
+    }
+}
+
+void ParallelTopNTest::TopNTest() {
+    size_t threadCounts[] = {1, 2, 3, 4, 8};
+    for (size_t threadCount : threadCounts) {
+        InternalTopNTest(1e5, 100, threadCount);
+        InternalTopNTest(2e4, 1000, threadCount);
+        InternalTopNTest(5e3, 1, threadCount);
+        InternalTopNTest(500, 1000, threadCount);
+        InternalTopNTest(0, 10, threadCount);
+    }
+}
+
+void ParallelTopNTest::ScalingPerformanceTest() {
+    size_t scoreCount = 1e7, topN = 1000;
+    vector<uint64_t> scoresVec, topNScoresVec, expectTopNScoresVec;
+    FakeItemMgr::sGenScores(scoreCount, scoresVec);
+    size_t maxThreadCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    for (size_t threadCount = 1; ; threadCount *= 2) {
+        threadCount = std::min(threadCount, maxThreadCount);
+        ParallelTopN<uint64_t, std::greater<uint64_t> > topNScores(topN, threadCount);
+        int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+        topNScores.Run(scoresVec.begin(), scoresVec.end(), topNScoresVec);
+        int64_t tEnd = TimeUtil::CurrentTimeInMicroSeconds();
+        cout << "-------------scoreCount:[" << scoreCount << "],topN:[" << topN << "],threadCount:[" << threadCount
+             << "],consumed time:[" << (tEnd - tBegin) / 1000 << "]ms." << endl;
+        if (expectTopNScoresVec.empty()) {
+            expectTopNScoresVec = topNScoresVec;
+        }
+        CPPUNIT_ASSERT(expectTopNScoresVec == topNScoresVec);
+        if (threadCount == maxThreadCount) {
+            break;
+        }
+    }
+}
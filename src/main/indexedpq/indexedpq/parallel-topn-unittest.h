@@ -0,0 +1,29 @@
+#ifndef __INDEXEDPQ_TEST_PARALLEL_TOPN_UNITTEST_H__
+#define __INDEXEDPQ_TEST_PARALLEL_TOPN_UNITTEST_H__
+
+#include "indexedpq/parallel-topn.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+class ParallelTopNTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(ParallelTopNTest);
+    CPPUNIT_TEST(SharedThresholdTest);
+    CPPUNIT_TEST(TopNTest);
+    CPPUNIT_TEST(ScalingPerformanceTest);
+    CPPUNIT_TEST_SUITE_END();
+public:
+    ParallelTopNTest() {}
+    ~ParallelTopNTest() {}
+    void setUp() {}
+    void tearDown() {}
+public:
+
+    void SharedThresholdTest();
+    void TopNTest();
+    void ScalingPerformanceTest();
+
+private:
+    void InternalTopNTest(size_t itemCount, size_t topN, size_t threadCount);
+};
+
+
+#endif //__INDEXEDPQ_TEST_PARALLEL_TOPN_UNITTEST_H__
@@ -0,0 +1,216 @@
+#ifndef __INDEXEDPQ_PARALLEL_TOPN_H__
+#define __INDEXEDPQ_PARALLEL_TOPN_H__
+
+#include "indexedpq/indexed-priority-queue.h"
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/// whether std::atomic<T> is always lock free, false for types which can not be atomic.
+template <class T, bool = std::is_trivially_copyable<T>::value>
+struct IndexedPQIsAtomicLockFree : public std::false_type {};
+template <class T>
+struct IndexedPQIsAtomicLockFree<T, true> : public std::integral_constant<bool, std::atomic<T>::is_always_lock_free> {};
+
+/**
+ *@brief     threshold shared by TopN workers. Once a worker's fixed queue is full, its top element bounds the global
+ *           TopN, because the worker already holds N better elements. The best published bound is kept, and any
+ *           element not better than it can be dropped by every worker. Lock-free std::atomic is used if T allows,
+ *           otherwise a mutex guards the value.
+ */
+template <class T, class CompareFunc, bool IsLockFree = IndexedPQIsAtomicLockFree<T>::value>
+class IndexedPQSharedThreshold
+{
+public:
+    IndexedPQSharedThreshold(CompareFunc compareFunc) : m_hasValue(false), m_valueCmpFunc(compareFunc) {}
+
+    /// publish a worker's bound *value*, keep it if it is better than the current one
+    void Publish(const T& value) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_hasValue.load(std::memory_order_relaxed) || m_valueCmpFunc(value, m_value)) {
+            m_value = value;
+            m_hasValue.store(true, std::memory_order_release);
+        }
+    }
+    /// read current bound into *value*, return false if nothing published
+    bool Get(T& value) {
+        if (!m_hasValue.load(std::memory_order_acquire)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        value = m_value;
+        return true;
+    }
+private:
+    std::mutex            m_mutex;
+    std::atomic<bool>     m_hasValue;
+    T                     m_value;
+    CompareFunc           m_valueCmpFunc;
+};
+
+template <class T, class CompareFunc>
+class IndexedPQSharedThreshold<T, CompareFunc, true>
+{
+public:
+    IndexedPQSharedThreshold(CompareFunc compareFunc) : m_hasValue(false), m_valueCmpFunc(compareFunc) {}
+
+    void Publish(const T& value) {
+        if (!m_hasValue.load(std::memory_order_acquire)) {
+            bool expected = false;
+            /// the first publisher stores its value, the others fall through to CAS loop
+            if (m_isInited.compare_exchange_strong(expected, true)) {
+                m_value.store(value, std::memory_order_relaxed);
+                m_hasValue.store(true, std::memory_order_release);
+                return;
+            }
+            while (!m_hasValue.load(std::memory_order_acquire)) { std::this_thread::yield(); }
+        }
+        T cur = m_value.load(std::memory_order_relaxed);
+        while (m_valueCmpFunc(value, cur) && !m_value.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {}
+    }
+    bool Get(T& value) {
+        if (!m_hasValue.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = m_value.load(std::memory_order_relaxed);
+        return true;
+    }
+private:
+    std::atomic<bool>     m_isInited{false};
+    std::atomic<bool>     m_hasValue;
+    std::atomic<T>        m_value;
+    CompareFunc           m_valueCmpFunc;
+};
+
+
+/**
+ *@brief     parallel TopN driver. Input is split into one contiguous partition per thread, every thread scans its
+ *           partition with its own fixed IndexedPriorityQueue and prunes elements by a shared threshold derived from
+ *           *IsNotNeedPushWhenSeekFixedTopN*. After all threads finished, the sorted per-thread results are k-way merged
+ *           by the calling thread without any lock.
+ *           *CompareFunc(a, b)* is true if *a* ranks before *b*, same as fixed IndexedPriorityQueue.
+ */
+template <class T, class CompareFunc, class Policy = IndexedPQDefaultPolicy >
+class ParallelTopN
+{
+public:
+    typedef IndexedPriorityQueue<T, CompareFunc, Policy>    QUEUE_TYPE;
+    typedef typename QUEUE_TYPE::HANDLE_TYPE                HANDLE_TYPE;
+
+    static constexpr size_t SYNC_INTERVAL = 1024;           /// elements scanned between two threshold synchronizations
+
+public:
+    ParallelTopN(size_t topN, size_t threadCount = std::thread::hardware_concurrency(), CompareFunc compareFunc = CompareFunc())
+        : m_topN(std::max<size_t>(topN, 1)), m_threadCount(std::max<size_t>(threadCount, 1)), m_valueCmpFunc(compareFunc) {}
+
+    /**
+     *@brief     compute TopN of [first,last)
+     *@param     first,last --- random access iterators range of elements.
+     *@param     result --- TopN elements in rank order, best first.
+     */
+    template<class RandomIt>
+    void Run(RandomIt first, RandomIt last, std::vector<T>& result);
+
+private:
+    template<class RandomIt>
+    void ScanPartition(RandomIt first, RandomIt last, IndexedPQSharedThreshold<T, CompareFunc>& threshold,
+                       std::vector<T>& sortedElems);
+    void Merge(std::vector<std::vector<T> >& sortedElemsVec, std::vector<T>& result);
+
+private:
+    size_t                m_topN;
+    size_t                m_threadCount;
+    CompareFunc           m_valueCmpFunc;
+};
+
+template <class T, class CompareFunc, class Policy>
+template <class RandomIt>
+void ParallelTopN<T, CompareFunc, Policy>::Run(RandomIt first, RandomIt last, std::vector<T>& result) {
+    size_t count = std::distance(first, last);
+    size_t threadCount = std::min(m_threadCount, std::max<size_t>(count / SYNC_INTERVAL, 1));
+    IndexedPQSharedThreshold<T, CompareFunc> threshold(m_valueCmpFunc);
+    std::vector<std::vector<T> > sortedElemsVec(threadCount);
+    std::vector<std::thread> threads;
+    size_t partitionSize = count / threadCount;
+    for (size_t i = 0; i < threadCount; ++i) {
+        RandomIt partitionBegin = first + i * partitionSize;
+        RandomIt partitionEnd = (i + 1 == threadCount) ? last : partitionBegin + partitionSize;
+        if (i + 1 == threadCount) {
+            /// current thread scans the last partition
+            ScanPartition(partitionBegin, partitionEnd, threshold, sortedElemsVec[i]);
+        }
+        else {
+            threads.emplace_back([this, partitionBegin, partitionEnd, &threshold, &sortedElemsVec, i]() {
+                ScanPartition(partitionBegin, partitionEnd, threshold, sortedElemsVec[i]);
+            });
+        }
+    }
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+    Merge(sortedElemsVec, result);
+}
+
+template <class T, class CompareFunc, class Policy>
+template <class RandomIt>
+void ParallelTopN<T, CompareFunc, Policy>::ScanPartition(RandomIt first, RandomIt last,
+                                                          IndexedPQSharedThreshold<T, CompareFunc>& threshold,
+                                                          std::vector<T>& sortedElems) {
+    QUEUE_TYPE queue(m_topN, 1, true, m_valueCmpFunc);
+    T bound;
+    bool hasBound = false;
+    while (first != last) {
+        RandomIt batchEnd = (size_t)(last - first) > SYNC_INTERVAL ? first + SYNC_INTERVAL : last;
+        for (; first != batchEnd; ++first) {
+            if (hasBound && m_valueCmpFunc(bound, *first)) {
+                continue;
+            }
+            if (queue.IsNotNeedPushWhenSeekFixedTopN(*first)) {
+                continue;
+            }
+            queue.Push(*first);
+        }
+        if (queue.IsFull()) {
+            threshold.Publish(queue.TopElem());
+        }
+        hasBound = threshold.Get(bound);
+    }
+
+    sortedElems.clear();
+    HANDLE_TYPE* pSortedHts = queue.ReverseSort();
+    for (size_t i = 0; i < queue.GetCount(); ++i) {
+        sortedElems.push_back(queue.Elem(pSortedHts[i]));
+    }
+}
+
+template <class T, class CompareFunc, class Policy>
+void ParallelTopN<T, CompareFunc, Policy>::Merge(std::vector<std::vector<T> >& sortedElemsVec, std::vector<T>& result) {
+    result.clear();
+    /// cursors heap, top is the partition whose current element ranks first
+    std::vector<size_t> cursors(sortedElemsVec.size(), 0);
+    auto cursorCmp = [&](size_t a, size_t b) {
+        return m_valueCmpFunc(sortedElemsVec[b][cursors[b]], sortedElemsVec[a][cursors[a]]);
+    };
+    std::vector<size_t> heap;
+    for (size_t i = 0; i < sortedElemsVec.size(); ++i) {
+        if (!sortedElemsVec[i].empty()) { heap.push_back(i); }
+    }
+    std::make_heap(heap.begin(), heap.end(), cursorCmp);
+    while (!heap.empty() && result.size() < m_topN) {
+        std::pop_heap(heap.begin(), heap.end(), cursorCmp);
+        size_t i = heap.back();
+        result.push_back(sortedElemsVec[i][cursors[i]]);
+        if (++cursors[i] < sortedElemsVec[i].size()) {
+            std::push_heap(heap.begin(), heap.end(), cursorCmp);
+        }
+        else {
+            heap.pop_back();
+        }
+    }
+}
+
+#endif //__INDEXEDPQ_PARALLEL_TOPN_H__
@@ -0,0 +1,159 @@
+#include "indexedpq/static-indexed-priority-queue-unittest.h"
+#include "indexedpq/indexed-priority-queue-unittest.h"
+#include <cppunit/TestAssert.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+using namespace std;
+CPPUNIT_TEST_SUITE_REGISTRATION(StaticIndexedPriorityQueueTest);
+
+namespace {
+/// the 3 smallest of some elements, i.e. the top of MaxTop fixed queue is the 3rd smallest, in a constant expression
+constexpr int ThirdSmallest() {
+    StaticIndexedPriorityQueue<int, 3> pq;
+    int elems[] = {9, 4, 7, 1, 8, 3, 6};
+    for (int elem : elems) { pq.Push(elem); }
+    return pq.TopElem();
+}
+constexpr int UpdatedTop() {
+    StaticIndexedPriorityQueue<int, 4, std::greater<int>, false> pq;
+    auto ht = pq.Push(5);
+    pq.Push(7);
+    pq.Push(9);
+    pq.Update(ht, 10);
+    pq.Pop();
+    return pq.TopElem();
+}
+static_assert(ThirdSmallest() == 4, "constexpr TopN");
+static_assert(UpdatedTop() == 9, "constexpr Update and Pop");
+static_assert(sizeof(StaticIndexedPriorityQueue<int, 10>::HANDLE_TYPE) == 1, "smallest handle type");
+static_assert(sizeof(StaticIndexedPriorityQueue<int, 1000>::HANDLE_TYPE) == 2, "smallest handle type");
+}
+
+void StaticIndexedPriorityQueueTest::NormalTest() {
+    typedef StaticIndexedPriorityQueue<int, 4, std::greater<int>, false> QUEUE_TYPE;
+    QUEUE_TYPE pq;
+    CPPUNIT_ASSERT(pq.IsEmpty());
+    QUEUE_TYPE::HANDLE_TYPE ht5 = pq.Push(5);
+    QUEUE_TYPE::HANDLE_TYPE ht3 = pq.Push(3);
+    pq.Push(8);
+    pq.Push(6);
+    CPPUNIT_ASSERT(pq.IsFull());
+    /// not fixed, full queue rejects
+    CPPUNIT_ASSERT(QUEUE_TYPE::INVALID_HANDLE == pq.Push(1));
+    CPPUNIT_ASSERT_EQUAL(3, pq.TopElem());
+    CPPUNIT_ASSERT(ht3 == pq.Top());
+
+    pq.Update(ht5, 2);
+    CPPUNIT_ASSERT_EQUAL(2, pq.TopElem());
+    int removed = 0;
+    CPPUNIT_ASSERT(pq.Remove(ht5, &removed));
+    CPPUNIT_ASSERT_EQUAL(2, removed);
+    CPPUNIT_ASSERT(!pq.Contains(ht5));
+    CPPUNIT_ASSERT(!pq.Remove(ht5));
+    CPPUNIT_ASSERT(ht3 == pq.Pop());
+    CPPUNIT_ASSERT_EQUAL((size_t)2, pq.GetCount());
+    /// handles are recycled
+    QUEUE_TYPE::HANDLE_TYPE ht = pq.Push(7);
+    CPPUNIT_ASSERT(ht == ht3 || ht == ht5);
+    CPPUNIT_ASSERT_EQUAL(6, pq.TopElem());
+    CPPUNIT_ASSERT(pq.IsHeap());
+
+    /// copied as a value
+    QUEUE_TYPE copied = pq;
+    copied.Pop();
+    CPPUNIT_ASSERT_EQUAL(6, pq.TopElem());
+    CPPUNIT_ASSERT_EQUAL(7, copied.TopElem());
+
+    /// fixed TopN keeps the largest ones with MinTop
+    StaticIndexedPriorityQueue<int, 3, std::greater<int> > topN;
+    int replaced = 0;
+    for (int elem : {4, 1, 9, 2, 7}) {
+        if (!topN.IsNotNeedPushWhenSeekFixedTopN(elem)) {
+            topN.Push(elem, &replaced);
+        }
+    }
+    CPPUNIT_ASSERT_EQUAL(4, topN.TopElem());
+    CPPUNIT_ASSERT_EQUAL(2, replaced);
+    topN.ReplaceTopElem(8);
+    CPPUNIT_ASSERT_EQUAL(7, topN.TopElem());
+    topN.Reset();
+    CPPUNIT_ASSERT(topN.IsEmpty());
+}
+
+void StaticIndexedPriorityQueueTest::RandomOpsTest() {
+    /// against IndexedPriorityQueue with the same operations
+    typedef StaticIndexedPriorityQueue<int64_t, 100, std::less<int64_t>, false> QUEUE_TYPE;
+    QUEUE_TYPE pq;
+    IndexedPriorityQueue<int64_t> refPq(100);
+    map<size_t, size_t> ht2RefHt;
+    for (size_t i = 0; i < 100000; ++i) {
+        int64_t op = RandomUtil<int64_t>::RandomInt64(0, 9);
+        int64_t elem = RandomUtil<int64_t>::RandomInt64(0, 1000);
+        if (op < 4) {
+            QUEUE_TYPE::HANDLE_TYPE ht = pq.Push(elem);
+            CPPUNIT_ASSERT_EQUAL(refPq.GetCount() == 100, ht == QUEUE_TYPE::INVALID_HANDLE);
+            if (ht != QUEUE_TYPE::INVALID_HANDLE) {
+                ht2RefHt[ht] = refPq.Push(elem);
+            }
+        }
+        else if (op < 7 && !ht2RefHt.empty()) {
+            auto it = ht2RefHt.begin();
+            std::advance(it, RandomUtil<int64_t>::RandomInt64(0, ht2RefHt.size() - 1));
+            pq.Update(it->first, elem);
+            refPq.Update(it->second, elem);
+        }
+        else if (op < 8 && !ht2RefHt.empty()) {
+            auto it = ht2RefHt.begin();
+            std::advance(it, RandomUtil<int64_t>::RandomInt64(0, ht2RefHt.size() - 1));
+            CPPUNIT_ASSERT(pq.Remove(it->first));
+            refPq.Remove(it->second);
+            ht2RefHt.erase(it);
+        }
+        else if (!pq.IsEmpty()) {
+            CPPUNIT_ASSERT_EQUAL(refPq.TopElem(), pq.TopElem());
+            ht2RefHt.erase(pq.Pop());
+            refPq.Pop();
+        }
+        CPPUNIT_ASSERT_EQUAL(refPq.GetCount(), pq.GetCount());
+        if (!pq.IsEmpty()) {
+            CPPUNIT_ASSERT_EQUAL(refPq.TopElem(), pq.TopElem());
+        }
+    }
+    CPPUNIT_ASSERT(pq.IsHeap());
+}
+
+void StaticIndexedPriorityQueueTest::PerformanceTest() {
+    /// many tiny TopN queues of a request each, against fixed IndexedPriorityQueue allocating its arrays per query
+    const size_t topN = 10;
+    size_t queryCount = 2e4, elemCount = 200;
+    vector<int64_t> elems;
+    for (size_t i = 0; i < elemCount * 16; ++i) {
+        elems.push_back(RandomUtil<int64_t>::RandomInt64(0, 1e9));
+    }
+    int64_t staticSum = 0, dynamicSum = 0;
+
+    int64_t tBegin = TimeUtil::CurrentTimeInMicroSeconds();
+    for (size_t q = 0; q < queryCount; ++q) {
+        StaticIndexedPriorityQueue<int64_t, topN> pq;
+        size_t offset = q % 16 * elemCount;
+        for (size_t i = 0; i < elemCount; ++i) {
+            if (!pq.IsNotNeedPushWhenSeekFixedTopN(elems[offset + i])) { pq.Push(elems[offset + i]); }
+        }
+        staticSum += pq.TopElem();
+    }
+    int64_t tStatic = TimeUtil::CurrentTimeInMicroSeconds();
+    for (size_t q = 0; q < queryCount; ++q) {
+        IndexedPriorityQueue<int64_t> pq(topN, 1, true);
+        size_t offset = q % 16 * elemCount;
+        for (size_t i = 0; i < elemCount; ++i) {
+            if (!pq.IsNotNeedPushWhenSeekFixedTopN(elems[offset + i])) { pq.Push(elems[offset + i]); }
+        }
+        dynamicSum += pq.TopElem();
+    }
+    int64_t tDynamic = TimeUtil::CurrentTimeInMicroSeconds();
+    cout << "-------------queryCount:[" << queryCount << "],topN:[" << topN << "],static:["
+         << (tStatic - tBegin) / 1000 << "]ms,dynamic:[" << (tDynamic - tStatic) / 1000 << "]ms." << endl;
+    CPPUNIT_ASSERT_EQUAL(dynamicSum, staticSum);
+}
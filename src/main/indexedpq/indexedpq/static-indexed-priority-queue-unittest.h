@@ -0,0 +1,26 @@
+#ifndef __INDEXEDPQ_TEST_STATIC_INDEXED_PRIORITY_QUEUE_UNITTEST_H__
+#define __INDEXEDPQ_TEST_STATIC_INDEXED_PRIORITY_QUEUE_UNITTEST_H__
+
+#include "indexedpq/static-indexed-priority-queue.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+class StaticIndexedPriorityQueueTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(StaticIndexedPriorityQueueTest);
+    CPPUNIT_TEST(NormalTest);
+    CPPUNIT_TEST(RandomOpsTest);
+    CPPUNIT_TEST(PerformanceTest);
+    CPPUNIT_TEST_SUITE_END();
+public:
+    StaticIndexedPriorityQueueTest() {}
+    ~StaticIndexedPriorityQueueTest() {}
+    void setUp() {}
+    void tearDown() {}
+public:
+
+    void NormalTest();
+    void RandomOpsTest();
+    void PerformanceTest();
+};
+
+
+#endif //__INDEXEDPQ_TEST_STATIC_INDEXED_PRIORITY_QUEUE_UNITTEST_H__
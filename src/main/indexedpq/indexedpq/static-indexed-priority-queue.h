@@ -0,0 +1,199 @@
+#ifndef __INDEXEDPQ_STATIC_INDEXED_PRIORITY_QUEUE_H__
+#define __INDEXEDPQ_STATIC_INDEXED_PRIORITY_QUEUE_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+/**
+ *@brief     IndexedPriorityQueue of capacity *N* known at compile time, for tiny TopN on the stack or in per-thread
+ *           object pools. All arrays are inline std::array members, so it never allocates and is copied as a value.
+ *           Heap direction is the type of *CompareFunc*, e.g. std::less<T> for MaxTop and std::greater<T> for MinTop,
+ *           so comparisons do not branch on a runtime flag as IndexedPQComparator does. All operations are constexpr,
+ *           a queue may be built and queried in constant expressions.
+ *           It is a binary heap of the same handle semantic as IndexedPriorityQueue: handles are stable until
+ *           *Pop* or *Remove*, then recycled. Handle type is the smallest unsigned integer holding *N*.
+ *           If *IS_FIXED* is true, *Push* to a full queue keeps the best *N* elements as fixed IndexedPQ does,
+ *           otherwise it fails with INVALID_HANDLE. *T* must be default constructible.
+ */
+template <class T, size_t N, class CompareFunc = std::less<T>, bool IS_FIXED = true >
+class StaticIndexedPriorityQueue
+{
+public:
+    typedef T             VALUE_TYPE;
+    typedef CompareFunc   VALUE_COMPARE;
+    typedef typename std::conditional<(N < UINT8_MAX), uint8_t,
+            typename std::conditional<(N < UINT16_MAX), uint16_t,
+            typename std::conditional<(N < UINT32_MAX), uint32_t, size_t>::type>::type>::type HANDLE_TYPE;
+
+    static constexpr HANDLE_TYPE INVALID_HANDLE = HANDLE_TYPE(-1);
+    static constexpr size_t MAX_COUNT = N;
+    static_assert(N > 0, "capacity of StaticIndexedPriorityQueue must be positive");
+
+public:
+    constexpr StaticIndexedPriorityQueue(VALUE_COMPARE compareFunc = VALUE_COMPARE())
+        : m_elemArr(), m_heapArr(), m_elemIndex2HeapIndexArr(), m_poppedHandleTypeArr(), m_elemCnt(0),
+          m_poppedHandleTypeElemCount(0), m_usedHandleCnt(0), m_valueCmpFunc(compareFunc) {}
+
+    constexpr size_t      GetCount() const { return m_elemCnt; }
+    constexpr bool        IsEmpty() const { return m_elemCnt == 0; }
+    constexpr bool        IsFull() const { return m_elemCnt == N; }
+    static constexpr size_t GetCapacity() { return N; }
+
+    /// whether element of handle *ht* is in the queue
+    constexpr bool Contains(HANDLE_TYPE ht) const {
+        return ht < m_usedHandleCnt && m_elemIndex2HeapIndexArr[ht] < m_elemCnt && m_heapArr[m_elemIndex2HeapIndexArr[ht]] == ht;
+    }
+    constexpr const T& Elem(HANDLE_TYPE ht) const { return m_elemArr[ht]; }
+    /// element at heap index in [0,GetCount()), to iterate all elements unsorted
+    constexpr const T& ElemAtHeap(size_t index) const { return m_elemArr[m_heapArr[index]]; }
+    constexpr const HANDLE_TYPE* GetElementsArray() const { return m_heapArr.data(); }
+
+    constexpr const T& TopElem() const { return m_elemArr[m_heapArr[0]]; }
+    constexpr HANDLE_TYPE Top() const { return m_heapArr[0]; }
+
+    /// whether *elem* would be rejected by a full fixed queue
+    constexpr bool IsNotNeedPushWhenSeekFixedTopN(const T& elem) const {
+        return IS_FIXED && IsFull() && m_valueCmpFunc(TopElem(), elem);
+    }
+
+    constexpr void Reset() { m_elemCnt = 0; m_poppedHandleTypeElemCount = 0; m_usedHandleCnt = 0; }
+
+    /**
+     *@brief     push *elem*, the replaced top element of a full fixed queue is moved to *pRemovedElem* if it is not null.
+     *@return    handle of *elem*, INVALID_HANDLE if it is not pushed.
+     */
+    constexpr HANDLE_TYPE Push(const T& elem, T* pRemovedElem = nullptr) { return PushElem(elem, pRemovedElem); }
+    constexpr HANDLE_TYPE Push(T&& elem, T* pRemovedElem = nullptr) { return PushElem(std::move(elem), pRemovedElem); }
+
+    /// pop top element and recycle its handle, which is returned
+    constexpr HANDLE_TYPE Pop() {
+        HANDLE_TYPE ht = m_heapArr[0];
+        RemoveAt(0);
+        return ht;
+    }
+
+    /// remove element of handle *ht*, return false if it is not in the queue
+    constexpr bool Remove(HANDLE_TYPE ht, T* pRemovedElem = nullptr) {
+        if (!Contains(ht)) {
+            return false;
+        }
+        if (nullptr != pRemovedElem) { *pRemovedElem = std::move(m_elemArr[ht]); }
+        RemoveAt(m_elemIndex2HeapIndexArr[ht]);
+        return true;
+    }
+
+    /// change element of handle *ht* to *newElem*, return *ht*
+    constexpr HANDLE_TYPE Update(HANDLE_TYPE ht, const T& newElem) { return UpdateElem(ht, newElem); }
+    constexpr HANDLE_TYPE Update(HANDLE_TYPE ht, T&& newElem) { return UpdateElem(ht, std::move(newElem)); }
+
+    /// replace top element, return its handle
+    constexpr HANDLE_TYPE ReplaceTopElem(const T& newElem) { return ReplaceTopElemImpl(newElem); }
+    constexpr HANDLE_TYPE ReplaceTopElem(T&& newElem) { return ReplaceTopElemImpl(std::move(newElem)); }
+
+    constexpr bool IsHeap() const {
+        for (size_t i = 1; i < m_elemCnt; ++i) {
+            if (m_valueCmpFunc(ElemAtHeap((i - 1) / 2), ElemAtHeap(i))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    template<class U>
+    constexpr HANDLE_TYPE PushElem(U&& elem, T* pRemovedElem) {
+        if (IsFull()) {
+            if (IS_FIXED && m_valueCmpFunc(elem, TopElem())) {
+                if (nullptr != pRemovedElem) { *pRemovedElem = std::move(m_elemArr[m_heapArr[0]]); }
+                return ReplaceTopElemImpl(std::forward<U>(elem));
+            }
+            return INVALID_HANDLE;
+        }
+        HANDLE_TYPE ht = m_poppedHandleTypeElemCount > 0 ? m_poppedHandleTypeArr[--m_poppedHandleTypeElemCount]
+                                                         : HANDLE_TYPE(m_usedHandleCnt++);
+        m_elemArr[ht] = std::forward<U>(elem);
+        m_heapArr[m_elemCnt] = ht;
+        m_elemIndex2HeapIndexArr[ht] = HANDLE_TYPE(m_elemCnt);
+        AdjustUpward(m_elemCnt++);
+        return ht;
+    }
+    template<class U>
+    constexpr HANDLE_TYPE UpdateElem(HANDLE_TYPE ht, U&& newElem) {
+        bool isDownward = m_valueCmpFunc(newElem, m_elemArr[ht]);
+        m_elemArr[ht] = std::forward<U>(newElem);
+        size_t nIndex = m_elemIndex2HeapIndexArr[ht];
+        isDownward ? AdjustDownward(nIndex) : AdjustUpward(nIndex);
+        return ht;
+    }
+    template<class U>
+    constexpr HANDLE_TYPE ReplaceTopElemImpl(U&& newElem) {
+        HANDLE_TYPE ht = m_heapArr[0];
+        m_elemArr[ht] = std::forward<U>(newElem);
+        AdjustDownward(0);
+        return ht;
+    }
+    /// remove element at heap index *nIndex*, the last one fills the hole and may go upwards or downwards
+    constexpr void RemoveAt(size_t nIndex) {
+        m_poppedHandleTypeArr[m_poppedHandleTypeElemCount++] = m_heapArr[nIndex];
+        if (nIndex == --m_elemCnt) {
+            return;
+        }
+        SetHeapAt(nIndex, m_heapArr[m_elemCnt]);
+        if (nIndex > 0 && m_valueCmpFunc(ElemAtHeap((nIndex - 1) / 2), ElemAtHeap(nIndex))) {
+            AdjustUpward(nIndex);
+        }
+        else {
+            AdjustDownward(nIndex);
+        }
+    }
+    constexpr void SetHeapAt(size_t nIndex, HANDLE_TYPE ht) {
+        m_heapArr[nIndex] = ht;
+        m_elemIndex2HeapIndexArr[ht] = HANDLE_TYPE(nIndex);
+    }
+    constexpr void AdjustUpward(size_t nIndex) {
+        HANDLE_TYPE curHt = m_heapArr[nIndex];
+        while (nIndex > 0) {
+            size_t nUp = (nIndex - 1) / 2;
+            if (!m_valueCmpFunc(m_elemArr[m_heapArr[nUp]], m_elemArr[curHt])) {
+                break;
+            }
+            SetHeapAt(nIndex, m_heapArr[nUp]);
+            nIndex = nUp;
+        }
+        SetHeapAt(nIndex, curHt);
+    }
+    constexpr void AdjustDownward(size_t nIndex) {
+        HANDLE_TYPE curHt = m_heapArr[nIndex];
+        while (true) {
+            size_t nDown = 2 * nIndex + 1;
+            if (nDown >= m_elemCnt) {
+                break;
+            }
+            if (nDown + 1 < m_elemCnt && m_valueCmpFunc(m_elemArr[m_heapArr[nDown]], m_elemArr[m_heapArr[nDown + 1]])) {
+                ++nDown;
+            }
+            if (!m_valueCmpFunc(m_elemArr[curHt], m_elemArr[m_heapArr[nDown]])) {
+                break;
+            }
+            SetHeapAt(nIndex, m_heapArr[nDown]);
+            nIndex = nDown;
+        }
+        SetHeapAt(nIndex, curHt);
+    }
+
+private:
+    std::array<T, N>            m_elemArr;                      /// elements indexed by handle
+    std::array<HANDLE_TYPE, N>  m_heapArr;                      /// handles in heap order
+    std::array<HANDLE_TYPE, N>  m_elemIndex2HeapIndexArr;       /// handle to heap index
+    std::array<HANDLE_TYPE, N>  m_poppedHandleTypeArr;          /// recycled handles
+    size_t                      m_elemCnt;
+    size_t                      m_poppedHandleTypeElemCount;
+    size_t                      m_usedHandleCnt;                /// handles in [0,m_usedHandleCnt) have been used
+    VALUE_COMPARE               m_valueCmpFunc;
+};
+
+#endif //__INDEXEDPQ_STATIC_INDEXED_PRIORITY_QUEUE_H__